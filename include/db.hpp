@@ -1,6 +1,7 @@
 #pragma once
 
 #include "./db/connection.hpp"
+#include "./db/executor.hpp"
 #include "./db/orm-repository.hpp"
 #include "./db/orm.hpp"
 #include "./db/pool.hpp"
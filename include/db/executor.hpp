@@ -0,0 +1,143 @@
+#pragma once
+
+#include "./connection.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace db {
+// runs blocking database work on its own pool of threads instead of the caller's event loop.
+// every worker opens one connection up front and keeps it, work posted with the same affinity always lands on the same
+// worker (and therefore the same connection), work without affinity goes to whichever worker is idle first.
+class executor {
+public:
+  static constexpr size_t any = SIZE_MAX;
+
+  struct statistics {
+    size_t queued = 0;
+    size_t running = 0;
+    uint64_t completed = 0;
+    // time between post() and a worker picking the work up
+    std::chrono::nanoseconds wait_time{0};
+    std::chrono::nanoseconds max_wait_time{0};
+  };
+
+  // runs `work` on a worker once awaited, the awaiting coroutine is continued through the executor's `resume` function
+  template <typename T, typename F>
+  struct awaiter {
+    using value_type = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+    executor& self;
+    F work;
+    size_t affinity;
+
+    awaiter(executor& e, F w, size_t a) : self(e), work(std::move(w)), affinity(a) {
+    }
+
+    bool await_ready() const noexcept {
+      return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> waiter) {
+      self.post(
+          [this, waiter](db::connection& conn) {
+            try {
+              if constexpr (std::is_void_v<T>) {
+                work(conn);
+                _value.emplace();
+              } else {
+                _value.emplace(work(conn));
+              }
+            } catch (...) {
+              _error = std::current_exception();
+            }
+
+            self.resume(waiter);
+          },
+          affinity);
+    }
+
+    T await_resume() {
+      if (_error) {
+        std::rethrow_exception(_error);
+      }
+
+      if constexpr (!std::is_void_v<T>) {
+        return std::move(*_value);
+      }
+    }
+
+  private:
+    std::optional<value_type> _value;
+    std::exception_ptr _error;
+  };
+
+  // `resume` decides where awaiting coroutines continue, usually by handing them back to their event loop (see
+  // uv::resume_queue). it is called on the worker thread and is required, a coroutine continued on the worker would
+  // run the caller's code (and touch its loop) from there
+  executor(db::datasource& dsrc, size_t thread_count, std::function<void(std::coroutine_handle<>)> resume);
+
+  executor(const executor&) = delete;
+
+  executor& operator=(const executor&) = delete;
+
+  ~executor();
+
+  // `work` runs on a worker thread and may not throw
+  void post(std::function<void(db::connection&)> work, size_t affinity = any);
+
+  // `co_await executor.run([](db::connection& conn) { ... })`
+  template <typename F>
+  awaiter<std::invoke_result_t<F&, db::connection&>, F> run(F work, size_t affinity = any) {
+    return {*this, std::move(work), affinity};
+  }
+
+  // finishes the queued work, joins all workers and closes their connections
+  void stop();
+
+  size_t size() const noexcept;
+
+  db::datasource& datasource() noexcept;
+
+  executor::statistics stats() const;
+
+private:
+  struct job {
+    std::function<void(db::connection&)> work;
+    std::chrono::steady_clock::time_point posted;
+  };
+
+  struct worker {
+    std::deque<job> queue;
+    std::optional<db::connection> conn;
+    std::thread thread;
+  };
+
+  db::datasource& _dsrc;
+  std::function<void(std::coroutine_handle<>)> _resume;
+
+  std::vector<std::unique_ptr<worker>> _workers;
+  std::deque<job> _queue;
+
+  mutable std::mutex _mutex;
+  std::condition_variable _cv;
+  bool _stopping = false;
+
+  executor::statistics _stats;
+
+  void loop(size_t index);
+
+  void resume(std::coroutine_handle<> waiter);
+};
+} // namespace db
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "./connection.hpp"
+#include "./executor.hpp"
 #include "./orm.hpp"
 
 namespace db::orm {
@@ -19,18 +20,26 @@ constexpr void constexpr_for(F&& f) {
 }
 } // namespace detail
 
+class async_repository;
+
 class repository {
 public:
   repository(db::connection& conn);
 
   repository(db::datasource& dsrc);
 
+  // only opens a connection of its own once it is used synchronously
+  repository(db::executor& executor);
+
+  // runs the repository calls on the executor passed to the constructor
+  async_repository async(size_t affinity = db::executor::any);
+
   template <typename T>
   uint64_t count() {
     using meta = db::orm::meta<T>;
     using primary = db::orm::primary<T>;
 
-    db::orm::selector builder{*_conn};
+    db::orm::selector builder{conn()};
     builder.select({"count(*)"}).from<T>();
 
     return builder
@@ -44,7 +53,7 @@ public:
     using meta = db::orm::meta<T>;
     using primary = db::orm::primary<T>;
 
-    db::orm::selector builder{*_conn};
+    db::orm::selector builder{conn()};
     builder.select({"count(*)"}).from<T>().where(std::move(condition));
 
     return builder
@@ -58,7 +67,7 @@ public:
     using meta = db::orm::meta<T>;
     using primary = db::orm::primary<T>;
 
-    db::orm::selector builder{*_conn};
+    db::orm::selector builder{conn()};
     builder.select().from<T>().where(std::move(condition));
 
     auto result = builder
@@ -76,7 +85,7 @@ public:
     using meta = db::orm::meta<T>;
     using primary = db::orm::primary<T>;
 
-    db::orm::selector builder{*_conn};
+    db::orm::selector builder{conn()};
     builder.select().from<T>().where(std::move(condition));
 
     return builder
@@ -88,7 +97,7 @@ public:
     using meta = db::orm::meta<T>;
     using primary = db::orm::primary<T>;
 
-    db::orm::selector builder{*_conn};
+    db::orm::selector builder{conn()};
     builder.select().from<T>();
 
     using field_type = std::tuple_element_t<0, typename primary::tuple_type>;
@@ -107,7 +116,7 @@ public:
     using meta = db::orm::meta<T>;
     using primary = db::orm::primary<T>;
 
-    db::orm::selector builder{*_conn};
+    db::orm::selector builder{conn()};
     builder.select().from<T>().where(std::move(condition));
 
     return builder
@@ -119,7 +128,7 @@ public:
     using meta = db::orm::meta<T>;
     using primary = db::orm::primary<T>;
 
-    db::orm::selector builder{*_conn};
+    db::orm::selector builder{conn()};
     builder.select().from<T>();
 
     constexpr size_t Start = 0;
@@ -172,7 +181,7 @@ public:
 
     // db::statement& statement = _statements_save.at(meta::class_name);
 
-    db::orm::inserter builder{*_conn};
+    db::orm::inserter builder{conn()};
     builder.into<T>();
 
     std::vector<std::string> conflict_fields;
@@ -189,7 +198,7 @@ public:
       builder.set(db::orm::field<std::optional<bool>>{fname.data()} = std::nullopt);
     }
 
-    db::statement statement{*_conn};
+    db::statement statement{conn()};
     builder.prepare(statement);
 
     int i = 666;
@@ -231,7 +240,7 @@ public:
 
     auto id = primary::tie(source);
 
-    db::orm::deleter builder{*_conn};
+    db::orm::deleter builder{conn()};
     builder.from<T>();
 
     constexpr size_t Start = 0;
@@ -288,16 +297,104 @@ public:
   db::orm::deleter remove();
 
   inline operator db::connection&() {
-    return *_conn;
+    return conn();
   }
 
 private:
   std::shared_ptr<db::connection> _conn;
+  db::executor* _executor = nullptr;
+
+  db::connection& conn();
 
   // std::unordered_map<std::string_view, db::statement> _statements_save;
   // std::unordered_map<std::string_view, db::statement> _statements_remove;
 };
 
+// awaitable repository calls running on a db::executor. selections are materialized on the worker because a resultset
+// may not outlive its connection, objects passed by reference have to stay alive until the call was awaited.
+class async_repository {
+public:
+  async_repository(db::executor& executor, size_t affinity = db::executor::any);
+
+  // `co_await repo.async().run([](db::orm::repository& repo) { ... })`
+  template <typename F>
+  auto run(F work) {
+    return _executor.run(
+        [work{std::move(work)}](db::connection& conn) mutable {
+          db::orm::repository repo{conn};
+          return work(repo);
+        },
+        _affinity);
+  }
+
+  template <typename T>
+  auto count() {
+    return run([](repository& repo) {
+      return repo.count<T>();
+    });
+  }
+
+  template <typename T, typename L, condition_operator O, typename R>
+  auto count(db::orm::condition<L, O, R>&& condition) {
+    return run([condition{std::move(condition)}](repository& repo) mutable {
+      return repo.count<T>(std::move(condition));
+    });
+  }
+
+  template <typename T, typename L, condition_operator O, typename R>
+  auto findId(db::orm::condition<L, O, R>&& condition) {
+    return run([condition{std::move(condition)}](repository& repo) mutable {
+      return repo.findId<T>(std::move(condition));
+    });
+  }
+
+  template <typename T, typename L, condition_operator O, typename R>
+  auto findMany(db::orm::condition<L, O, R>&& condition) {
+    return run([condition{std::move(condition)}](repository& repo) mutable {
+      return repo.findMany<T>(std::move(condition)).toVector();
+    });
+  }
+
+  template <typename T>
+  auto findManyById(const std::set<std::tuple_element_t<0, typename db::orm::primary<T>::tuple_type>>& ids) {
+    return run([ids](repository& repo) {
+      return repo.findManyById<T>(ids).toVector();
+    });
+  }
+
+  template <typename T, typename L, condition_operator O, typename R>
+  auto findOne(db::orm::condition<L, O, R>&& condition) {
+    return run([condition{std::move(condition)}](repository& repo) mutable {
+      return repo.findOne<T>(std::move(condition));
+    });
+  }
+
+  template <typename T>
+  auto findOneById(const typename db::orm::primary<T>::tuple_type& id) {
+    return run([id](repository& repo) {
+      return repo.findOneById<T>(id);
+    });
+  }
+
+  template <typename T>
+  auto save(T& source) {
+    return run([&source](repository& repo) {
+      return repo.save(source);
+    });
+  }
+
+  template <typename T>
+  auto remove(T& source) {
+    return run([&source](repository& repo) {
+      return repo.remove(source);
+    });
+  }
+
+private:
+  db::executor& _executor;
+  size_t _affinity;
+};
+
 // template <typename T>
 // struct managed : public std::shared_ptr<T> {
 // public:
@@ -1,6 +1,15 @@
 #pragma once
 
+#include "./headers.hpp"
 #include "http_parser.h"
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <unordered_map>
@@ -78,6 +87,8 @@ constexpr auto NOT_FOUND = status::NOT_FOUND;
 constexpr auto METHOD_NOT_ALLOWED = status::METHOD_NOT_ALLOWED;
 constexpr auto INTERNAL_SERVER_ERROR = status::INTERNAL_SERVER_ERROR;
 
+// the text of the url is kept in one string, its parts are slices of it. the query stays percent-encoded until a
+// parameter is looked up, numbers are parsed straight from it
 struct url {
 public:
   static constexpr bool IN = true;
@@ -97,11 +108,11 @@ public:
 
   url& operator=(url&&) = default;
 
-  const std::string& schema() const;
+  std::string_view schema() const;
 
   url& schema(std::string_view value);
 
-  const std::string& host() const;
+  std::string_view host() const;
 
   url& host(std::string_view value);
 
@@ -109,24 +120,65 @@ public:
 
   url& port(uint16_t value);
 
-  const std::string& path() const;
+  // "/" for urls without a path
+  std::string_view path() const;
 
   url& path(std::string_view value);
 
-  const std::unordered_map<std::string, std::string>& query() const;
+  // without the '?', still percent-encoded
+  std::string_view querystring() const;
+
+  // every parameter decoded, a later one replaces an earlier one of the same name
+  std::unordered_map<std::string, std::string> query() const;
 
   url& query(const std::unordered_map<std::string, std::string>& map);
 
-  std::optional<std::string_view> queryvalue(const std::string& name) const;
+  // calls `cb(name, value)` with the still encoded parameters in order, see decode
+  template <typename F>
+  void queryeach(F&& cb) const {
+    std::string_view query = querystring();
+
+    while (!query.empty()) {
+      size_t end = query.find('&');
+      std::string_view parameter = query.substr(0, end);
+      query = end == std::string_view::npos ? std::string_view{} : query.substr(end + 1);
+
+      if (parameter.empty()) {
+        continue;
+      }
+
+      size_t equals = parameter.find('=');
+      if (equals == std::string_view::npos) {
+        cb(parameter, std::string_view{});
+      } else {
+        cb(parameter.substr(0, equals), parameter.substr(equals + 1));
+      }
+    }
+  }
+
+  // the decoded value of the last parameter called `name`
+  std::optional<std::string> queryvalue(std::string_view name) const;
 
   template <typename R>
-  std::optional<R> queryvalue(const std::string& name) const {
-    std::optional<std::string_view> value = queryvalue(name);
+  std::optional<R> queryvalue(std::string_view name) const {
+    std::optional<std::string_view> value = rawqueryvalue(name);
     if (!value) {
       return std::nullopt;
     }
 
-    std::string_view valuestr = value.value();
+    return queryparse<R>(value.value());
+  }
+
+  url& queryvalue(std::string_view name, std::string_view value);
+
+  // converts a still encoded parameter value, "" and "null" are std::nullopt.
+  // numbers may start with whitespace and a '+' like for std::stoi but have to end with the value. throws
+  // std::invalid_argument for anything else and std::out_of_range for numbers that do not fit `R`, negative ones for
+  // unsigned types included
+  template <typename R>
+  static std::optional<R> queryparse(std::string_view encoded) {
+    std::string storage;
+    std::string_view valuestr = decode(encoded, storage);
     if (valuestr == "" || valuestr == "null") {
       return std::nullopt;
     }
@@ -135,18 +187,41 @@ public:
       return (std::string)valuestr;
     } else if constexpr (std::is_same_v<R, bool>) {
       return (valuestr == "1" || valuestr == "true");
-    } else if constexpr (std::is_integral_v<R>) {
-      return (R)std::stoi((std::string)valuestr);
-    } else if constexpr (std::is_floating_point_v<R>) {
-      return (R)std::stof((std::string)valuestr);
+    } else if constexpr (std::is_integral_v<R> || std::is_floating_point_v<R>) {
+      const char* begin = valuestr.data();
+      const char* end = valuestr.data() + valuestr.length();
+      while (begin != end && std::isspace((unsigned char)*begin)) {
+        begin++;
+      }
+      if (begin != end && *begin == '+') {
+        begin++;
+      }
+      if constexpr (std::is_unsigned_v<R>) {
+        if (begin != end && *begin == '-') {
+          throw std::out_of_range{"number out of range: " + (std::string)valuestr};
+        }
+      }
+
+      R result = {};
+      auto [parsed, error] = std::from_chars(begin, end, result);
+      if (error == std::errc::result_out_of_range) {
+        throw std::out_of_range{"number out of range: " + (std::string)valuestr};
+      }
+      if (error != std::errc{} || parsed != end) {
+        throw std::invalid_argument{"not a number: " + (std::string)valuestr};
+      }
+
+      return result;
     } else {
       return {};
     }
   }
 
-  url& queryvalue(const std::string& name, std::string_view value);
+  // percent-decodes `value` ('+' is a space). the result is `value` itself if nothing had to be decoded and points
+  // into `storage` otherwise
+  static std::string_view decode(std::string_view value, std::string& storage);
 
-  const std::string& fragment() const;
+  std::string_view fragment() const;
 
   url& fragment(std::string_view value);
 
@@ -155,12 +230,26 @@ public:
   explicit operator std::string() const;
 
 private:
-  std::string _schema;
-  std::string _host;
+  struct slice {
+    uint32_t offset = 0;
+    uint32_t length = 0;
+  };
+
+  std::string _data;
+  slice _schema;
+  slice _host;
   uint16_t _port = 0;
-  std::string _path = "/";
-  std::unordered_map<std::string, std::string> _query;
-  std::string _fragment;
+  slice _path;
+  slice _query;
+  slice _fragment;
+
+  std::string_view view(slice s) const;
+
+  // the encoded value of the last parameter called `name`
+  std::optional<std::string_view> rawqueryvalue(std::string_view name) const;
+
+  void assign(std::string_view schema, std::string_view host, std::string_view path, std::string_view query,
+      std::string_view fragment);
 };
 
 struct proxyinfo {
@@ -170,6 +259,52 @@ public:
   std::string auth;
 };
 
+// the body of a request whose handler runs before the body arrived (see http::serve::options::stream_bodies).
+// the connection pushes chunks as they are read and is paused while more than `high_watermark` bytes wait here.
+// it is only valid while the handler runs
+struct body_stream {
+public:
+  struct state {
+    std::deque<std::string> chunks;
+    size_t buffered = 0;
+    size_t high_watermark = 64 * 1024;
+    bool paused = false;
+    bool ended = false;
+    std::exception_ptr error;
+
+    std::function<void(std::optional<std::string>, std::exception_ptr)> waiter;
+    // called with true to pause and with false to resume reading from the connection
+    std::function<void(bool)> flow;
+  };
+
+  body_stream() = default;
+
+  explicit body_stream(std::shared_ptr<state> s);
+
+  // false for bodies that were received in full (see request::body)
+  explicit operator bool() const;
+
+  // the next chunk or std::nullopt once the body ended
+  void next(std::function<void(std::optional<std::string>, std::exception_ptr)> cb);
+
+#ifdef HTTPPP_TASK_INCLUDE
+  HTTPPP_TASK_TYPE<std::optional<std::string>> next();
+
+  HTTPPP_TASK_TYPE<std::string> readAll();
+#endif
+
+  void push(std::string chunk);
+
+  void end();
+
+  void fail(std::exception_ptr error);
+
+  bool ended() const;
+
+private:
+  std::shared_ptr<state> _state;
+};
+
 struct request {
 public:
   std::tuple<uint8_t, uint8_t> version = {1, 1};
@@ -178,34 +313,63 @@ public:
 
   http::url url;
 
-  std::unordered_map<std::string, std::string> headers;
+  http::headers headers;
 
   std::string body;
 
+  http::body_stream body_stream;
+
   proxyinfo proxy;
 
   explicit operator std::string() const;
 
 private:
-  static std::string stringify(const request& r, const std::unordered_map<std::string, std::string>& headers = {});
+  static std::string stringify(const request& r, const http::headers& headers = {});
 };
 
 struct response {
 public:
+  // a region of an open file, sent by the server in place of `body` (see http::serve::file)
+  struct file_body {
+    int fd = -1;
+    uint64_t offset = 0;
+    uint64_t length = 0;
+    // keeps `fd` open until the response was sent
+    std::shared_ptr<void> owner;
+  };
+
   std::tuple<uint8_t, uint8_t> version = {1, 1};
 
   http::status status = http::UNKNOWN;
 
-  std::unordered_map<std::string, std::string> headers;
+  http::headers headers;
 
   std::string body;
 
+  std::optional<file_body> file;
+
+#ifdef HTTPPP_TASK_INCLUDE
+  // produces the body chunk by chunk in place of `body` until it returns std::nullopt. it is only called once the
+  // previous chunk was handed to the connection, which sends it chunked (HTTP/1.1) or as deferred DATA frames (HTTP/2)
+  using body_producer = std::function<HTTPPP_TASK_TYPE<std::optional<std::string>>()>;
+
+  body_producer producer;
+#endif
+
   operator bool() const;
 
   explicit operator std::string() const;
 
+  // status line and headers up to the empty line, operator std::string() appends the body to this.
+  // `date` is sent as the date field unless the response has one (see http::serve::date)
+  std::string head(std::string_view date = {}) const;
+
 private:
-  static std::string stringify(const response& r, const std::unordered_map<std::string, std::string>& headers = {});
+  static std::string stringify(const response& r, const http::headers& headers = {});
+
+  // written in one pass into a string reserved for the head and `reserve_body` more bytes
+  static std::string stringifyHead(
+      const response& r, const http::headers& headers = {}, std::string_view date = {}, size_t reserve_body = 0);
 };
 
 class error : public std::runtime_error {
@@ -221,6 +385,25 @@ private:
 };
 
 namespace serve {
+struct options {
+public:
+  // call the handler once the headers arrived, the body is read through request::body_stream
+  bool stream_bodies = false;
+  // requests with a larger body are answered with 413 and the connection is closed, 0 is unlimited
+  size_t max_body_size = 0;
+  // bytes buffered in a body stream before reading from the connection is paused
+  size_t body_high_watermark = 64 * 1024;
+  // HTTP/1 connections are closed after this many milliseconds without a request head, 0 keeps them open
+  uint64_t keep_alive_timeout = 5000;
+  // HTTP/1 connections are closed after answering this many requests, 0 is unlimited
+  size_t max_requests_per_connection = 0;
+  // bytes of pipelined requests buffered while the previous response is written before reading is paused
+  size_t pipeline_buffer_size = 64 * 1024;
+};
+
+// the current time as an IMF-fixdate for the date field of responses, formatted at most once per second and thread
+std::string_view date();
+
 #ifdef HTTPPP_TASK_INCLUDE
 using handler = std::function<HTTPPP_TASK_TYPE<void>(http::request&, http::response&)>;
 #endif
@@ -3,21 +3,25 @@
 #include "./common.hpp"
 #include "uvpp/tcp.hpp"
 #ifdef HTTPPP_TASK_INCLUDE
+#include "cppcoro/cancellation_token.hpp"
 #include HTTPPP_TASK_INCLUDE
 #endif
 
 namespace http {
 #ifdef HTTPPP_TASK_INCLUDE
-HTTPPP_TASK_TYPE<http::response> fetch(http::request& request, uv::tcp& tcp);
+// once `token` fires (see uv::deadline) the connection is aborted and the fetch fails with cppcoro::operation_cancelled
+HTTPPP_TASK_TYPE<http::response> fetch(http::request& request, uv::tcp& tcp, cppcoro::cancellation_token token = {});
 
-HTTPPP_TASK_TYPE<http::response> fetch(http::request& request);
+HTTPPP_TASK_TYPE<http::response> fetch(http::request& request, cppcoro::cancellation_token token = {});
 
 // HTTPPP_TASK_TYPE<http::response> fetch(const http::request& request);
 
-HTTPPP_TASK_TYPE<http::response> fetch(http_method m, http::url&& u, std::string&& b = {});
+HTTPPP_TASK_TYPE<http::response> fetch(
+    http_method m, http::url&& u, std::string&& b = {}, cppcoro::cancellation_token token = {});
 
-HTTPPP_TASK_TYPE<http::response> fetch(http_method m, http::url&& u, const std::string& b);
+HTTPPP_TASK_TYPE<http::response> fetch(
+    http_method m, http::url&& u, const std::string& b, cppcoro::cancellation_token token = {});
 
-HTTPPP_TASK_TYPE<http::response> fetch(http::url&& u);
+HTTPPP_TASK_TYPE<http::response> fetch(http::url&& u, cppcoro::cancellation_token token = {});
 #endif
 } // namespace http
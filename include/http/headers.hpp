@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace http {
+// the fields of a request or response in the order they were added, stored lowercase in one flat vector.
+// names are looked up case-insensitively by a linear scan, which is cheaper than hashing for the dozen or so fields of
+// a message. the fields read for every message (see known) are additionally indexed by their position.
+// iterators are read-only so names keep their lowercase form and position, values are changed through operator[]
+struct headers {
+public:
+  using value_type = std::pair<std::string, std::string>;
+  using const_iterator = std::vector<value_type>::const_iterator;
+  using iterator = const_iterator;
+
+  enum known : uint8_t {
+    CONNECTION,
+    CONTENT_LENGTH,
+    CONTENT_TYPE,
+    CONTENT_ENCODING,
+    TRANSFER_ENCODING,
+    HOST,
+    ACCEPT_ENCODING,
+    KNOWN_COUNT,
+  };
+
+  headers() = default;
+
+  headers(std::initializer_list<value_type> fields);
+
+  // inserts an empty field if `name` is missing
+  std::string& operator[](std::string_view name);
+
+  // the value of `name` or an empty string, without inserting anything
+  std::string_view value(std::string_view name) const noexcept;
+
+  std::string_view value(known name) const noexcept;
+
+  const_iterator find(std::string_view name) const noexcept;
+
+  size_t count(std::string_view name) const noexcept;
+
+  // does not replace an existing field, like std::unordered_map::emplace
+  std::pair<iterator, bool> emplace(std::string_view name, std::string_view value);
+
+  size_t erase(std::string_view name);
+
+  void clear() noexcept;
+
+  void reserve(size_t size);
+
+  size_t size() const noexcept;
+
+  bool empty() const noexcept;
+
+  const_iterator begin() const noexcept;
+
+  const_iterator end() const noexcept;
+
+  // KNOWN_COUNT for any other name
+  static known knownOf(std::string_view name) noexcept;
+
+private:
+  std::vector<value_type> _fields;
+  // position + 1 of every known field, 0 if it is missing
+  uint32_t _known[KNOWN_COUNT] = {};
+
+  size_t indexOf(std::string_view name) const noexcept;
+
+  std::string& append(std::string_view name, std::string_view value);
+};
+} // namespace http
@@ -8,6 +8,6 @@
 #include <iostream>
 
 namespace http::_1 {
-task<void> accept(uv::tcp& client, const http::serve::handler& callback);
+task<void> accept(uv::tcp& client, const http::serve::handler& callback, http::serve::options options = {});
 }
 #endif
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "./common.hpp"
+#include <climits>
 #include <functional>
+#include <utility>
 #ifdef HTTPPP_TASK_INCLUDE
 #include HTTPPP_TASK_INCLUDE
 #endif
@@ -12,14 +14,7 @@ template <typename T>
 struct parser {
 public:
   parser() {
-    _result.version = {1, 1};
-
-    if constexpr (type == HTTP_REQUEST) {
-      _result.method = (http_method)-1;
-      _result.url.schema("http");
-    } else {
-      _result.status = (http_status)-1;
-    }
+    initResult();
 
     http_parser_settings_init(&_settings);
     http_parser_init(&_parser, type);
@@ -29,8 +24,9 @@ public:
     _settings.on_url = [](http_parser* p, const char* data, size_t len) {
       auto parser = (http::_1::parser<T>*)p->data;
 
+      // the url, names and values may be split over several reads
       if constexpr (type == HTTP_REQUEST) {
-        parser->_result.url = {std::string_view{data, len}, http::url::IN};
+        parser->_url += std::string_view{data, len};
       }
 
       return 0;
@@ -39,8 +35,14 @@ public:
     _settings.on_header_field = [](http_parser* p, const char* data, size_t len) {
       auto parser = (http::_1::parser<T>*)p->data;
 
-      parser->_header = std::string_view{data, len};
-      std::transform(std::begin(parser->_header), std::end(parser->_header), std::begin(parser->_header), [](unsigned char c) {
+      if (parser->_header_value_started) {
+        parser->_header.clear();
+        parser->_header_value_started = false;
+      }
+
+      size_t offset = parser->_header.length();
+      parser->_header += std::string_view{data, len};
+      std::transform(std::begin(parser->_header) + offset, std::end(parser->_header), std::begin(parser->_header) + offset, [](unsigned char c) {
         return std::tolower(c);
       });
 
@@ -50,7 +52,12 @@ public:
     _settings.on_header_value = [](http_parser* p, const char* data, size_t len) {
       auto parser = (http::_1::parser<T>*)p->data;
 
-      parser->_result.headers[parser->_header] = std::string_view{data, len};
+      if (parser->_header_value_started) {
+        parser->_result.headers[parser->_header] += std::string_view{data, len};
+      } else {
+        parser->_result.headers[parser->_header] = std::string_view{data, len};
+        parser->_header_value_started = true;
+      }
 
       return 0;
     };
@@ -62,17 +69,37 @@ public:
 
       if constexpr (type == HTTP_REQUEST) {
         parser->_result.method = (http_method)parser->_parser.method;
+        parser->_result.url = {parser->_url, http::url::IN};
       } else {
         parser->_result.status = (http_status)parser->_parser.status_code;
       }
 
+      parser->_headers_done = true;
+
+      // a content-length above the limit is refused before any of the body is read
+      if (parser->_max_body_size != 0 && parser->_parser.content_length != ULLONG_MAX &&
+          parser->_parser.content_length > parser->_max_body_size) {
+        parser->_body_too_large = true;
+        return -1;
+      }
+
       return 0;
     };
 
     _settings.on_body = [](http_parser* p, const char* data, size_t len) {
       auto parser = (http::_1::parser<T>*)p->data;
 
-      parser->_result.body += std::string_view{data, len};
+      parser->_body_received += len;
+      if (parser->_max_body_size != 0 && parser->_body_received > parser->_max_body_size) {
+        parser->_body_too_large = true;
+        return -1;
+      }
+
+      if (parser->_body_stream) {
+        parser->_body_chunk += std::string_view{data, len};
+      } else {
+        parser->_result.body += std::string_view{data, len};
+      }
 
       return 0;
     };
@@ -86,10 +113,17 @@ public:
         parser->_done = parser->_result.status != -1;
       }
 
+      // bytes after the message belong to the next one (pipelining), they wait until next() is called
+      http_parser_pause(p, 1);
+
       return 0;
     };
   }
 
+  ~parser() {
+    *_alive = false;
+  }
+
   parser(const parser&) = delete;
 
   parser(parser&&) = delete;
@@ -99,44 +133,67 @@ public:
   parser& operator=(parser&&) = delete;
 
   void execute(std::string_view chunk) {
-    try {
-      size_t offset = http_parser_execute(&_parser, &_settings, chunk.data(), chunk.length());
+    if (_done) {
+      _pending += chunk;
+      return;
+    }
+    // the connection is unusable after a parse error
+    if (_parser.http_errno != HPE_OK && _parser.http_errno != HPE_PAUSED) {
+      return;
+    }
 
-      if (_parser.http_errno != 0) {
-        if (_parser.http_errno == HPE_INVALID_CONSTANT) {
-          return;
-        }
+    parse(chunk);
+  }
 
-        throw http::error{_parser.http_errno};
-      }
+  // starts over with the next message of the connection. bytes that arrived after the previous message are parsed
+  // right away, so the next result may already be complete (or failed) once onHeaders/onComplete is called
+  void next() {
+    _result = T{};
+    initResult();
+
+    _done = false;
+    _headers_done = false;
+    _body_received = 0;
+    _body_too_large = false;
+    _body_chunk.clear();
+    _url.clear();
+    _header.clear();
+    _header_value_started = false;
+    if (_body_stream) {
+      openBodyStream();
+    }
 
-      if (*this) {
-        if (_on_complete) {
-          _on_complete(_result);
-          _on_complete = nullptr;
-          _on_fail = nullptr;
-        }
-      }
-    } catch (...) {
-      if (_on_fail) {
-        _on_fail(std::current_exception());
-        _on_complete = nullptr;
-        _on_fail = nullptr;
-      } else {
-        throw;
-      }
+    http_parser_pause(&_parser, 0);
+
+    if (!_pending.empty()) {
+      auto pending = std::exchange(_pending, {});
+      parse(pending);
+    }
+
+    if (_closed && !_done) {
+      close();
     }
   }
 
+  // bytes received after the current message, parsed by next()
+  size_t pending() const {
+    return _pending.length();
+  }
+
   void fail(std::exception_ptr error = nullptr) {
-    if (_on_fail) {
-      _on_fail(error);
-      _on_complete = nullptr;
-      _on_fail = nullptr;
-    }
+    failWith(error);
   }
 
   void onComplete(std::function<void(T&)> on_complete, std::function<void(std::exception_ptr)> on_fail = [](auto) {}) {
+    if (_error) {
+      on_fail(std::exchange(_error, nullptr));
+      return;
+    }
+    if (_done || _closed) {
+      on_complete(_result);
+      return;
+    }
+
     _on_complete = std::move(on_complete);
     _on_fail = std::move(on_fail);
   }
@@ -149,10 +206,79 @@ public:
   }
 #endif
 
+  // called once the headers were parsed, with the body still to come
+  void onHeaders(std::function<void(T&)> on_headers, std::function<void(std::exception_ptr)> on_fail = [](auto) {}) {
+    if (_error) {
+      on_fail(std::exchange(_error, nullptr));
+      return;
+    }
+    if (_headers_done || _closed) {
+      on_headers(_result);
+      return;
+    }
+
+    _on_headers = std::move(on_headers);
+    _on_fail = std::move(on_fail);
+  }
+
+#ifdef HTTPPP_TASK_INCLUDE
+  HTTPPP_TASK_TYPE<T> onHeaders() {
+    return HTTPPP_TASK_CREATE<T>([this](auto& resolve, auto& reject) {
+      onHeaders(resolve, reject);
+    });
+  }
+#endif
+
+  // the body is passed on through result().body_stream instead of being collected in result().body. reading is
+  // supposed to be paused through `flow` while more than `high_watermark` bytes are buffered
+  void streamBody(std::function<void(bool)> flow, size_t high_watermark = 64 * 1024) {
+    _body_flow = std::move(flow);
+    _body_high_watermark = high_watermark;
+
+    openBodyStream();
+  }
+
+  // 0 is unlimited. a body above the limit fails the parser (see bodyTooLarge)
+  void maxBodySize(size_t size) {
+    _max_body_size = size;
+  }
+
+  bool bodyTooLarge() const {
+    return _body_too_large;
+  }
+
+  bool headersComplete() const {
+    return _headers_done;
+  }
+
   void close() {
+    auto alive = _alive;
+
+    // complete messages before the end of the connection are still handed out, see next()
+    _closed = true;
+    if (_done) {
+      return;
+    }
+
+    if (_body_stream && _headers_done) {
+      auto body_stream = _body_stream;
+      body_stream.fail(std::make_exception_ptr(http::error{"connection closed before the body was complete"}));
+      if (!*alive) {
+        return;
+      }
+    }
+
+    if (_on_headers) {
+      auto on_headers = std::move(_on_headers);
+      _on_headers = nullptr;
+      on_headers(_result);
+      return;
+    }
+
     if (_on_complete) {
-      _on_complete(_result);
+      auto on_complete = std::move(_on_complete);
       _on_complete = nullptr;
+      on_complete(_result);
     }
   }
 
@@ -171,12 +297,141 @@ private:
   http_parser _parser;
 
   bool _done = false;
+  bool _headers_done = false;
+  bool _closed = false;
 
+  size_t _max_body_size = 0;
+  size_t _body_received = 0;
+  bool _body_too_large = false;
+
+  http::body_stream _body_stream;
+  std::string _body_chunk;
+  std::function<void(bool)> _body_flow;
+  size_t _body_high_watermark = 0;
+
+  std::string _pending;
+  // a failure nobody waited for, reported to the next onHeaders/onComplete
+  std::exception_ptr _error;
+
+  std::shared_ptr<bool> _alive = std::make_shared<bool>(true);
+
+  std::function<void(T&)> _on_headers;
   std::function<void(T&)> _on_complete;
   std::function<void(std::exception_ptr)> _on_fail;
 
   T _result;
 
+  std::string _url;
   std::string _header;
+  bool _header_value_started = false;
+
+  void initResult() {
+    _result.version = {1, 1};
+
+    if constexpr (type == HTTP_REQUEST) {
+      _result.method = (http_method)-1;
+      _result.url.schema("http");
+    } else {
+      _result.status = (http_status)-1;
+    }
+  }
+
+  void openBodyStream() {
+    auto state = std::make_shared<http::body_stream::state>();
+    state->flow = _body_flow;
+    state->high_watermark = _body_high_watermark;
+
+    _body_stream = http::body_stream{state};
+    _result.body_stream = _body_stream;
+  }
+
+  void parse(std::string_view chunk) {
+    // the callbacks may resume a coroutine that owns (and destroys) this parser
+    auto alive = _alive;
+
+    try {
+      size_t offset = http_parser_execute(&_parser, &_settings, chunk.data(), chunk.length());
+
+      if (_parser.http_errno == HPE_PAUSED) {
+        _pending.assign(chunk.substr(offset));
+      } else if (_parser.http_errno != 0) {
+        if (_parser.http_errno == HPE_INVALID_CONSTANT) {
+          return;
+        }
+
+        throw http::error{_parser.http_errno};
+      }
+
+      if (_headers_done && _on_headers) {
+        auto on_headers = std::move(_on_headers);
+        _on_headers = nullptr;
+        _on_fail = nullptr;
+        on_headers(_result);
+        if (!*alive) {
+          return;
+        }
+      }
+
+      // the body read by this call is handed over at once instead of once per http_parser callback
+      if (_body_stream && !_body_chunk.empty()) {
+        auto body_stream = _body_stream;
+        body_stream.push(std::exchange(_body_chunk, {}));
+        if (!*alive) {
+          return;
+        }
+      }
+
+      if (*this) {
+        if (_body_stream) {
+          auto body_stream = _body_stream;
+          body_stream.end();
+          if (!*alive) {
+            return;
+          }
+        }
+
+        if (_on_complete) {
+          auto on_complete = std::move(_on_complete);
+          _on_complete = nullptr;
+          _on_fail = nullptr;
+          on_complete(_result);
+        }
+      }
+    } catch (...) {
+      if (!*alive) {
+        throw;
+      }
+
+      failWith(std::current_exception());
+    }
+  }
+
+  // kept for the next onHeaders/onComplete if nobody is waiting for the result
+  void failWith(std::exception_ptr error) {
+    auto alive = _alive;
+    bool handled = false;
+
+    if (_body_stream && _headers_done && !_done) {
+      auto body_stream = _body_stream;
+      body_stream.fail(error);
+      if (!*alive) {
+        return;
+      }
+      handled = true;
+    }
+
+    if (_on_fail) {
+      auto on_fail = std::move(_on_fail);
+      _on_headers = nullptr;
+      _on_complete = nullptr;
+      _on_fail = nullptr;
+      on_fail(error);
+      return;
+    }
+
+    if (!handled) {
+      _error = error;
+    }
+  }
 };
 } // namespace http
@@ -4,6 +4,7 @@
 #include "./common.hpp"
 #include <cstring>
 #include <functional>
+#include <vector>
 #include <nghttp2/nghttp2.h>
 #ifdef HTTPPP_TASK_INCLUDE
 #include HTTPPP_TASK_INCLUDE
@@ -86,14 +87,14 @@ public:
               return 0;
             }
 
-            result.headers[(std::string)header_name] = (std::string)header_value;
+            result.headers[header_name] = header_value;
           } else {
             if (header_name == ":status") {
               result.status = (http_status)std::stoi((std::string)header_value);
               return 0;
             }
 
-            result.headers[(std::string)header_name] = (std::string)header_value;
+            result.headers[header_name] = header_value;
           }
 
           return 0;
@@ -116,6 +117,16 @@ public:
 
           nghttp2_session_set_stream_user_data(handler->_session, stream_id, (void*)0);
 
+          // a reset stream drops whatever was still waiting to be sent
+          auto outgoing = handler->_outgoing.find(stream_id);
+          if (outgoing != handler->_outgoing.end()) {
+            auto on_written = std::move(outgoing->second.on_written);
+            handler->_outgoing.erase(outgoing);
+            handler->_written.push_back([on_written{std::move(on_written)}]() {
+              on_written(false);
+            });
+          }
+
           if constexpr (type == HTTP_RESPONSE) {
             nghttp2_session_terminate_session(session, NGHTTP2_NO_ERROR);
             handler->onStreamClose(stream_id);
@@ -167,6 +178,8 @@ public:
     }
   }
 
+  // nothing is resumed from here, writers still waiting in writeData have to be failed with cancelWrites() before the
+  // state they refer to goes away
   ~handler() {
     nghttp2_session_del(_session);
     nghttp2_session_callbacks_del(_callbacks);
@@ -210,9 +223,10 @@ public:
 #endif
 
   void close() {
-    if (_on_complete) {
-      _on_complete();
+    // whoever waits may resume right away
+    if (auto on_complete = std::move(_on_complete)) {
       _on_complete = nullptr;
+      on_complete();
     }
   }
 
@@ -237,8 +251,8 @@ public:
 
   void submitRequest(const http::request& request, std::function<void(int32_t)> on_send) {
     std::string method = (std::string)request.method;
-    std::string scheme = request.url.schema();
-    std::string authority = request.url.host();
+    std::string scheme{request.url.schema()};
+    std::string authority{request.url.host()};
     std::string path = request.url.fullpath();
 
     std::vector<nghttp2_nv> headers;
@@ -272,7 +286,7 @@ public:
         const auto& request = *context->request;
 
         auto& offset = context->offset;
-        size_t copy_length = std::min(request.body.length(), length);
+        size_t copy_length = std::min(request.body.length() - offset, length);
         memcpy(buf, request.body.data() + offset, copy_length);
         offset += copy_length;
 
@@ -311,7 +325,11 @@ public:
     std::string status = std::to_string(response.status);
 
     std::vector<nghttp2_nv> headers;
+    headers.reserve(response.headers.size() + 2);
     headers.push_back(makeNV(":status", status));
+    if (response.headers.count("date") == 0) {
+      headers.push_back(makeNV("date", http::serve::date()));
+    }
     for (const auto& [name, value] : response.headers) {
       headers.push_back(makeNV(name, value));
     }
@@ -338,7 +356,7 @@ public:
         const auto& response = *context->response;
 
         auto& offset = context->offset;
-        size_t copy_length = std::min(response.body.length(), length);
+        size_t copy_length = std::min(response.body.length() - offset, length);
         memcpy(buf, response.body.data() + offset, copy_length);
         offset += copy_length;
 
@@ -371,11 +389,116 @@ public:
   }
 #endif
 
+  // submits the headers of `response`, its body follows through writeData. nghttp2 defers the stream whenever
+  // nothing is pending
+  void submitStreamingResponse(int32_t stream_id, const http::response& response) {
+    std::string status = std::to_string(response.status);
+
+    std::vector<nghttp2_nv> headers;
+    headers.reserve(response.headers.size() + 2);
+    headers.push_back(makeNV(":status", status));
+    if (response.headers.count("date") == 0) {
+      headers.push_back(makeNV("date", http::serve::date()));
+    }
+    for (const auto& [name, value] : response.headers) {
+      headers.push_back(makeNV(name, value));
+    }
+
+    nghttp2_data_provider data_provider;
+    data_provider.source.ptr = nullptr;
+    data_provider.read_callback = [](nghttp2_session* session, int32_t stream_id, uint8_t* buf, size_t length,
+                                      uint32_t* data_flags, nghttp2_data_source* source, void* user_data) -> ssize_t {
+      auto handler = (http::_2::handler<T>*)user_data;
+
+      auto outgoing = handler->_outgoing.find(stream_id);
+      if (outgoing == handler->_outgoing.end()) {
+        return NGHTTP2_ERR_DEFERRED;
+      }
+
+      auto& data = outgoing->second;
+      size_t copy_length = std::min(data.chunk.length() - data.offset, length);
+      memcpy(buf, data.chunk.data() + data.offset, copy_length);
+      data.offset += copy_length;
+
+      if (data.offset == data.chunk.length()) {
+        if (data.eof) {
+          *data_flags |= NGHTTP2_DATA_FLAG_EOF;
+        }
+
+        // called once nghttp2_session_send returned, the writer may queue the next chunk right away
+        handler->_written.push_back([on_written{std::move(data.on_written)}]() {
+          on_written(true);
+        });
+        handler->_outgoing.erase(outgoing);
+      }
+
+      return copy_length;
+    };
+
+    int rv = nghttp2_submit_response(_session, stream_id, headers.data(), headers.size(), &data_provider);
+    if (rv != 0) {
+      throw http::error{nghttp2_strerror(rv)};
+    }
+  }
+
+  // queues the next part of a body submitted with submitStreamingResponse, `eof` ends the stream.
+  // `on_written` is called with true once nghttp2 took the chunk and with false if the stream was closed before
+  void writeData(int32_t stream_id, std::string chunk, bool eof, std::function<void(bool)> on_written) {
+    _outgoing[stream_id] = outgoing_data{std::move(chunk), 0, eof, std::move(on_written)};
+
+    // a stream whose data nghttp2 did not ask for yet is not deferred and can not be resumed, the next send reads the
+    // chunk anyway. only a stream that is gone fails the write
+    int rv = nghttp2_session_resume_data(_session, stream_id);
+    if (rv != 0 && nghttp2_session_find_stream(_session, stream_id) == nullptr) {
+      auto on_written = std::move(_outgoing[stream_id].on_written);
+      _outgoing.erase(stream_id);
+      on_written(false);
+    }
+  }
+
+#ifdef HTTPPP_TASK_INCLUDE
+  HTTPPP_TASK_TYPE<bool> writeData(int32_t stream_id, std::string chunk, bool eof) {
+    return HTTPPP_TASK_CREATE<bool>([this, stream_id, chunk{std::move(chunk)}, eof](auto& resolve, auto&) mutable {
+      writeData(stream_id, std::move(chunk), eof, std::move(resolve));
+      sendSession();
+    });
+  }
+#endif
+
+  // fails every writeData that is still waiting, e.g. once the connection is gone and nothing is sent anymore
+  void cancelWrites() {
+    auto outgoing = std::move(_outgoing);
+    _outgoing.clear();
+    for (auto& [stream_id, data] : outgoing) {
+      data.on_written(false);
+    }
+
+    auto written = std::move(_written);
+    _written.clear();
+    for (auto& on_written : written) {
+      on_written();
+    }
+  }
+
+  // ends a stream with RST_STREAM (INTERNAL_ERROR), e.g. if its response failed halfway
+  void resetStream(int32_t stream_id) {
+    int rv = nghttp2_submit_rst_stream(_session, NGHTTP2_FLAG_NONE, stream_id, NGHTTP2_INTERNAL_ERROR);
+    if (rv != 0) {
+      throw http::error{nghttp2_strerror(rv)};
+    }
+  }
+
   void sendSession() {
     int rv = nghttp2_session_send(_session);
     if (rv != 0) {
       throw http::error{nghttp2_strerror(rv)};
     }
+
+    auto written = std::move(_written);
+    _written.clear();
+    for (auto& on_written : written) {
+      on_written();
+    }
   }
 
 private:
@@ -397,6 +520,16 @@ private:
 
   std::function<void(int32_t, T&&)> _on_stream_end;
 
+  struct outgoing_data {
+    std::string chunk;
+    size_t offset = 0;
+    bool eof = false;
+    std::function<void(bool)> on_written;
+  };
+
+  std::unordered_map<int32_t, outgoing_data> _outgoing;
+  std::vector<std::function<void()>> _written;
+
   int onStreamClose(int32_t stream_id) {
     auto& result = _result[stream_id];
 
@@ -410,7 +543,7 @@ private:
 
     if (nghttp2_session_want_read(_session) == 0 &&
         nghttp2_session_want_write(_session) == 0) {
-      _on_complete();
+      close();
     }
 
     return 0;
@@ -9,9 +9,21 @@
 #include "./gzip.hpp"
 #include "./http1-serve.hpp"
 #include "./http2-serve.hpp"
+#include "cppcoro/cancellation_token.hpp"
+#include <thread>
 
 namespace http::serve {
-void listen(uv::tcp& server, http::serve::handler&& _callback);
+// the process has to ignore SIGPIPE (see main.cpp), otherwise a client that goes away in the middle of a response kills
+// it instead of failing the write with EPIPE
+void listen(uv::tcp& server, http::serve::handler&& _callback, http::serve::options options = {});
+
+// runs `loops` event loops on their own threads. each binds its own uv::tcp to `ip`:`port` with SO_REUSEPORT, so the
+// kernel spreads connections over them, and serves with its own handler from `make_handler`.
+// `configure` runs for every server before it is bound (e.g. to call useSSL). blocks until `token` is cancelled and all
+// loops finished their open connections.
+void listen(const char* ip, int port, size_t loops, std::function<http::serve::handler()> make_handler,
+    std::function<void(uv::tcp&)> configure = {}, cppcoro::cancellation_token token = {},
+    http::serve::options options = {});
 
 // struct ssl_config {
 // public:
@@ -47,7 +59,18 @@ void listen(uv::tcp& server, http::serve::handler&& _callback);
 // #endif
 // }
 
+// answers with the file at `path`: 404 if it is missing or not a regular file, 304 if `If-None-Match` matches its
+// ETag, 206/416 for a single `Range`. metadata (size, mtime, ETag) is cached per process for a second.
+// the body is not read here, the connection sends it straight from the file (sendfile over plaintext HTTP/1)
+task<void> file(const http::request& request, http::response& response, std::string_view path,
+    uv_loop_t* native_loop = uv_default_loop());
+
 inline void normalize(http::response& response) {
+  // file bodies already carry their length, produced bodies have none and 304s have no body at all
+  if (response.file || response.producer || response.status == http::status::NOT_MODIFIED) {
+    return;
+  }
+
 #ifdef HTTPPP_ZLIB
   if (response.headers.count("content-encoding") == 0) {
     if (request.headers["accept-encoding"].find("gzip") != std::string::npos) {
@@ -61,6 +84,19 @@ inline void normalize(http::response& response) {
 }
 
 namespace detail {
+// If-None-Match uses the weak comparison, `W/"x"` matches `"x"` and `*` matches any ETag
+bool matchesETag(std::string_view header, std::string_view etag);
+
+struct byte_range {
+  uint64_t first = 0;
+  uint64_t last = 0;
+  bool satisfiable = true;
+};
+
+// a single `bytes=first-last`, `bytes=first-` or `bytes=-suffix`. anything else (including multiple ranges) is
+// ignored and answered with the whole file
+std::optional<byte_range> parseRange(std::string_view header, uint64_t size);
+
 template <typename T>
 struct query_params_meta {
   static constexpr bool specialized = false;
@@ -79,6 +115,20 @@ struct decay_std_optional<std::optional<T>> {
 
   static constexpr bool specialized = true;
 };
+
+// a parameter without a value leaves an optional field as it is and fails any other
+template <typename T>
+void assignQueryParam(T& field, std::string_view encoded) {
+  field = http::url::queryparse<T>(encoded).value();
+}
+
+template <typename T>
+void assignQueryParam(std::optional<T>& field, std::string_view encoded) {
+  auto value = http::url::queryparse<T>(encoded);
+  if (value) {
+    field = std::move(value);
+  }
+}
 } // namespace detail
 
 template <typename T>
@@ -88,29 +138,47 @@ void deserializeQuery(const http::url& url, T& result) {
 } // namespace http::serve
 #endif
 
-#define HTTP_QUERY_PARAMS_DESERIALIZE_FIELD(FIELD)                                   \
-  {                                                                                  \
-    using decayed = http::serve::detail::decay_std_optional<decltype(result.FIELD)>; \
-    auto value = url.queryvalue<typename decayed::type>(#FIELD);                     \
-    if constexpr (decayed::specialized) {                                            \
-      if (value) {                                                                   \
-        result.FIELD = value;                                                        \
-      }                                                                              \
-    } else {                                                                         \
-      result.FIELD = value.value();                                                  \
-    }                                                                                \
+#define HTTP_QUERY_PARAMS_SEEN_FIELD(FIELD) bool FIELD = false;
+
+// a parameter that occurs more than once is assigned every time, the last one wins
+#define HTTP_QUERY_PARAMS_DESERIALIZE_FIELD(FIELD)                   \
+  if (name == #FIELD) {                                              \
+    http::serve::detail::assignQueryParam(result.FIELD, encoded);    \
+    seen.FIELD = true;                                               \
+    return;                                                          \
+  }
+
+#define HTTP_QUERY_PARAMS_REQUIRE_FIELD(FIELD)                                         \
+  {                                                                                    \
+    using decayed = http::serve::detail::decay_std_optional<decltype(result.FIELD)>;   \
+    if constexpr (!decayed::specialized) {                                             \
+      if (!seen.FIELD) {                                                               \
+        throw std::bad_optional_access{};                                              \
+      }                                                                                \
+    }                                                                                  \
   }
 
-#define HTTP_QUERY_PARAMS_SPECIALIZE(TYPE, FIELDS...)             \
-  namespace http::serve::detail {                                 \
-  template <>                                                     \
-  struct query_params_meta<TYPE> {                                \
-    using class_type = TYPE;                                      \
-                                                                  \
-    static constexpr bool specialized = true;                     \
-                                                                  \
-    static void deserialize(const http::url& url, TYPE& result) { \
-      FOR_EACH(HTTP_QUERY_PARAMS_DESERIALIZE_FIELD, FIELDS);      \
-    }                                                             \
-  };                                                              \
+// one pass over the query string, fields that are no std::optional have to be present
+#define HTTP_QUERY_PARAMS_SPECIALIZE(TYPE, FIELDS...)                                       \
+  namespace http::serve::detail {                                                           \
+  template <>                                                                               \
+  struct query_params_meta<TYPE> {                                                          \
+    using class_type = TYPE;                                                                \
+                                                                                            \
+    static constexpr bool specialized = true;                                               \
+                                                                                            \
+    static void deserialize(const http::url& url, TYPE& result) {                           \
+      struct {                                                                              \
+        FOR_EACH(HTTP_QUERY_PARAMS_SEEN_FIELD, FIELDS)                                      \
+      } seen;                                                                               \
+                                                                                            \
+      std::string storage;                                                                  \
+      url.queryeach([&](std::string_view encoded_name, std::string_view encoded) {          \
+        std::string_view name = http::url::decode(encoded_name, storage);                   \
+        FOR_EACH(HTTP_QUERY_PARAMS_DESERIALIZE_FIELD, FIELDS)                               \
+      });                                                                                   \
+                                                                                            \
+      FOR_EACH(HTTP_QUERY_PARAMS_REQUIRE_FIELD, FIELDS)                                     \
+    }                                                                                       \
+  };                                                                                        \
   }
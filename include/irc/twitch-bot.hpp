@@ -37,24 +37,15 @@ public:
   }
 
   void feed(std::string_view chunk) {
-    _stream << chunk;
-
-    std::string line;
-    while (std::getline(_stream, line)) {
-      if (line.ends_with('\r')) {
-        line.resize(line.size() - 1);
-      }
+    _lines.feed(chunk, [this](auto view) {
+      // messages own their raw line, parse() moves it through the alternatives instead of copying it
+      std::string line{view};
 
       irc::message message = irc::parse(line);
       for (auto& [id, handler] : _handlers) {
         handler(message, id);
       }
-    }
-
-    if (_stream.eof()) {
-      _stream.clear();
-      _stream.str({});
-    }
+    });
   }
 
   task<void> authAnon() {
@@ -131,7 +122,7 @@ public:
         _hrtime_of_last_send = now;
         break;
       } else {
-        co_await uv::timeout(message_timeout + 1 - diff);
+        co_await uv::timer_wheel::of(uv_default_loop()).sleep(message_timeout + 1 - diff);
       }
     }
 
@@ -245,7 +236,7 @@ public:
   }
 
 private:
-  std::stringstream _stream;
+  uv::line_splitter _lines;
 
   std::function<void(std::string_view)> _on_send_with_reader;
   std::function<void(std::string_view)> _on_send_with_writer;
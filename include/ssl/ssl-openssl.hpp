@@ -38,6 +38,8 @@ public:
 
     void encrypt(std::string_view data, std::function<void(std::exception_ptr)> cb) override;
 
+    void encrypt(std::span<const std::string_view> data, std::function<void(std::exception_ptr)> cb) override;
+
     void onReadDecrypted(std::function<void(std::string_view)>& value) override;
 
     void onWriteEncrypted(std::function<void(std::string&&, std::function<void(std::exception_ptr)>)>& value) override;
@@ -2,6 +2,7 @@
 
 #include <functional>
 #include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -44,6 +45,9 @@ public:
 
     virtual void encrypt(std::string_view data, std::function<void(std::exception_ptr)> cb) = 0;
 
+    // encrypts all segments back to back and hands the result to onWriteEncrypted at once
+    virtual void encrypt(std::span<const std::string_view> data, std::function<void(std::exception_ptr)> cb) = 0;
+
     virtual void onReadDecrypted(std::function<void(std::string_view)>& value) = 0;
 
     virtual void onWriteEncrypted(
@@ -134,6 +138,8 @@ public:
   SSLPP_TASK_TYPE<void> encrypt(std::string_view data);
 #endif
 
+  void encrypt(std::span<const std::string_view> data, std::function<void(std::exception_ptr)> cb);
+
   void onReadDecrypted(std::function<void(std::string_view)> value);
 
   void onWriteEncrypted(std::function<void(std::string&&, std::function<void(std::exception_ptr)>)> value);
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "./task.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace taskpp {
+// N worker threads, each with its own deque of resumable coroutines.
+// workers pop their own deque LIFO and steal FIFO from the others when idle.
+class executor {
+public:
+  struct schedule_awaiter {
+    executor& _executor;
+
+    bool await_ready() noexcept {
+      return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> waiter) {
+      _executor.post(waiter);
+    }
+
+    void await_resume() noexcept {
+    }
+  };
+
+  explicit executor(size_t thread_count = std::thread::hardware_concurrency());
+
+  executor(const executor&) = delete;
+
+  executor& operator=(const executor&) = delete;
+
+  ~executor();
+
+  // `co_await executor.schedule()` resumes the awaiting coroutine on one of the workers
+  schedule_awaiter schedule() noexcept {
+    return {*this};
+  }
+
+  void post(std::coroutine_handle<> handle);
+
+  template <typename T>
+  task<T> run(task<T> t) {
+    co_await schedule();
+
+    if constexpr (task<T>::is_void_v) {
+      co_await t;
+    } else {
+      co_return co_await t;
+    }
+  }
+
+  template <typename F>
+  void spawn(F&& taskfn) {
+    [](executor& self, F taskfn) -> task<void> {
+      co_await self.schedule();
+      co_await taskfn();
+    }(*this, std::forward<F>(taskfn)).start();
+  }
+
+  // finishes the queued work and joins all workers
+  void stop();
+
+  size_t size() const noexcept;
+
+  bool isWorkerThread() const noexcept;
+
+private:
+  struct worker {
+    std::mutex mutex;
+    std::deque<std::coroutine_handle<>> queue;
+    std::thread thread;
+  };
+
+  std::vector<std::unique_ptr<worker>> _workers;
+
+  std::mutex _inject_mutex;
+  std::deque<std::coroutine_handle<>> _inject;
+
+  std::mutex _sleep_mutex;
+  std::condition_variable _sleep_cv;
+  std::atomic<size_t> _sleeping = 0;
+  std::atomic<size_t> _pending = 0;
+  std::atomic<bool> _stopping = false;
+
+  void loop(size_t index);
+
+  std::coroutine_handle<> take(size_t index);
+};
+} // namespace taskpp
@@ -1,16 +1,48 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <coroutine>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
 #include <variant>
+#include <vector>
 #include <iostream>
 
-#include "cppcoro/async_manual_reset_event.hpp"
+#include "cppcoro/cancellation_source.hpp"
 
 namespace taskpp {
+struct frame_stats {
+  uint64_t allocations = 0;
+  uint64_t deallocations = 0;
+  uint64_t pool_hits = 0;
+  uint64_t pool_misses = 0;
+};
+
+// coroutine frame allocation counters of the calling thread
+frame_stats current_frame_stats() noexcept;
+
 namespace detail {
-void deleteTask(std::function<void()> deleter);
+void* allocate_frame(std::size_t size);
+
+void deallocate_frame(void* ptr, std::size_t size) noexcept;
+
+// intrusive node for detached tasks, so finishing one needs neither a lock nor an allocation
+struct completed_task {
+  void (*destroy)(completed_task*) = nullptr;
+};
+
+void deleteTask(completed_task* completed);
+
+// completion hook used by the combinators instead of a waiting coroutine, so they need no wrapper frame per child
+struct task_observer {
+  std::coroutine_handle<> (*completed)(task_observer* self) noexcept;
+};
 }
 
 template <typename T = void>
@@ -29,6 +61,17 @@ struct [[nodiscard]] task {
   struct promise_type_base {
     std::variant<std::monostate, value_type, std::exception_ptr> result;
     std::coroutine_handle<> waiter; // who waits on this coroutine
+    detail::task_observer* observer = nullptr;
+
+#ifndef TASKPP_NO_FRAME_POOL
+    static void* operator new(std::size_t size) {
+      return detail::allocate_frame(size);
+    }
+
+    static void operator delete(void* ptr, std::size_t size) noexcept {
+      detail::deallocate_frame(ptr, size);
+    }
+#endif
 
     void unhandled_exception(std::exception_ptr error) {
       result.template emplace<2>(error);
@@ -51,8 +94,13 @@ struct [[nodiscard]] task {
         void await_resume() noexcept {
         }
 
-        auto await_suspend(std::coroutine_handle<promise_type> me) noexcept {
-          return me.promise().waiter;
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> me) noexcept {
+          auto& promise = me.promise();
+          if (promise.observer) {
+            return promise.observer->completed(promise.observer);
+          }
+
+          return promise.waiter;
         }
       };
 
@@ -181,20 +229,33 @@ struct [[nodiscard]] task {
     return unpack();
   }
 
-  void await_suspend(std::coroutine_handle<> waiter) {
+  // symmetric transfer into the task, its final_suspend transfers back to `waiter` the same way
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> waiter) {
     if constexpr (is_void_v) {
       if (!_handle) {
-        waiter.resume();
-        return;
+        return waiter;
       }
     }
 
     _handle.promise().waiter = waiter;
-    _handle.resume();
+    return _handle;
   }
 
   void start_owned() {
-    await_suspend(std::noop_coroutine());
+    await_suspend(std::noop_coroutine()).resume();
+  }
+
+  // like start_owned() but completion is reported to `observer` instead of resuming a waiter
+  void start_observed(detail::task_observer& observer) {
+    if constexpr (is_void_v) {
+      if (!_handle) {
+        observer.completed(&observer).resume();
+        return;
+      }
+    }
+
+    _handle.promise().observer = &observer;
+    _handle.resume();
   }
 
   auto start_blocking(std::function<void()> run_main_loop) {
@@ -210,7 +271,7 @@ struct [[nodiscard]] task {
   }
 
   void start(std::function<void(std::function<void()>)> queue_delete) {
-    struct state_t {
+    struct state_t : public detail::completed_task {
       std::function<void(std::function<void()>)> queue_delete;
       task<T> self;
       task<void> deleter;
@@ -228,13 +289,20 @@ struct [[nodiscard]] task {
 #endif
         }
 
-        state->queue_delete([state]() {
-          delete state;
-        });
+        if (state->queue_delete) {
+          state->queue_delete([state]() {
+            delete state;
+          });
+        } else {
+          detail::deleteTask(state);
+        }
       }
     };
 
     auto state = new state_t();
+    state->destroy = [](detail::completed_task* completed) {
+      delete static_cast<state_t*>(completed);
+    };
     state->queue_delete = std::move(queue_delete);
     state->self = std::move(*this);
     state->deleter = state_t::await_and_delete(state);
@@ -243,7 +311,7 @@ struct [[nodiscard]] task {
   }
 
   void start() {
-    start(&detail::deleteTask);
+    start(nullptr);
   }
 
   bool done() {
@@ -285,26 +353,15 @@ struct [[nodiscard]] task {
 
   using handler = std::function<void(resolver&, rejecter&)>;
 
+  // runs `cb` once awaited. resolve and reject may be called from any thread, later or before `cb` returns
   static task<T> create(handler cb) {
-    cppcoro::async_manual_reset_event event;
-    promise_type promise;
-
-    resolver resolve = create_resolver(event, promise);
-    rejecter reject = create_rejecter(event, promise);
+    // a named awaiter, gcc 12 destroys a temporary one twice
+    created settle{std::move(cb)};
 
-    try {
-      cb(resolve, reject);
-    } catch (...) {
-      reject(std::current_exception());
-    }
-
-    co_await event;
-
-    if constexpr (std::is_same_v<promise_type, promise_type_void_param>) {
-      promise.unpack();
-      co_return;
+    if constexpr (is_void_v) {
+      co_await settle;
     } else {
-      co_return promise.unpack();
+      co_return co_await settle;
     }
   }
 
@@ -318,26 +375,25 @@ struct [[nodiscard]] task {
           std::conditional_t<use_const_param, resolved_const_param,
               std::conditional_t<use_value_param, resolved_value_param, void>>>>;
 
+  // the value is taken right away, the returned task may be awaited after the argument is gone
   static task<T> resolve(resolved value) {
-    return create([&](auto& resolve, auto&) {
-      if constexpr (is_void_v) {
-        resolve();
-      } else {
-        resolve(value);
-      }
-    });
+    if constexpr (is_void_v) {
+      return settled(std::nullopt);
+    } else if constexpr (use_movable_param) {
+      return settled(std::move(value));
+    } else {
+      return settled(value);
+    }
   }
 
   static task<T> reject(std::exception_ptr error) {
-    return create([&](auto&, auto& reject) {
+    return create([error](auto&, auto& reject) {
       reject(error);
     });
   }
 
   static task<T> reject(const std::exception& error) {
-    return create([&](auto&, auto& reject) {
-      reject(std::make_exception_ptr(error));
-    });
+    return reject(std::make_exception_ptr(error));
   }
 
   task<void> then(resolver then, rejecter fail = [](auto) {}) {
@@ -363,106 +419,272 @@ struct [[nodiscard]] task {
     }
   }
 
+  // see when_any(), the tasks should have been created with `source.token()` so the losers are cancelled
   template <typename... A>
-  static task<void> race(A&... tasks) {
-    cppcoro::async_manual_reset_event event;
-    std::exception_ptr error = nullptr;
-
-    auto cb = [&](std::exception_ptr e) {
-      error = e;
-      event.set();
-    };
+  static task<void> race(cppcoro::cancellation_source source, A... tasks) {
+    co_await when_any(std::move(source), std::move(tasks)...);
+  }
 
-    _race(cb, tasks...);
+  // see when_all()
+  template <typename... A>
+  static task<void> all(A... tasks) {
+    co_await when_all(std::move(tasks)...);
+  }
 
-    co_await event;
+private:
+  std::coroutine_handle<promise_type> _handle;
 
-    if (error) {
-      std::rethrow_exception(error);
+  // suspends the coroutine of create() until resolve or reject was called. whichever of await_suspend and
+  // complete() comes second continues, so the handler may settle synchronously or from another thread.
+  // lives in the frame of create(), handlers may keep references to `resolve` and `reject` until they called one
+  struct created {
+    handler cb;
+    resolver resolve = {};
+    rejecter reject = {};
+    std::variant<std::monostate, value_type, std::exception_ptr> result = {};
+    std::coroutine_handle<> waiter = {};
+    std::atomic<bool> arrived = false;
+
+    bool await_ready() noexcept {
+      return false;
     }
-  }
 
-  template <typename... A>
-  static task<void> all(A... tasks) {
-    std::vector<task<void>> vector;
-    cppcoro::async_manual_reset_event event;
-    std::exception_ptr error = nullptr;
-    int done = 0;
+    bool await_suspend(std::coroutine_handle<> w) {
+      waiter = w;
 
-    auto cb = [&](std::exception_ptr e) {
-      if (event.is_set()) {
-        return;
-      }
+      resolve = create_resolver();
+      reject = [this](std::exception_ptr error) {
+        result.template emplace<2>(error);
+        complete();
+      };
 
-      if (e) {
-        error = e;
-        event.set();
-        return;
+      try {
+        cb(resolve, reject);
+      } catch (...) {
+        reject(std::current_exception());
       }
 
-      done += 1;
+      return !arrived.exchange(true, std::memory_order_acq_rel);
+    }
 
-      if (done >= vector.size()) {
-        event.set();
+    value_type await_resume() {
+      if (result.index() == 2) {
+        std::rethrow_exception(std::get<2>(result));
       }
-    };
 
-    race(vector, cb, tasks...);
+      if constexpr (use_movable_param) {
+        return std::move(std::get<1>(result));
+      } else {
+        return std::get<1>(result);
+      }
+    }
+
+    void complete() {
+      if (arrived.exchange(true, std::memory_order_acq_rel)) {
+        waiter.resume();
+      }
+    }
 
-    co_await event;
+    resolver create_resolver() {
+      if constexpr (is_void_v) {
+        return [this]() {
+          result.template emplace<1>(std::nullopt);
+          complete();
+        };
+      } else if constexpr (use_movable_param) {
+        return [this](value_type& value) {
+          result.template emplace<1>(std::move(value));
+          complete();
+        };
+      } else if constexpr (use_const_param) {
+        return [this](const value_type& value) {
+          result.template emplace<1>(value);
+          complete();
+        };
+      } else if constexpr (use_value_param) {
+        return [this](value_type value) {
+          result.template emplace<1>(value);
+          complete();
+        };
+      }
+    }
+  };
 
-    if (error) {
-      std::rethrow_exception(error);
+  static task<T> settled(value_type value) {
+    if constexpr (is_void_v) {
+      co_return;
+    } else {
+      co_return std::move(value);
     }
   }
+};
 
-private:
-  std::coroutine_handle<promise_type> _handle;
+template <typename T>
+task<T> create(typename task<T>::handler cb) {
+  return task<T>::create(std::move(cb));
+}
 
-  static resolver create_resolver(cppcoro::async_manual_reset_event& event, promise_type& promise) {
-    if constexpr (is_void_v) {
-      return [&]() {
-        promise.return_void();
-        event.set();
-      };
-    } else if constexpr (use_movable_param) {
-      return [&](value_type& value) {
-        promise.return_value(std::move(value));
-        event.set();
-      };
-    } else if constexpr (use_const_param) {
-      return [&](const value_type& value) {
-        promise.return_value(value);
-        event.set();
-      };
-    } else if constexpr (use_value_param) {
-      return [&](value_type value) {
-        promise.return_value(value);
-        event.set();
-      };
+template <typename T>
+using when_all_result_t = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+
+template <typename T>
+using when_any_result_t = std::conditional_t<std::is_void_v<T>, size_t, std::pair<size_t, T>>;
+
+namespace detail {
+// every child holds one reference and the parent holds one more until all children are started, so a child that
+// finishes synchronously never resumes the parent from inside the start loop
+struct when_all_counter : public task_observer {
+  std::atomic<size_t> remaining;
+  std::coroutine_handle<> waiter;
+
+  explicit when_all_counter(size_t count) : task_observer{&notify}, remaining(count + 1) {
+  }
+
+  std::coroutine_handle<> arrive() noexcept {
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      return waiter;
     }
+
+    return std::noop_coroutine();
   }
 
-  static rejecter create_rejecter(cppcoro::async_manual_reset_event& event, promise_type& promise) {
-    return [&](std::exception_ptr error) {
-      promise.unhandled_exception(error);
-      event.set();
-    };
+  static std::coroutine_handle<> notify(task_observer* self) noexcept {
+    return static_cast<when_all_counter*>(self)->arrive();
   }
 
   template <typename F>
-  static void _race(F& cb) {}
+  auto wait(F start_all) {
+    struct awaiter {
+      when_all_counter& counter;
+      F start_all;
+
+      bool await_ready() noexcept {
+        return false;
+      }
+
+      bool await_suspend(std::coroutine_handle<> waiter) {
+        counter.waiter = waiter;
+        start_all();
+        return counter.remaining.fetch_sub(1, std::memory_order_acq_rel) > 1;
+      }
+
+      void await_resume() noexcept {
+      }
+    };
+
+    return awaiter{*this, std::move(start_all)};
+  }
+};
+
+struct when_any_state {
+  static constexpr size_t none = SIZE_MAX;
 
-  template <typename F, typename A0, typename... A>
-  static void _race(F& cb, A0& task, A&... tasks) {
-    task.finally(cb).start();
-    _race(cb, tasks...);
+  when_all_counter counter;
+  std::atomic<size_t> winner = none;
+  cppcoro::cancellation_source source;
+};
+
+struct when_any_observer : public task_observer {
+  when_any_state* state = nullptr;
+  size_t index = 0;
+
+  when_any_observer() : task_observer{&notify} {
+  }
+
+  static std::coroutine_handle<> notify(task_observer* self) noexcept {
+    auto observer = static_cast<when_any_observer*>(self);
+    auto state = observer->state;
+
+    size_t expected = when_any_state::none;
+    if (state->winner.compare_exchange_strong(expected, observer->index, std::memory_order_acq_rel)) {
+      state->source.request_cancellation();
+    }
+
+    return state->counter.arrive();
   }
 };
 
+template <typename T, typename C, typename O>
+task<when_any_result_t<T>> when_any_range(cppcoro::cancellation_source source, C tasks, O observers) {
+  if (tasks.empty()) {
+    throw std::invalid_argument{"when_any requires at least one task"};
+  }
+
+  when_any_state state{when_all_counter{tasks.size()}, when_any_state::none, std::move(source)};
+
+  co_await state.counter.wait([&]() {
+    for (size_t i = 0; i < tasks.size(); i++) {
+      observers[i].state = &state;
+      observers[i].index = i;
+      tasks[i].start_observed(observers[i]);
+    }
+  });
+
+  size_t index = state.winner.load(std::memory_order_acquire);
+
+  if constexpr (std::is_void_v<T>) {
+    tasks[index].unpack();
+    co_return index;
+  } else {
+    co_return when_any_result_t<T>{index, tasks[index].unpack()};
+  }
+}
+}
+
+// runs all tasks concurrently and resumes once every one of them finished.
+// a failure is rethrown after the others finished, the first one in argument order wins.
+template <typename... T>
+task<std::tuple<typename task<T>::value_type...>> when_all(task<T>... tasks) {
+  detail::when_all_counter counter{sizeof...(T)};
+
+  co_await counter.wait([&]() {
+    (tasks.start_observed(counter), ...);
+  });
+
+  co_return std::tuple<typename task<T>::value_type...>{tasks.unpack()...};
+}
+
 template <typename T>
-task<T> create(typename task<T>::handler cb) {
-  return task<T>::create(std::move(cb));
+task<when_all_result_t<T>> when_all(std::vector<task<T>> tasks) {
+  detail::when_all_counter counter{tasks.size()};
+
+  co_await counter.wait([&]() {
+    for (auto& t : tasks) {
+      t.start_observed(counter);
+    }
+  });
+
+  if constexpr (std::is_void_v<T>) {
+    for (auto& t : tasks) {
+      t.unpack();
+    }
+  } else {
+    std::vector<T> results;
+    results.reserve(tasks.size());
+    for (auto& t : tasks) {
+      results.push_back(t.unpack());
+    }
+
+    co_return results;
+  }
+}
+
+// runs all tasks concurrently and returns the index (and value) of the first one to finish.
+// the losers are cancelled through `source`, they should have been created with `source.token()`, and are awaited
+// before this resumes so none of them outlives the call. their results and errors are discarded.
+template <typename T>
+task<when_any_result_t<T>> when_any(cppcoro::cancellation_source source, std::vector<task<T>> tasks) {
+  auto count = tasks.size();
+  return detail::when_any_range<T>(std::move(source), std::move(tasks), std::vector<detail::when_any_observer>(count));
+}
+
+template <typename T, typename... A>
+task<when_any_result_t<T>> when_any(cppcoro::cancellation_source source, task<T> first, A... rest) {
+  static_assert((std::is_same_v<A, task<T>> && ...), "when_any requires tasks of the same type");
+
+  constexpr size_t count = 1 + sizeof...(A);
+  return detail::when_any_range<T>(std::move(source), std::array<task<T>, count>{std::move(first), std::move(rest)...},
+      std::array<detail::when_any_observer, count>{});
 }
 }
 
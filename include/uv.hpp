@@ -1,12 +1,16 @@
 #pragma once
 
 #include "./uvpp/async.hpp"
+#include "./uvpp/buffer.hpp"
+#include "./uvpp/channel.hpp"
 #include "./uvpp/check.hpp"
 #include "./uvpp/dns.hpp"
 #include "./uvpp/error.hpp"
 #include "./uvpp/fs.hpp"
 #include "./uvpp/handle.hpp"
+#include "./uvpp/idle.hpp"
 #include "./uvpp/lib.hpp"
+#include "./uvpp/lines.hpp"
 #include "./uvpp/loop.hpp"
 #include "./uvpp/misc.hpp"
 #include "./uvpp/req.hpp"
@@ -16,6 +20,7 @@
 #include "./uvpp/threading.hpp"
 #include "./uvpp/timer.hpp"
 #include "./uvpp/tty.hpp"
+#include "./uvpp/wheel.hpp"
 #include "./uvpp/work.hpp"
 
 // #ifdef UVPP_TASK_INCLUDE
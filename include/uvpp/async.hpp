@@ -2,8 +2,14 @@
 
 #include "./error.hpp"
 #include "./handle.hpp"
+#ifdef UVPP_TASK_INCLUDE
+#include UVPP_TASK_INCLUDE
+#endif
 #include "uv.h"
+#include <coroutine>
 #include <functional>
+#include <mutex>
+#include <vector>
 
 namespace uv {
 struct async : public handle {
@@ -33,6 +39,11 @@ public:
 
   void send(std::function<void()> async_cb);
 
+  // sets the callback without waking the loop, notify() may then be called from any thread
+  void start(std::function<void()> async_cb);
+
+  void notify();
+
 #ifdef UVPP_TASK_INCLUDE
   task<void> send();
 #endif
@@ -46,4 +57,32 @@ public:
 private:
   uv_async_t* _native_async;
 };
+
+// hands coroutines that finished waiting on another thread (e.g. for a db::executor) back to `native_loop`, where they
+// are resumed in batches. unbounded, so a producing thread never waits for the loop and nothing is dropped.
+// the queue keeps its loop alive until it is closed, it has to be created, drained and closed on its loop
+struct resume_queue {
+public:
+  explicit resume_queue(uv_loop_t* native_loop);
+
+  resume_queue(const resume_queue&) = delete;
+
+  // any thread
+  void push(std::coroutine_handle<> waiter);
+
+  // loop thread only, resumes everything pushed so far
+  void resumeAll();
+
+  // resumes what is left and closes the handle, after that nothing may be pushed anymore
+  void close(std::function<void()> cb);
+
+#ifdef UVPP_TASK_INCLUDE
+  task<void> close();
+#endif
+
+private:
+  std::mutex _mutex;
+  std::vector<std::coroutine_handle<>> _waiters;
+  uv::async _async;
+};
 } // namespace uv
@@ -0,0 +1,203 @@
+#pragma once
+
+#include "./error.hpp"
+#include "cppcoro/cancellation_registration.hpp"
+#include "cppcoro/operation_cancelled.hpp"
+#include "uv.h"
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <variant>
+
+namespace uv {
+namespace detail {
+// aborts a pending operation once `token` fires. the operation still completes through its own callback (usually with
+// UV_ECANCELED) and the awaiting coroutine then sees cppcoro::operation_cancelled. an operation that succeeded anyway
+// returns its result.
+// libuv is not thread safe, so cancellation has to be requested on the loop thread (see uv::deadline).
+struct cancellable {
+public:
+  cppcoro::cancellation_token token;
+
+  cancellable(cppcoro::cancellation_token t = {}) : token(std::move(t)) {
+  }
+
+  // has to be called after the operation was started, runs `cancel` right away if `token` already fired
+  template <typename F>
+  void cancelWith(F&& cancel) {
+    if (!token.can_be_cancelled()) {
+      return;
+    }
+
+    _registration.emplace(token, [this, cancel{std::forward<F>(cancel)}]() {
+      _cancelled = true;
+      cancel();
+    });
+  }
+
+protected:
+  // ends the registration, returns whether `token` fired while the operation was pending
+  bool wasCancelled() {
+    _registration.reset();
+    return _cancelled;
+  }
+
+private:
+  std::optional<cppcoro::cancellation_registration> _registration;
+  bool _cancelled = false;
+};
+
+// owns a native uv request for the duration of a co_await and resumes the awaiting coroutine straight from its
+// completion callback, so neither the request nor a trampoline coroutine has to be heap allocated
+template <typename N>
+struct req_awaiter : public cancellable {
+public:
+  N native_req;
+  int64_t result = 0;
+  std::coroutine_handle<> waiter;
+
+  req_awaiter(cppcoro::cancellation_token token = {}) : cancellable(std::move(token)) {
+    native_req.data = (void*)this;
+  }
+
+  req_awaiter(const req_awaiter&) = delete;
+
+  // an operation is never started once `token` fired, its handle may already be closed
+  bool await_ready() const {
+    token.throw_if_cancellation_requested();
+    return false;
+  }
+
+  // a request that completed despite the cancellation (e.g. an fs op already running) still returns its result
+  int64_t await_resume() {
+    bool cancelled = wasCancelled();
+
+    if (result < 0) {
+      if (cancelled) {
+        throw cppcoro::operation_cancelled{};
+      }
+
+      throw uv::error{(int)result};
+    }
+
+    return result;
+  }
+
+protected:
+  // only works for requests running on the threadpool (fs, getaddrinfo, work) that have not been picked up yet
+  void cancelWithUvCancel() {
+    cancelWith([this]() {
+      uv_cancel((uv_req_t*)&native_req);
+    });
+  }
+
+  static void resume(N* native_req, int status) {
+    auto self = (req_awaiter*)native_req->data;
+    self->result = status;
+    self->waiter.resume();
+  }
+
+  static void resume(N* native_req) {
+    auto self = (req_awaiter*)native_req->data;
+    self->result = native_req->result;
+    if constexpr (std::is_same_v<N, uv_fs_t>) {
+      uv_fs_req_cleanup(native_req);
+    }
+    self->waiter.resume();
+  }
+};
+
+// adapts a callback based operation, `start(awaiter)` has to eventually call resolve() or reject() exactly once
+template <typename T, typename S>
+struct callback_awaiter : public cancellable {
+public:
+  using value_type = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+  S start;
+
+  callback_awaiter(S s, cppcoro::cancellation_token token = {}) : cancellable(std::move(token)), start(std::move(s)) {
+  }
+
+  callback_awaiter(const callback_awaiter&) = delete;
+
+  bool await_ready() const {
+    token.throw_if_cancellation_requested();
+    return false;
+  }
+
+  bool await_suspend(std::coroutine_handle<> waiter) {
+    _waiter = waiter;
+
+    start(*this);
+    if (_done) {
+      return false;
+    }
+
+    _suspended = true;
+    return true;
+  }
+
+  // same as req_awaiter, only a failure turns into cppcoro::operation_cancelled
+  T await_resume() {
+    bool cancelled = wasCancelled();
+
+    if (_error) {
+      if (cancelled) {
+        throw cppcoro::operation_cancelled{};
+      }
+
+      std::rethrow_exception(_error);
+    }
+
+    if constexpr (!std::is_void_v<T>) {
+      return std::move(*_value);
+    }
+  }
+
+  template <typename... A>
+  void resolve(A&&... args) {
+    _value.emplace(std::forward<A>(args)...);
+    complete();
+  }
+
+  void reject(std::exception_ptr error) {
+    _error = error;
+    complete();
+  }
+
+  void reject(uv::error error) {
+    reject(std::make_exception_ptr(error));
+  }
+
+  void settle(uv::error error) {
+    if (error) {
+      reject(error);
+    } else {
+      resolve();
+    }
+  }
+
+private:
+  std::optional<value_type> _value;
+  std::exception_ptr _error;
+
+  std::coroutine_handle<> _waiter;
+  bool _suspended = false;
+  bool _done = false;
+
+  void complete() {
+    _done = true;
+
+    if (_suspended) {
+      _waiter.resume();
+    }
+  }
+};
+
+template <typename T = void, typename S>
+callback_awaiter<T, std::decay_t<S>> awaitCallback(S&& start, cppcoro::cancellation_token token = {}) {
+  return {std::forward<S>(start), std::move(token)};
+}
+} // namespace detail
+} // namespace uv
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "./error.hpp"
+#include "uv.h"
+#include <cstdint>
+#include <vector>
+
+namespace uv {
+struct buffer_pool_stats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t in_use = 0;
+  uint64_t idle = 0;
+};
+
+// recycles the read buffers of all streams on a loop instead of allocating 64 KiB per read.
+// there is one pool per loop, it is only ever touched from the thread running that loop.
+struct buffer_pool {
+public:
+  static constexpr size_t default_buffer_size = 65536;
+  static constexpr size_t default_capacity = 64;
+
+  buffer_pool(size_t buffer_size = default_buffer_size, size_t capacity = default_capacity);
+
+  buffer_pool(const buffer_pool&) = delete;
+
+  ~buffer_pool();
+
+  static buffer_pool& of(uv_loop_t* native_loop);
+
+  // `capacity` is the number of idle buffers kept around, only possible while no buffer is in use
+  void configure(size_t buffer_size, size_t capacity = default_capacity);
+
+  // requests larger than the buffer size bypass the pool
+  uv_buf_t acquire(size_t size);
+
+  void release(const uv_buf_t& buf) noexcept;
+
+  size_t bufferSize() const noexcept;
+
+  buffer_pool_stats stats() const noexcept;
+
+private:
+  size_t _buffer_size;
+  size_t _capacity;
+  std::vector<char*> _idle;
+  buffer_pool_stats _stats;
+
+  void clear() noexcept;
+};
+} // namespace uv
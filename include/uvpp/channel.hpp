@@ -0,0 +1,282 @@
+#pragma once
+
+#include "./async.hpp"
+#include "./error.hpp"
+#ifdef UVPP_TASK_INCLUDE
+#include UVPP_TASK_INCLUDE
+#endif
+#include "uv.h"
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace uv {
+// bounded multi producer single consumer queue delivering values to a coroutine on `native_loop`.
+// values are kept in a lock free ring, the receiving loop is only woken (once per batch) while its receiver sleeps.
+// producers may live on any thread, the channel itself has to be created, received from and destroyed on its loop.
+// the loops are never defaulted, a producer thread has no business touching the default loop
+template <typename T>
+class channel {
+public:
+  channel(size_t capacity, uv_loop_t* native_loop) : _async(native_loop) {
+    size_t size = 1;
+    while (size < capacity) {
+      size *= 2;
+    }
+
+    _mask = size - 1;
+    _cells = std::make_unique<cell[]>(size);
+    for (size_t i = 0; i < size; i++) {
+      _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    _async.start([this]() {
+      wakeReceiver();
+    });
+
+    // only a sleeping receiver keeps the loop alive
+    uv_unref(_async);
+  }
+
+  channel(const channel&) = delete;
+
+  channel& operator=(const channel&) = delete;
+
+  // any thread, the value is only moved from on success. false if the channel is full or closed
+  template <typename U>
+  bool trySend(U&& value) {
+    if (_closed.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    size_t position = _enqueue_position.load(std::memory_order_relaxed);
+    cell* target;
+    while (true) {
+      target = &_cells[position & _mask];
+      size_t sequence = target->sequence.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)sequence - (intptr_t)position;
+
+      if (diff == 0) {
+        if (_enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        position = _enqueue_position.load(std::memory_order_relaxed);
+      }
+    }
+
+    target->value.emplace(std::forward<U>(value));
+    target->sequence.store(position + 1, std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_receiver_sleeping.exchange(false)) {
+      _async.notify();
+    }
+
+    return true;
+  }
+
+  // loop thread only
+  std::optional<T> tryRecv() {
+    cell& source = _cells[_dequeue_position & _mask];
+    size_t sequence = source.sequence.load(std::memory_order_acquire);
+    if ((intptr_t)sequence - (intptr_t)(_dequeue_position + 1) < 0) {
+      return std::nullopt;
+    }
+
+    std::optional<T> result = std::move(source.value);
+    source.value.reset();
+    source.sequence.store(_dequeue_position + _mask + 1, std::memory_order_release);
+    _dequeue_position += 1;
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_senders_waiting.load() > 0) {
+      wakeSenders(1);
+    }
+
+    return result;
+  }
+
+#ifdef UVPP_TASK_INCLUDE
+  // any thread, waits on `native_loop` (the loop of the awaiting coroutine) while the channel is full.
+  // returns false if the channel was closed
+  task<bool> send(T value, uv_loop_t* native_loop) {
+    while (true) {
+      if (trySend(std::move(value))) {
+        co_return true;
+      }
+
+      if (_closed.load(std::memory_order_acquire)) {
+        co_return false;
+      }
+
+      co_await send_awaiter{*this, native_loop};
+    }
+  }
+
+  // loop thread only, one receiver at a time. returns std::nullopt once the channel is closed and empty
+  task<std::optional<T>> recv() {
+    while (true) {
+      if (auto result = tryRecv()) {
+        co_return result;
+      }
+
+      if (_closed.load(std::memory_order_acquire)) {
+        co_return tryRecv();
+      }
+
+      co_await recv_awaiter{*this};
+    }
+  }
+#endif
+
+  // any thread, wakes the receiver and all waiting senders
+  void close() {
+    _closed.store(true, std::memory_order_release);
+
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_receiver_sleeping.exchange(false)) {
+      _async.notify();
+    }
+
+    wakeSenders(SIZE_MAX);
+  }
+
+  bool isClosed() const noexcept {
+    return _closed.load(std::memory_order_acquire);
+  }
+
+  size_t capacity() const noexcept {
+    return _mask + 1;
+  }
+
+private:
+  struct cell {
+    std::atomic<size_t> sequence;
+    std::optional<T> value;
+  };
+
+  // parks a sender on its own loop until the receiver made space, a single use uv_async_t does the cross thread wakeup
+  struct send_awaiter {
+    channel& self;
+    uv_loop_t* native_loop;
+    uv_async_t native_async;
+    std::coroutine_handle<> waiter;
+
+    bool await_ready() const noexcept {
+      return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> w) {
+      waiter = w;
+
+      std::lock_guard lock{self._senders_mutex};
+      self._senders_waiting.fetch_add(1);
+
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (self.hasSpace() || self._closed.load()) {
+        self._senders_waiting.fetch_sub(1);
+        return false;
+      }
+
+      error::test(uv_async_init(native_loop, &native_async, [](uv_async_t* native_async) {
+        uv_close((uv_handle_t*)native_async, [](uv_handle_t* native_handle) {
+          ((send_awaiter*)native_handle->data)->waiter.resume();
+        });
+      }));
+      native_async.data = (void*)this;
+
+      self._senders.push_back(this);
+      return true;
+    }
+
+    void await_resume() const noexcept {
+    }
+  };
+
+  struct recv_awaiter {
+    channel& self;
+
+    bool await_ready() const noexcept {
+      return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> waiter) {
+      self._receiver = waiter;
+      self._receiver_sleeping.store(true);
+
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (self.hasValue() || self._closed.load()) {
+        // whoever resets the flag delivers the wakeup
+        if (self._receiver_sleeping.exchange(false)) {
+          self._receiver = nullptr;
+          return false;
+        }
+      }
+
+      uv_ref(self._async);
+      return true;
+    }
+
+    void await_resume() const noexcept {
+    }
+  };
+
+  std::unique_ptr<cell[]> _cells;
+  size_t _mask;
+
+  alignas(64) std::atomic<size_t> _enqueue_position = 0;
+  alignas(64) size_t _dequeue_position = 0;
+
+  std::atomic<bool> _closed = false;
+
+  uv::async _async;
+  std::coroutine_handle<> _receiver;
+  std::atomic<bool> _receiver_sleeping = false;
+
+  std::mutex _senders_mutex;
+  std::deque<send_awaiter*> _senders;
+  std::atomic<size_t> _senders_waiting = 0;
+
+  bool hasSpace() const noexcept {
+    size_t position = _enqueue_position.load(std::memory_order_relaxed);
+    size_t sequence = _cells[position & _mask].sequence.load(std::memory_order_acquire);
+    return sequence == position;
+  }
+
+  bool hasValue() const noexcept {
+    size_t sequence = _cells[_dequeue_position & _mask].sequence.load(std::memory_order_acquire);
+    return sequence == _dequeue_position + 1;
+  }
+
+  void wakeReceiver() {
+    // notifications may be stale, recv() checks the ring again after every wakeup
+    _receiver_sleeping.store(false);
+
+    if (auto receiver = std::exchange(_receiver, nullptr)) {
+      uv_unref(_async);
+      receiver.resume();
+    }
+  }
+
+  void wakeSenders(size_t count) {
+    std::lock_guard lock{_senders_mutex};
+
+    while (count > 0 && !_senders.empty()) {
+      auto sender = _senders.front();
+      _senders.pop_front();
+      _senders_waiting.fetch_sub(1);
+      count -= 1;
+
+      uv_async_send(&sender->native_async);
+    }
+  }
+};
+} // namespace uv
@@ -2,12 +2,19 @@
 
 #include "./error.hpp"
 #include "./req.hpp"
+#include "./wheel.hpp"
 #include "uv.h"
 #ifdef UVPP_TASK_INCLUDE
+#include "./awaiter.hpp"
 #include UVPP_TASK_INCLUDE
 #endif
+#include <cstdint>
 #include <functional>
+#include <list>
 #include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
 #include <variant>
 
 namespace uv {
@@ -20,8 +27,79 @@ void getaddrinfo(const std::string& node, const std::string& service, std::funct
     uv_loop_t* native_loop = uv_default_loop());
 
 #ifdef UVPP_TASK_INCLUDE
-task<uv::dns::addrinfo> getaddrinfo(
-    const std::string& node, const std::string& service, uv_loop_t* native_loop = uv_default_loop());
+task<uv::dns::addrinfo> getaddrinfo(std::string node, std::string service, uv_loop_t* native_loop = uv_default_loop(),
+    cppcoro::cancellation_token token = {});
 #endif
+
+// getaddrinfo() results of one loop. libuv does not expose record TTLs, so answers are kept for `ttl` milliseconds and
+// failures for `negative_ttl`. concurrent lookups of the same name share one getaddrinfo request.
+// once `max_size` names are cached the expired ones are dropped, or the one expiring first if none expired.
+// everything has to happen on the thread running the cache's loop.
+struct cache {
+public:
+  struct statistics {
+    // answered from a cached result
+    uint64_t hits = 0;
+    // answered from a cached failure
+    uint64_t negative_hits = 0;
+    // started a getaddrinfo request
+    uint64_t misses = 0;
+    // joined a pending getaddrinfo request
+    uint64_t coalesced = 0;
+  };
+
+  explicit cache(uv_loop_t* native_loop = uv_default_loop(), uint64_t ttl = 30000, uint64_t negative_ttl = 5000,
+      size_t max_size = 1024);
+
+  cache(const cache&) = delete;
+
+  cache& operator=(const cache&) = delete;
+
+  // one cache with the default TTLs per loop
+  static cache& of(uv_loop_t* native_loop);
+
+  // cached answers are delivered right away, before resolve() returns
+  void resolve(const std::string& node, const std::string& service, std::function<void(uv::dns::addrinfo, uv::error)> cb);
+
+#ifdef UVPP_TASK_INCLUDE
+  task<uv::dns::addrinfo> resolve(std::string node, std::string service, cppcoro::cancellation_token token = {});
+#endif
+
+  // expires all cached answers, pending lookups are not affected
+  void expire() noexcept;
+
+  size_t size() const noexcept;
+
+  const cache::statistics& stats() const noexcept;
+
+private:
+  using waiter = std::function<void(uv::dns::addrinfo, uv::error)>;
+
+  struct entry {
+    uv::dns::addrinfo addr;
+    uv::error error;
+    uint64_t expires = 0;
+    bool pending = false;
+    std::list<waiter> waiters;
+  };
+
+  uv_loop_t* _native_loop;
+  uint64_t _ttl;
+  uint64_t _negative_ttl;
+  size_t _max_size;
+
+  std::unordered_map<std::string, entry> _entries;
+  cache::statistics _stats;
+
+  // answers from the cache and returns nullopt, or queues `cb` and returns its position. a queued waiter is cancelled by
+  // clearing its callback, erasing it would miss one that complete() already took
+  std::optional<std::list<waiter>::iterator> lookup(
+      const std::string& node, const std::string& service, waiter cb);
+
+  void complete(entry& e, uv::dns::addrinfo addr, uv::error error);
+
+  // makes room for one more name, entries with a pending request are kept
+  void evict();
+};
 } // namespace dns
 } // namespace uv
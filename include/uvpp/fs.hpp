@@ -3,11 +3,14 @@
 #include "./error.hpp"
 #include "./req.hpp"
 #ifdef UVPP_TASK_INCLUDE
+#include "./awaiter.hpp"
 #include UVPP_TASK_INCLUDE
 #endif
 #include "uv.h"
 #include <functional>
+#include <string>
 #include <string_view>
+#include <vector>
 
 namespace uv {
 struct file {
@@ -35,9 +38,55 @@ private:
   uv_loop_t* _native_loop = nullptr;
 };
 
+// read-only private mapping of a whole file, unmapped on destruction.
+// the bytes can be handed to parsers as a string_view or to stream::write(bufs) without being copied
+struct mapped_file {
+public:
+  mapped_file() = default;
+
+  mapped_file(void* data, size_t size);
+
+  ~mapped_file();
+
+  mapped_file(const mapped_file&) = delete;
+
+  mapped_file(mapped_file&& o);
+
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  mapped_file& operator=(mapped_file&& o);
+
+  const char* data() const noexcept;
+
+  size_t size() const noexcept;
+
+  const char* begin() const noexcept;
+
+  const char* end() const noexcept;
+
+  std::string_view view() const noexcept;
+
+  operator std::string_view() const noexcept;
+
+  uv_buf_t buf() const noexcept;
+
+private:
+  void* _data = nullptr;
+  size_t _size = 0;
+};
+
+// libuv 1.45 to 1.47 hand the fs requests of a loop to io_uring by default where the kernel supports it. from 1.48 on
+// io_uring is off unless UV_USE_IO_URING=1 is set (see preferIoUring), everything else goes to the threadpool.
+// readAll() of many files keeps one request per file in flight at once, they share the ring (or the threadpool) instead
+// of being read one after another.
 namespace fs {
 using buf = uv_buf_t;
 
+// opts into the io_uring backend of libuv >= 1.48 unless UV_USE_IO_URING is set already. libuv reads the variable once,
+// so this has to run before the first loop is used. kernels without io_uring still fall back to the threadpool. it changes
+// the environment of the whole process, so it is left to the application to call
+void preferIoUring();
+
 void close(uv::file& file, std::function<void()> cb, uv_loop_t* native_loop = uv_default_loop());
 
 #ifdef UVPP_TASK_INCLUDE
@@ -48,7 +97,8 @@ void open(std::string_view path, int flags, int mode, std::function<void(uv::fil
     uv_loop_t* native_loop = uv_default_loop());
 
 #ifdef UVPP_TASK_INCLUDE
-task<uv::file> open(std::string_view path, int flags, int mode, uv_loop_t* native_loop = uv_default_loop());
+task<uv::file> open(std::string_view path, int flags, int mode, uv_loop_t* native_loop = uv_default_loop(),
+    cppcoro::cancellation_token token = {});
 #endif
 
 void read(uv_file file, std::function<void(std::string_view, uv::error)> cb, char* buf = nullptr, size_t buf_len = 0,
@@ -56,15 +106,48 @@ void read(uv_file file, std::function<void(std::string_view, uv::error)> cb, cha
 
 #ifdef UVPP_TASK_INCLUDE
 task<std::string_view> read(uv_file file, char* buf = nullptr, size_t buf_len = 0, int64_t offset = 0,
-    uv_loop_t* native_loop = uv_default_loop());
+    uv_loop_t* native_loop = uv_default_loop(), cppcoro::cancellation_token token = {});
+#endif
+
+#ifdef UVPP_TASK_INCLUDE
+task<uv_stat_t> stat(uv_file file, uv_loop_t* native_loop = uv_default_loop(), cppcoro::cancellation_token token = {});
+#endif
+
+#ifdef UVPP_TASK_INCLUDE
+task<uv_stat_t> stat(std::string_view path, uv_loop_t* native_loop = uv_default_loop(),
+    cppcoro::cancellation_token token = {});
+#endif
+
+// copies up to `length` bytes at `offset` of `in` to `out` in the kernel, returns the number of bytes sent.
+// throws UV_EAGAIN if `out` is a non-blocking socket with a full send buffer
+#ifdef UVPP_TASK_INCLUDE
+task<size_t> sendfile(uv_file out, uv_file in, int64_t offset, size_t length,
+    uv_loop_t* native_loop = uv_default_loop(), cppcoro::cancellation_token token = {});
+#endif
+
+// regular files are read with a single request into a string of the right size
+#ifdef UVPP_TASK_INCLUDE
+task<std::string> readAll(uv_file file, int64_t offset = 0, uv_loop_t* native_loop = uv_default_loop(),
+    cppcoro::cancellation_token token = {});
+#endif
+
+#ifdef UVPP_TASK_INCLUDE
+task<std::string> readAll(std::string_view path, int64_t offset = 0, uv_loop_t* native_loop = uv_default_loop(),
+    cppcoro::cancellation_token token = {});
 #endif
 
+// maps the file at `path` with a sequential access hint, empty files result in an empty mapping
 #ifdef UVPP_TASK_INCLUDE
-task<std::string> readAll(uv_file file, int64_t offset = 0, uv_loop_t* native_loop = uv_default_loop());
+task<uv::mapped_file> mapFile(std::string_view path, uv_loop_t* native_loop = uv_default_loop(),
+    cppcoro::cancellation_token token = {});
 #endif
 
+// reads all files concurrently, the results are in the order of `paths`. this is not one batched submission: every
+// file is an open, fstat, read and close of its own through readAll(path), all of them started before the first one
+// finished. whether they reach the kernel together is up to the fs backend of libuv (io_uring or the threadpool)
 #ifdef UVPP_TASK_INCLUDE
-task<std::string> readAll(std::string_view path, int64_t offset = 0, uv_loop_t* native_loop = uv_default_loop());
+task<std::vector<std::string>> readAll(std::vector<std::string> paths, uv_loop_t* native_loop = uv_default_loop(),
+    cppcoro::cancellation_token token = {});
 #endif
 } // namespace fs
 } // namespace uv
@@ -1,15 +1,18 @@
 #pragma once
 
 #ifdef UVPP_TASK_INCLUDE
+#include "./awaiter.hpp"
 #include UVPP_TASK_INCLUDE
 #endif
 #include "uv.h"
 #include <functional>
+#include <utility>
 
 namespace uv {
 struct handle {
 public:
   struct data {
+    bool closed = false;
     std::function<void()> close_cb;
 
     virtual ~data();
@@ -31,10 +34,15 @@ public:
 
   operator const uv_handle_t*() const noexcept;
 
+  uv_loop_t* loop() const noexcept;
+
   bool isActive() const noexcept;
 
   bool isClosing() const noexcept;
 
+  // the platform fd, throws for handle types without one
+  uv_os_fd_t fileno() const;
+
   virtual void close(std::function<void()> close_cb) noexcept;
 
 #ifdef UVPP_TASK_INCLUDE
@@ -42,6 +50,9 @@ public:
 #endif
 
 protected:
+  // exchanges the native handles, and with them the data, of two wrappers of the same type
+  void swapNative(handle& other) noexcept;
+
   template <typename R, typename T>
   static R* getData(const T* native_handle) {
 #if (UV_VERSION_MAJOR >= 1) && (UV_VERSION_MINOR >= 34)
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "./error.hpp"
+#include "./handle.hpp"
+#include "uv.h"
+#include <functional>
+
+namespace uv {
+struct idle : public handle {
+public:
+  struct data : public handle::data {
+    uv_idle_t* _native_idle;
+    std::function<void()> idle_cb;
+
+    data(uv_idle_t* native_idle);
+
+    virtual ~data();
+  };
+
+  idle(uv_loop_t* native_loop, uv_idle_t* native_idle);
+
+  idle(uv_loop_t* native_loop);
+
+  idle(uv_idle_t* native_idle);
+
+  idle();
+
+  idle(idle&& source) noexcept;
+
+  operator uv_idle_t*() noexcept;
+
+  operator const uv_idle_t*() const noexcept;
+
+  void start(std::function<void()> idle_cb);
+
+  void stop();
+
+private:
+  uv_idle_t* _native_idle;
+};
+} // namespace uv
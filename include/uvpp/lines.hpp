@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace uv {
+// splits a byte stream into lines terminated by "\n" or "\r\n".
+// lines that are complete within a chunk are passed as views into that chunk, only an unterminated rest is copied into
+// a carry buffer that keeps its capacity. the views are valid until the callback returns.
+struct line_splitter {
+public:
+  template <typename F>
+  void feed(std::string_view chunk, F&& cb) {
+    if (!_carry.empty()) {
+      auto newline = findNewline(chunk);
+      if (newline == nullptr) {
+        _carry.append(chunk);
+        return;
+      }
+
+      size_t length = newline - chunk.data();
+      _carry.append(chunk.data(), length);
+      chunk.remove_prefix(length + 1);
+
+      cb(trim(_carry));
+      _carry.clear();
+    }
+
+    while (true) {
+      auto newline = findNewline(chunk);
+      if (newline == nullptr) {
+        break;
+      }
+
+      size_t length = newline - chunk.data();
+      cb(trim(chunk.substr(0, length)));
+      chunk.remove_prefix(length + 1);
+    }
+
+    _carry.append(chunk);
+  }
+
+  // the unterminated rest of the fed data
+  std::string_view rest() const noexcept {
+    return _carry;
+  }
+
+  void reset() noexcept {
+    _carry.clear();
+  }
+
+private:
+  std::string _carry;
+
+  // memchr is vectorized by the libc, an empty view may not have a valid data() pointer
+  static const char* findNewline(std::string_view chunk) noexcept {
+    if (chunk.empty()) {
+      return nullptr;
+    }
+
+    return (const char*)std::memchr(chunk.data(), '\n', chunk.length());
+  }
+
+  static std::string_view trim(std::string_view line) noexcept {
+    if (line.ends_with('\r')) {
+      line.remove_suffix(1);
+    }
+
+    return line;
+  }
+};
+} // namespace uv
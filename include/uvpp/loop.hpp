@@ -1,9 +1,20 @@
 #pragma once
 
 #include "uv.h"
+#include <functional>
 
 namespace uv {
 inline int run() {
   return uv_run(uv_default_loop(), UV_RUN_DEFAULT);
 }
+
+namespace detail {
+// runs `release` once uv::release(native_loop) is called on this thread
+void atRelease(uv_loop_t* native_loop, std::function<void()> release);
+} // namespace detail
+
+// drops what the calling thread keeps for `native_loop` (buffer_pool::of, timer_wheel::of, dns::cache::of), so a loop
+// created later at the same address starts from scratch. call it on the thread that ran the loop after uv_run returned.
+// handles of the released state are closed, the loop has to run once more before uv_loop_close
+void release(uv_loop_t* native_loop);
 } // namespace uv
@@ -1,9 +1,14 @@
 #pragma once
 
+#include "./buffer.hpp"
+#include "./check.hpp"
 #include "./error.hpp"
 #include "./handle.hpp"
+#include "./idle.hpp"
+#include "./lines.hpp"
 #include "./req.hpp"
 #ifdef UVPP_TASK_INCLUDE
+#include "./awaiter.hpp"
 #include UVPP_TASK_INCLUDE
 #endif
 #ifdef UVPP_SSL_INCLUDE
@@ -11,15 +16,30 @@
 #endif
 #include "uv.h"
 #include <functional>
+#include <list>
+#include <memory>
+#include <span>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 namespace uv {
 struct stream : public handle {
 public:
   struct data : public handle::data {
     bool sent_eof = false;
+    size_t read_buffer_size = 0;
+
+    // queueWrite() state, write_queue_size counts queued and in flight bytes
+    std::vector<std::string> write_queue;
+    size_t write_queue_size = 0;
+    size_t write_low_watermark = 16 * 1024;
+    size_t write_high_watermark = 64 * 1024;
+    size_t writes_in_flight = 0;
+    uv::error write_error;
+    std::list<std::function<void(uv::error)>> drain_cbs;
 
     std::function<void(uv::error)> connection_cb;
     std::function<void(std::string_view, uv::error)> read_cb;
@@ -46,6 +66,9 @@ public:
 
   virtual void close(std::function<void()> close_cb) noexcept override;
 
+  // closes the stream and fails pending connects, reads and writes with UV_ECANCELED
+  void cancel() noexcept;
+
   void shutdown(std::function<void(uv::error)> cb);
 
 #ifdef UVPP_TASK_INCLUDE
@@ -63,17 +86,26 @@ public:
 #endif
 
 #ifdef UVPP_TASK_INCLUDE
-  task<void> readStartUntilEOF(std::function<void(std::string_view)> cb);
+  task<void> readStartUntilEOF(std::function<void(std::string_view)> cb, cppcoro::cancellation_token token = {});
 #endif
 
   void readStop();
 
+  // stops reading from the socket without ending the read, e.g. while the consumer is behind. readResume() continues
+  // with the same callback
+  void readSuspend();
+
+  void readResume();
+
+  // caps the bytes handed to a single read callback of this stream, 0 uses the loop's buffer_pool size
+  void readBufferSize(size_t size) noexcept;
+
   void readPause();
 
   void readLines(std::function<void(std::string&&, uv::error)> cb);
 
 #ifdef UVPP_TASK_INCLUDE
-  task<void> readLinesUntilEOF(std::function<void(std::string&&)> cb);
+  task<void> readLinesUntilEOF(std::function<void(std::string&&)> cb, cppcoro::cancellation_token token = {});
 
   // task<void> readLinesUntilEOF(std::function<task<void>(std::string&&)> cb) {
   //   return readLinesUntilEOF([this, cb{std::move(cb)}](auto&& line) {
@@ -82,16 +114,17 @@ public:
   // }
 #endif
 
+  // the views are only valid until `cb` returns
   void readLinesAsViews(std::function<void(std::string_view, uv::error)> cb);
 
 #ifdef UVPP_TASK_INCLUDE
-  task<void> readLinesAsViewsUntilEOF(std::function<void(std::string_view)> cb);
+  task<void> readLinesAsViewsUntilEOF(std::function<void(std::string_view)> cb, cppcoro::cancellation_token token = {});
 #endif
 
   void readAll(std::function<void(std::string&&, uv::error)> cb);
 
 #ifdef UVPP_TASK_INCLUDE
-  task<std::string> readAll();
+  task<std::string> readAll(cppcoro::cancellation_token token = {});
 #endif
 
 #ifdef UVPP_SSL_INCLUDE
@@ -107,9 +140,54 @@ public:
 #endif
 
 #ifdef UVPP_TASK_INCLUDE
-  task<void> write(std::string&& input);
+  task<void> write(std::string&& input, cppcoro::cancellation_token token = {});
+
+  task<void> write(std::string_view input, cppcoro::cancellation_token token = {});
+#endif
+
+  // sends all buffers with a single uv_write. they are borrowed and have to stay valid until the write completed
+#ifdef UVPP_SSL_INCLUDE
+  void write(std::span<const uv_buf_t> bufs, std::function<void(uv::error)> cb, bool encrypted = true);
+#else
+  void write(std::span<const uv_buf_t> bufs, std::function<void(uv::error)> cb);
+#endif
+
+#ifdef UVPP_TASK_INCLUDE
+  task<void> write(std::span<const uv_buf_t> bufs, cppcoro::cancellation_token token = {});
+#endif
 
-  task<void> write(std::string_view input);
+  // like write(bufs) but the chunks are kept alive by the stream until the write completed
+#ifdef UVPP_SSL_INCLUDE
+  void writev(std::vector<std::shared_ptr<const std::string>> chunks, std::function<void(uv::error)> cb,
+      bool encrypted = true);
+#else
+  void writev(std::vector<std::shared_ptr<const std::string>> chunks, std::function<void(uv::error)> cb);
+#endif
+
+#ifdef UVPP_TASK_INCLUDE
+  task<void> writev(std::vector<std::shared_ptr<const std::string>> chunks, cppcoro::cancellation_token token = {});
+#endif
+
+  // queues `input` to be sent together with everything else queued during this loop iteration as one vectored write.
+  // returns false once writeQueueSize() reached the high watermark, producers should wait for drain() then.
+  // a plain write() submits whatever is queued before its own data, so both can be mixed without reordering bytes
+  bool queueWrite(std::string&& input);
+
+  bool queueWrite(std::string_view input);
+
+  // writes what was queued right away instead of at the end of the loop iteration
+  void submitWriteQueue();
+
+  // bytes passed to queueWrite() that were not written yet
+  size_t writeQueueSize() const noexcept;
+
+  void writeWatermarks(size_t low, size_t high) noexcept;
+
+  // calls `cb` once writeQueueSize() is at or below the low watermark, or with the error that ended the queue
+  void drain(std::function<void(uv::error)> cb);
+
+#ifdef UVPP_TASK_INCLUDE
+  task<void> drain(cppcoro::cancellation_token token = {});
 #endif
 
   bool isReadable() const noexcept;
@@ -122,13 +200,16 @@ public:
   void handshake(std::function<void(uv::error)> cb);
 
 #ifdef UVPP_TASK_INCLUDE
-  task<void> handshake();
+  task<void> handshake(cppcoro::cancellation_token token = {});
 #endif
 
   ssl::state& sslState();
 #endif
 
 protected:
+  // only for streams that are neither reading nor writing, the queued writes belong to the wrapper
+  void swapNative(stream& other) noexcept;
+
 #ifdef UVPP_SSL_INCLUDE
   ssl::context* _ssl_context = nullptr;
   ssl::state _ssl_state;
@@ -136,5 +217,11 @@ protected:
 
 private:
   uv_stream_t* _native_stream;
+  std::unique_ptr<uv::check> _write_flush;
+  std::unique_ptr<uv::idle> _write_flush_idle;
+
+  void flushWriteQueue();
+
+  void startReading();
 };
 } // namespace uv
@@ -7,20 +7,41 @@
 #include UVPP_TASK_INCLUDE
 #endif
 #include "uv.h"
+#include <chrono>
+#include <cstdint>
 #include <functional>
 
 namespace uv {
+namespace detail {
+struct connect_race;
+}
+
 struct tcp : public stream {
 public:
   struct data : public stream::data {
     uv_tcp_t* _native_tcp;
     std::function<void()> tcp_cb;
+    bool reuse_port = false;
 
     data(uv_tcp_t* native_tcp);
 
     virtual ~data();
   };
 
+  // connect() counters of one loop, dropped by uv::release()
+  struct connect_statistics {
+    uint64_t connects = 0;
+    uint64_t failures = 0;
+    // sockets opened, more than one per connect() while candidates race
+    uint64_t attempts = 0;
+    // from the first attempt to the established connection, without DNS and TLS
+    std::chrono::nanoseconds connect_time{0};
+    std::chrono::nanoseconds max_connect_time{0};
+  };
+
+  // RFC 8305 connection attempt delay in milliseconds
+  static constexpr uint64_t connection_attempt_delay = 250;
+
   tcp(uv_loop_t* native_loop, uv_tcp_t* native_tcp);
 
   tcp(uv_loop_t* native_loop);
@@ -43,6 +64,10 @@ public:
 
   void simultaneousAccepts(bool enable);
 
+  // lets several handles, usually on different loops, bind the same address so the kernel balances connections between
+  // them. has to be enabled before bind()
+  void reusePort(bool enable);
+
   void bind(const sockaddr* addr, unsigned int flags = 0);
 
   void bind4(const char* ip, int port, unsigned int flags = 0);
@@ -53,25 +78,36 @@ public:
 
   std::string peername();
 
+  // races the addresses of `addr` (RFC 8305 happy eyeballs): IPv6 and IPv4 candidates are interleaved, the next one is
+  // started after connection_attempt_delay or as soon as the previous one failed. the first established connection is
+  // kept, all other attempts are closed. with more than one candidate this handle takes over the native handle of the
+  // winning attempt, so options like nodelay() have to be set after the connect
   void connect(uv::dns::addrinfo addr, std::function<void(uv::error)> cb);
 
 #ifdef UVPP_TASK_INCLUDE
-  task<void> connect(uv::dns::addrinfo addr);
+  task<void> connect(uv::dns::addrinfo addr, cppcoro::cancellation_token token = {});
 #endif
 
+  // `node` is resolved through uv::dns::cache::of(loop())
   void connect(const std::string& node, const std::string& service, std::function<void(uv::error)> cb);
 
 #ifdef UVPP_TASK_INCLUDE
-  task<void> connect(const std::string& node, const std::string& service);
+  task<void> connect(const std::string& node, const std::string& service, cppcoro::cancellation_token token = {});
 #endif
 
   void connect(const std::string& node, short port, std::function<void(uv::error)> cb);
 
 #ifdef UVPP_TASK_INCLUDE
-  task<void> connect(const std::string& node, short port);
+  task<void> connect(const std::string& node, short port, cppcoro::cancellation_token token = {});
 #endif
 
+  static tcp::connect_statistics& connectStats(uv_loop_t* native_loop = uv_default_loop());
+
 private:
+  friend struct detail::connect_race;
+
   uv_tcp_t* _native_tcp;
+
+  void swapNative(tcp& other) noexcept;
 };
 } // namespace uv
@@ -3,6 +3,7 @@
 #include "./error.hpp"
 #include "./handle.hpp"
 #ifdef UVPP_TASK_INCLUDE
+#include "./awaiter.hpp"
 #include UVPP_TASK_INCLUDE
 #endif
 #include "uv.h"
@@ -39,7 +40,7 @@ public:
   void startOnce(uint64_t timeout, std::function<void()> cb);
 
 #ifdef UVPP_TASK_INCLUDE
-  task<void> startOnce(uint64_t timeout);
+  task<void> startOnce(uint64_t timeout, cppcoro::cancellation_token token = {});
 #endif
 
   void stop();
@@ -57,6 +58,28 @@ private:
 void timeout(uint64_t timeout, std::function<void()> cb);
 
 #ifdef UVPP_TASK_INCLUDE
-task<void> timeout(uint64_t timeout);
+task<void> timeout(uint64_t timeout, cppcoro::cancellation_token token = {});
+
+// requests cancellation `timeout` milliseconds after construction, on the loop thread.
+// converts to a cancellation_token so it can be passed to any awaitable uvpp operation.
+struct deadline {
+public:
+  deadline(uint64_t timeout, uv_loop_t* native_loop = uv_default_loop());
+
+  deadline(const deadline&) = delete;
+
+  cppcoro::cancellation_token token() const noexcept;
+
+  operator cppcoro::cancellation_token() const noexcept;
+
+  bool expired() const noexcept;
+
+  // requests cancellation right away
+  void cancel();
+
+private:
+  cppcoro::cancellation_source _source;
+  uv::timer _timer;
+};
 #endif
 } // namespace uv
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "./error.hpp"
+#include "./timer.hpp"
+#ifdef UVPP_TASK_INCLUDE
+#include "./awaiter.hpp"
+#include UVPP_TASK_INCLUDE
+#endif
+#include "uv.h"
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+namespace uv {
+namespace detail {
+struct wheel_link {
+  wheel_link* prev = nullptr;
+  wheel_link* next = nullptr;
+};
+} // namespace detail
+
+// hierarchical timer wheel driving any number of timeouts with a single uv_timer_t.
+// 4 levels of 256 slots cover 2^32 ticks of `resolution` milliseconds, entries are intrusive so scheduling and
+// cancelling are O(1) and do not allocate. the uv timer is only armed for the next due slot and closed while idle.
+// everything has to happen on the thread running the wheel's loop.
+struct timer_wheel {
+public:
+  static constexpr size_t levels = 4;
+  static constexpr size_t slot_bits = 8;
+  static constexpr size_t slots = 1 << slot_bits;
+
+  // a timeout owned by the caller (e.g. embedded in a connection), destroying it cancels it
+  struct entry : private detail::wheel_link {
+  public:
+    std::function<void()> cb;
+
+    entry() = default;
+
+    entry(std::function<void()> cb);
+
+    entry(const entry&) = delete;
+
+    entry& operator=(const entry&) = delete;
+
+    ~entry();
+
+    bool active() const noexcept;
+
+  private:
+    friend timer_wheel;
+
+    timer_wheel* _wheel = nullptr;
+    uint64_t _expires = 0;
+  };
+
+  explicit timer_wheel(uv_loop_t* native_loop = uv_default_loop(), uint64_t resolution = 1);
+
+  timer_wheel(const timer_wheel&) = delete;
+
+  timer_wheel& operator=(const timer_wheel&) = delete;
+
+  // pending entries are cancelled without being called
+  ~timer_wheel();
+
+  // one wheel with a resolution of 1ms per loop
+  static timer_wheel& of(uv_loop_t* native_loop);
+
+  // (re)arms `e` to run its callback after `timeout` milliseconds
+  void schedule(entry& e, uint64_t timeout);
+
+  void schedule(entry& e, uint64_t timeout, std::function<void()> cb);
+
+  void cancel(entry& e) noexcept;
+
+  // number of pending entries
+  size_t size() const noexcept;
+
+#ifdef UVPP_TASK_INCLUDE
+  task<void> sleep(uint64_t timeout, cppcoro::cancellation_token token = {});
+#endif
+
+private:
+  uv_loop_t* _native_loop;
+  uint64_t _resolution;
+
+  uint64_t _current = 0;
+  uint64_t _next_tick = 0;
+  size_t _size = 0;
+
+  detail::wheel_link _slots[levels][slots];
+
+  std::optional<uv::timer> _timer;
+
+  uint64_t now() const noexcept;
+
+  void insert(entry& e) noexcept;
+
+  void remove(entry& e) noexcept;
+
+  void cascade(size_t level, size_t index) noexcept;
+
+  void advance(uint64_t tick);
+
+  void arm(uint64_t tick);
+
+  void onTimer();
+};
+} // namespace uv
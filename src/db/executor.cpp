@@ -0,0 +1,124 @@
+#include "db/executor.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace db {
+executor::executor(db::datasource& dsrc, size_t thread_count, std::function<void(std::coroutine_handle<>)> resume)
+    : _dsrc(dsrc), _resume(std::move(resume)) {
+  if (!_resume) {
+    throw std::invalid_argument{"executor requires a resume function"};
+  }
+
+  if (thread_count == 0) {
+    thread_count = 1;
+  }
+
+  // connections are opened on the calling thread, datasources do not have to support concurrent getConnection()
+  _workers.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; i++) {
+    auto& w = _workers.emplace_back(std::make_unique<worker>());
+    w->conn.emplace(_dsrc);
+  }
+
+  for (size_t i = 0; i < thread_count; i++) {
+    _workers[i]->thread = std::thread{[this, i]() {
+      loop(i);
+    }};
+  }
+}
+
+executor::~executor() {
+  stop();
+}
+
+void executor::post(std::function<void(db::connection&)> work, size_t affinity) {
+  {
+    std::lock_guard lock{_mutex};
+    if (_stopping) {
+      throw db::sql_error{"executor is stopped"};
+    }
+
+    auto& queue = affinity == any ? _queue : _workers[affinity % _workers.size()]->queue;
+    queue.push_back({std::move(work), std::chrono::steady_clock::now()});
+
+    _stats.queued += 1;
+  }
+
+  // any idle worker can take shared work, pinned work has to wake its specific worker
+  if (affinity == any) {
+    _cv.notify_one();
+  } else {
+    _cv.notify_all();
+  }
+}
+
+void executor::stop() {
+  {
+    std::lock_guard lock{_mutex};
+    if (_stopping) {
+      return;
+    }
+
+    _stopping = true;
+  }
+
+  _cv.notify_all();
+
+  for (auto& w : _workers) {
+    if (w->thread.joinable()) {
+      w->thread.join();
+    }
+
+    w->conn.reset();
+  }
+}
+
+size_t executor::size() const noexcept {
+  return _workers.size();
+}
+
+db::datasource& executor::datasource() noexcept {
+  return _dsrc;
+}
+
+executor::statistics executor::stats() const {
+  std::lock_guard lock{_mutex};
+  return _stats;
+}
+
+void executor::loop(size_t index) {
+  auto& self = *_workers[index];
+
+  std::unique_lock lock{_mutex};
+  while (true) {
+    _cv.wait(lock, [this, &self]() {
+      return _stopping || !self.queue.empty() || !_queue.empty();
+    });
+
+    auto& queue = !self.queue.empty() ? self.queue : _queue;
+    if (queue.empty()) {
+      break;
+    }
+
+    auto next = std::move(queue.front());
+    queue.pop_front();
+
+    auto wait_time = std::chrono::steady_clock::now() - next.posted;
+    _stats.queued -= 1;
+    _stats.running += 1;
+    _stats.wait_time += wait_time;
+    _stats.max_wait_time = std::max<std::chrono::nanoseconds>(_stats.max_wait_time, wait_time);
+
+    lock.unlock();
+    next.work(*self.conn);
+    lock.lock();
+
+    _stats.running -= 1;
+    _stats.completed += 1;
+  }
+}
+
+void executor::resume(std::coroutine_handle<> waiter) {
+  _resume(waiter);
+}
+} // namespace db
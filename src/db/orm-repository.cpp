@@ -7,30 +7,53 @@ repository::repository(db::connection& conn) : _conn{&conn, [](auto) {}} {
 repository::repository(db::datasource& dsrc) : _conn(std::make_shared<db::connection>(dsrc)) {
 }
 
+repository::repository(db::executor& executor) : _executor(&executor) {
+}
+
+async_repository repository::async(size_t affinity) {
+  if (_executor == nullptr) {
+    throw db::sql_error{"repository has no executor"};
+  }
+
+  return {*_executor, affinity};
+}
+
 orm::selector repository::select() {
-  orm::selector builder{*_conn};
+  orm::selector builder{conn()};
   builder.select();
   return builder;
 }
 
 orm::selector repository::select(const std::vector<orm::selection>& fields) {
-  orm::selector builder{*_conn};
+  orm::selector builder{conn()};
   builder.select(fields);
   return builder;
 }
 
 orm::inserter repository::insert() {
-  orm::inserter builder{*_conn};
+  orm::inserter builder{conn()};
   return builder;
 }
 
 orm::updater repository::update() {
-  orm::updater builder{*_conn};
+  orm::updater builder{conn()};
   return builder;
 }
 
 orm::deleter repository::remove() {
-  orm::deleter builder{*_conn};
+  orm::deleter builder{conn()};
   return builder;
 }
+
+db::connection& repository::conn() {
+  if (!_conn) {
+    _conn = std::make_shared<db::connection>(_executor->datasource());
+  }
+
+  return *_conn;
+}
+
+async_repository::async_repository(db::executor& executor, size_t affinity)
+    : _executor(executor), _affinity(affinity) {
+}
 } // namespace db::orm
@@ -1,18 +1,80 @@
 #include "http/common.hpp"
-#include <sstream>
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
 
 namespace http {
 namespace detail {
-namespace method {
-struct entry {
-  std::string_view name;
-  std::string_view text;
+constexpr uint32_t hash(std::string_view value) {
+  uint32_t result = 2166136261u;
+  for (char c : value) {
+    result = (result ^ (uint8_t)c) * 16777619u;
+  }
+
+  return result;
+}
+
+// open addressing table from names to values, filled by the compiler. `Size` is a power of 2 above the number of
+// entries, so lookups end at an empty slot after about one probe
+template <size_t Size>
+struct name_table {
+public:
+  struct entry {
+    std::string_view name;
+    int value;
+  };
+
+  // later duplicates of a name are skipped
+  template <size_t N>
+  constexpr name_table(const entry (&entries)[N]) {
+    static_assert(N < Size && (Size & (Size - 1)) == 0);
+
+    for (const auto& entry : entries) {
+      if (find(entry.name) != -1) {
+        continue;
+      }
+
+      size_t index = hash(entry.name) & (Size - 1);
+      while (!_slots[index].name.empty()) {
+        index = (index + 1) & (Size - 1);
+      }
+
+      _slots[index] = entry;
+    }
+  }
+
+  // -1 if `name` is unknown
+  constexpr int find(std::string_view name) const {
+    size_t index = hash(name) & (Size - 1);
+    while (!_slots[index].name.empty()) {
+      if (_slots[index].name == name) {
+        return _slots[index].value;
+      }
+
+      index = (index + 1) & (Size - 1);
+    }
+
+    return -1;
+  }
+
+private:
+  entry _slots[Size] = {};
 };
-std::unordered_map<http_method, entry> strings = {
-#define XX(num, name, string) {HTTP_##name, {#name, #string}},
+
+namespace method {
+// the values of HTTP_METHOD_MAP are 0..n without gaps
+constexpr std::string_view texts[] = {
+#define XX(num, name, string) #string,
     HTTP_METHOD_MAP(XX)
 #undef XX
 };
+
+// wire names (M-SEARCH) and enum names (MSEARCH)
+constexpr name_table<128> values{{
+#define XX(num, name, string) {#string, num}, {#name, num},
+    HTTP_METHOD_MAP(XX)
+#undef XX
+}};
 }
 }
 
@@ -20,34 +82,42 @@ method::method(_enum value) : _value{value} {}
 
 method::method(http_method value) : _value{(_enum)value} {}
 
-method::method(std::string_view value) {
-  for (const auto& [key, entry] : detail::method::strings) {
-    if (entry.name == value) {
-      _value = (_enum)key;
-      break;
-    }
-  }
-}
+method::method(std::string_view value) : _value{(_enum)detail::method::values.find(value)} {}
 
 method::operator http_method() const {
   return (http_method)_value;
 }
 
 method::operator std::string_view() const {
-  return detail::method::strings[(http_method)_value].text;
+  if ((size_t)_value >= std::size(detail::method::texts)) {
+    return {};
+  }
+
+  return detail::method::texts[_value];
 }
 
 namespace detail {
 namespace status {
-struct entry {
-  std::string_view name;
-  std::string_view text;
-};
-std::unordered_map<http_status, entry> strings = {
-#define XX(num, name, string) {HTTP_STATUS_##name, {#name, #string}},
+// " 200 OK\r\n", the status line behind the version
+constexpr std::string_view line(int code) {
+  switch (code) {
+#define XX(num, name, string) \
+  case num:                   \
+    return " " #num " " #string "\r\n";
     HTTP_STATUS_MAP(XX)
 #undef XX
-};
+    default:
+      return {};
+  }
+}
+
+constexpr name_table<128> values{{
+#define XX(num, name, string) {#name, num},
+    HTTP_STATUS_MAP(XX)
+#undef XX
+}};
+
+static_assert(line(404) == " 404 Not Found\r\n" && values.find("NOT_FOUND") == 404);
 }
 }
 
@@ -56,12 +126,8 @@ status::status(_enum value) : _value{value} {}
 status::status(http_status value) : _value{(_enum)value} {}
 
 status::status(std::string_view value) {
-  for (const auto& [key, entry] : detail::status::strings) {
-    if (entry.name == value) {
-      _value = (_enum)key;
-      break;
-    }
-  }
+  int code = detail::status::values.find(value);
+  _value = code != -1 ? (_enum)code : UNKNOWN;
 }
 
 status::operator http_status() const {
@@ -69,107 +135,99 @@ status::operator http_status() const {
 }
 
 status::operator std::string_view() const {
-  return detail::status::strings[(http_status)_value].text;
+  // " 200 OK\r\n" without the code and the line break
+  auto line = detail::status::line(_value);
+  if (line.empty()) {
+    return {};
+  }
+
+  return line.substr(5, line.length() - 7);
 }
 
 namespace detail {
-std::unordered_map<std::string_view, uint16_t> known_protocols = {
-  {"http", 80},
-  {"https", 443},
-  {"ws", 80},
-  {"wss", 443},
-};
-}
+constexpr uint16_t defaultPort(std::string_view schema) {
+  if (schema == "http" || schema == "ws") {
+    return 80;
+  }
+  if (schema == "https" || schema == "wss") {
+    return 443;
+  }
 
-url::url() {
+  return 0;
 }
 
-url::url(std::string_view str, bool in) {
-  http_parser_url parser;
-  http_parser_url_init(&parser);
-  http_parser_parse_url(str.data(), str.length(), in, &parser);
-
-  auto move = [&](http_parser_url_fields field, std::string& member) {
-    auto& data = parser.field_data[field];
+constexpr int hexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
 
-    if (data.len != 0) {
-      member = std::string_view{str.data() + data.off, data.len};
-    }
-  };
+  return -1;
+}
 
-  move(UF_SCHEMA, _schema);
-  move(UF_HOST, _host);
-  // move(UF_PORT, _port);
-  move(UF_PATH, _path);
-  std::string querystr;
-  move(UF_QUERY, querystr);
-  move(UF_FRAGMENT, _fragment);
+// everything but the unreserved characters of RFC 3986
+void appendEncoded(std::string& result, std::string_view value) {
+  constexpr char hex[] = "0123456789ABCDEF";
 
-  if (detail::known_protocols.contains(_schema)) {
-    _port = detail::known_protocols[_schema];
-  }
+  for (char chr : value) {
+    bool unreserved = (chr >= 'a' && chr <= 'z') || (chr >= 'A' && chr <= 'Z') || (chr >= '0' && chr <= '9') ||
+        chr == '-' || chr == '.' || chr == '_' || chr == '~';
 
-  if (parser.port != 0) {
-    _port = parser.port;
+    if (unreserved) {
+      result += chr;
+    } else {
+      result += '%';
+      result += hex[(uint8_t)chr >> 4];
+      result += hex[(uint8_t)chr & 0xf];
+    }
   }
+}
+} // namespace detail
 
-  if (querystr.length()) {
-    std::string name;
-    std::string value;
-    auto reading = &name;
-    char hex[3] = {0};
-
-    for (int i = 0; i <= querystr.length(); i++) {
-      char chr = querystr[i];
-
-      switch (chr) {
-        case '=':
-          reading = &value;
-          break;
+url::url() {
+}
 
-        case '&':
-        case '\0': {
-          _query[std::move(name)] = std::move(value);
-          reading = &name;
-          break;
-        }
+url::url(std::string_view str, bool in) : _data(str) {
+  http_parser_url parser;
+  http_parser_url_init(&parser);
+  http_parser_parse_url(str.data(), str.length(), in, &parser);
 
-        case '%':
-          hex[0] = querystr[++i];
-          hex[1] = querystr[++i];
-          hex[2] = '\0';
-          *reading += (char)std::stoi(hex, 0, 16);
-          break;
+  auto field = [&](http_parser_url_fields field) {
+    return slice{parser.field_data[field].off, parser.field_data[field].len};
+  };
 
-        case '+':
-          *reading += ' ';
-          break;
+  _schema = field(UF_SCHEMA);
+  _host = field(UF_HOST);
+  _path = field(UF_PATH);
+  _query = field(UF_QUERY);
+  _fragment = field(UF_FRAGMENT);
 
-        default:
-          *reading += chr;
-      }
-    }
-  }
+  _port = parser.port != 0 ? parser.port : detail::defaultPort(schema());
 }
 
 url::url(const char* str) : url(std::string_view{str}) {
 }
 
-const std::string& url::schema() const {
-  return _schema;
+std::string_view url::schema() const {
+  return view(_schema);
 }
 
 url& url::schema(std::string_view value) {
-  _schema = value;
+  assign(value, host(), path(), querystring(), fragment());
   return *this;
 }
 
-const std::string& url::host() const {
-  return _host;
+std::string_view url::host() const {
+  return view(_host);
 }
 
 url& url::host(std::string_view value) {
-  _host = value;
+  assign(schema(), value, path(), querystring(), fragment());
   return *this;
 }
 
@@ -182,140 +240,402 @@ url& url::port(uint16_t value) {
   return *this;
 }
 
-const std::string& url::path() const {
-  return _path;
+std::string_view url::path() const {
+  if (_path.length == 0) {
+    return "/";
+  }
+
+  return view(_path);
 }
 
 url& url::path(std::string_view value) {
-  _path = value;
+  assign(schema(), host(), value, querystring(), fragment());
   return *this;
 }
 
-const std::unordered_map<std::string, std::string>& url::query() const {
-  return _query;
+std::string_view url::querystring() const {
+  return view(_query);
+}
+
+std::unordered_map<std::string, std::string> url::query() const {
+  std::unordered_map<std::string, std::string> result;
+  std::string name_storage;
+  std::string value_storage;
+
+  queryeach([&](std::string_view name, std::string_view value) {
+    result[(std::string)decode(name, name_storage)] = decode(value, value_storage);
+  });
+
+  return result;
 }
 
-url& url::query(const std::unordered_map<std::string, std::string>& value) {
-  _query = value;
+url& url::query(const std::unordered_map<std::string, std::string>& map) {
+  std::string querystr;
+  for (const auto& [name, value] : map) {
+    if (!querystr.empty()) {
+      querystr += '&';
+    }
+
+    detail::appendEncoded(querystr, name);
+    querystr += '=';
+    detail::appendEncoded(querystr, value);
+  }
+
+  assign(schema(), host(), path(), querystr, fragment());
   return *this;
 }
 
-std::optional<std::string_view> url::queryvalue(const std::string& name) const {
-  if (_query.count(name)) {
-    return _query.at(name);
-  } else {
+std::optional<std::string> url::queryvalue(std::string_view name) const {
+  std::optional<std::string_view> value = rawqueryvalue(name);
+  if (!value) {
     return std::nullopt;
   }
+
+  std::string storage;
+  std::string_view decoded = decode(value.value(), storage);
+  if (decoded.data() == storage.data()) {
+    return storage;
+  }
+
+  return (std::string)decoded;
 }
 
-url& url::queryvalue(const std::string& name, std::string_view value) {
-  _query[name] = (std::string)value;
+url& url::queryvalue(std::string_view name, std::string_view value) {
+  // every earlier parameter of that name is dropped, the new one is appended
+  std::string querystr;
+  std::string storage;
+  queryeach([&](std::string_view parameter_name, std::string_view parameter_value) {
+    if (decode(parameter_name, storage) == name) {
+      return;
+    }
+
+    if (!querystr.empty()) {
+      querystr += '&';
+    }
+
+    querystr += parameter_name;
+    if (!parameter_value.empty()) {
+      querystr += '=';
+      querystr += parameter_value;
+    }
+  });
+
+  if (!querystr.empty()) {
+    querystr += '&';
+  }
+
+  detail::appendEncoded(querystr, name);
+  querystr += '=';
+  detail::appendEncoded(querystr, value);
+
+  assign(schema(), host(), path(), querystr, fragment());
   return *this;
 }
 
-const std::string& url::fragment() const {
-  return _fragment;
+std::string_view url::decode(std::string_view value, std::string& storage) {
+  auto escaped = std::find_if(value.begin(), value.end(), [](char chr) {
+    return chr == '%' || chr == '+';
+  });
+  if (escaped == value.end()) {
+    return value;
+  }
+
+  storage.clear();
+  storage.reserve(value.length());
+
+  for (size_t i = 0; i < value.length(); i++) {
+    char chr = value[i];
+
+    if (chr == '+') {
+      storage += ' ';
+    } else if (chr == '%' && i + 2 < value.length() && detail::hexValue(value[i + 1]) >= 0 &&
+        detail::hexValue(value[i + 2]) >= 0) {
+      storage += (char)(detail::hexValue(value[i + 1]) * 16 + detail::hexValue(value[i + 2]));
+      i += 2;
+    } else {
+      // a '%' without two hex digits is taken literally
+      storage += chr;
+    }
+  }
+
+  return storage;
+}
+
+std::string_view url::fragment() const {
+  return view(_fragment);
 }
 
 url& url::fragment(std::string_view value) {
-  _fragment = value;
+  assign(schema(), host(), path(), querystring(), value);
   return *this;
 }
 
 std::string url::fullpath() const {
-  std::string result = _path;
+  std::string_view querystr = querystring();
+  std::string_view fragmentstr = fragment();
+  std::string_view pathstr = path();
 
-  if (_query.size()) {
-    result += "?";
-    for (const auto& [key, value] : _query) {
-      if (*(std::end(result) - 1) != '?') {
-        result += '&';
-      }
-      result += key + '=';
-      for (auto chr : value) {
-        switch (chr) {
-          case '=':
-            result += "%3d";
-            break;
-          case '&':
-            result += "%26";
-            break;
-          case '/':
-            result += "%2f";
-            break;
-          case ' ':
-            result += "%20";
-            break;
-          default:
-            result += chr;
-        }
-      }
-    }
+  std::string result;
+  result.reserve(pathstr.length() + querystr.length() + fragmentstr.length() + 2);
+  result += pathstr;
+
+  if (!querystr.empty()) {
+    result += '?';
+    result += querystr;
   }
 
-  if (_fragment != "") {
-    result += "#" + _fragment;
+  if (!fragmentstr.empty()) {
+    result += '#';
+    result += fragmentstr;
   }
 
   return result;
 }
 
 url::operator std::string() const {
-  std::stringstream result;
+  std::string result;
+  std::string_view schemastr = schema();
+  std::string_view hoststr = host();
+
+  if (!hoststr.empty()) {
+    if (!schemastr.empty()) {
+      result += schemastr;
+      result += "://";
+    }
+
+    result += hoststr;
 
-  if (_host != "") {
-    if (_schema != "") {
-      result << _schema << "://";
+    if (_port != 0 && _port != detail::defaultPort(schemastr)) {
+      result += ':';
+      result += std::to_string(_port);
     }
+  }
+
+  result += fullpath();
+
+  return result;
+}
+
+std::string_view url::view(slice s) const {
+  return std::string_view{_data}.substr(s.offset, s.length);
+}
 
-    result << _host;
+std::optional<std::string_view> url::rawqueryvalue(std::string_view name) const {
+  std::optional<std::string_view> result;
+  std::string storage;
 
-    if (_port != 0) {
-      auto protocol_port = detail::known_protocols.find(_schema);
-      if (protocol_port == detail::known_protocols.end() || _port != protocol_port->second) {
-        result << ":" << _port;
+  queryeach([&](std::string_view parameter_name, std::string_view parameter_value) {
+    if (decode(parameter_name, storage) == name) {
+      result = parameter_value;
+    }
+  });
+
+  return result;
+}
+
+void url::assign(std::string_view schema, std::string_view host, std::string_view path, std::string_view query,
+    std::string_view fragment) {
+  // the views may point into _data, so the new text is built next to it
+  std::string data;
+  data.reserve(schema.length() + host.length() + path.length() + query.length() + fragment.length());
+
+  auto append = [&data](std::string_view value) {
+    slice result{(uint32_t)data.length(), (uint32_t)value.length()};
+    data += value;
+    return result;
+  };
+
+  _schema = append(schema);
+  _host = append(host);
+  _path = append(path);
+  _query = append(query);
+  _fragment = append(fragment);
+  _data = std::move(data);
+}
+
+body_stream::body_stream(std::shared_ptr<state> s) : _state(std::move(s)) {
+}
+
+body_stream::operator bool() const {
+  return (bool)_state;
+}
+
+void body_stream::next(std::function<void(std::optional<std::string>, std::exception_ptr)> cb) {
+  if (!_state) {
+    cb(std::nullopt, nullptr);
+    return;
+  }
+
+  auto& s = *_state;
+  if (!s.chunks.empty()) {
+    auto chunk = std::move(s.chunks.front());
+    s.chunks.pop_front();
+    s.buffered -= chunk.length();
+
+    // resume at half the watermark so the connection is not toggled for every chunk
+    if (s.paused && s.buffered <= s.high_watermark / 2) {
+      s.paused = false;
+      if (s.flow) {
+        s.flow(false);
       }
     }
+
+    cb(std::move(chunk), nullptr);
+  } else if (s.error) {
+    cb(std::nullopt, s.error);
+  } else if (s.ended) {
+    cb(std::nullopt, nullptr);
+  } else {
+    s.waiter = std::move(cb);
   }
+}
 
-  result << fullpath();
+#ifdef HTTPPP_TASK_INCLUDE
+HTTPPP_TASK_TYPE<std::optional<std::string>> body_stream::next() {
+  return HTTPPP_TASK_CREATE<std::optional<std::string>>([this](auto& resolve, auto& reject) {
+    next([resolve, reject](std::optional<std::string> chunk, std::exception_ptr error) {
+      if (error) {
+        reject(error);
+      } else {
+        resolve(chunk);
+      }
+    });
+  });
+}
 
-  return result.str();
+HTTPPP_TASK_TYPE<std::string> body_stream::readAll() {
+  std::string result;
+  while (auto chunk = co_await next()) {
+    result += *chunk;
+  }
+  co_return result;
 }
+#endif
 
-request::operator std::string() const {
-  return stringify(*this);
+void body_stream::push(std::string chunk) {
+  auto& s = *_state;
+  if (s.ended || s.error || chunk.empty()) {
+    return;
+  }
+
+  if (s.waiter) {
+    auto waiter = std::move(s.waiter);
+    s.waiter = nullptr;
+    waiter(std::move(chunk), nullptr);
+    return;
+  }
+
+  s.buffered += chunk.length();
+  s.chunks.push_back(std::move(chunk));
+
+  if (!s.paused && s.buffered > s.high_watermark) {
+    s.paused = true;
+    if (s.flow) {
+      s.flow(true);
+    }
+  }
 }
 
-std::string request::stringify(const request& r, const std::unordered_map<std::string, std::string>& headers) {
-  auto url = r.url;
-  if (r.method == method::CONNECT) {
-    url.schema("").path("").query({}).fragment("");
-  } else {
-    url.host("");
+void body_stream::end() {
+  auto& s = *_state;
+  if (s.ended || s.error) {
+    return;
   }
 
-  std::stringstream result;
+  s.ended = true;
 
-  result << (std::string)r.method << " ";
-  result << (std::string)url << " ";
-  result << "HTTP/" << (int)std::get<0>(r.version) << "." << (int)std::get<1>(r.version) << "\r\n";
+  if (s.waiter) {
+    auto waiter = std::move(s.waiter);
+    s.waiter = nullptr;
+    waiter(std::nullopt, nullptr);
+  }
+}
+
+void body_stream::fail(std::exception_ptr error) {
+  auto& s = *_state;
+  if (s.ended || s.error) {
+    return;
+  }
+
+  s.error = error ? error : std::make_exception_ptr(http::error{"body stream aborted"});
+  s.chunks.clear();
+  s.buffered = 0;
 
+  if (s.waiter) {
+    auto waiter = std::move(s.waiter);
+    s.waiter = nullptr;
+    waiter(std::nullopt, s.error);
+  }
+}
+
+bool body_stream::ended() const {
+  return !_state || _state->ended;
+}
+
+namespace detail {
+size_t headersSize(const http::headers& headers) {
+  size_t size = 0;
   for (const auto& [key, value] : headers) {
-    result << key << ": " << value << "\r\n";
+    size += key.length() + 2 + value.length() + 2;
   }
 
-  for (const auto& [key, value] : r.headers) {
-    result << key << ": " << value << "\r\n";
+  return size;
+}
+
+void appendHeaders(std::string& result, const http::headers& headers) {
+  for (const auto& [key, value] : headers) {
+    result += key;
+    result += ": ";
+    result += value;
+    result += "\r\n";
   }
+}
 
-  result << "\r\n";
+void appendVersion(std::string& result, std::tuple<uint8_t, uint8_t> version, std::string_view prefix) {
+  result += prefix;
+  result += (char)('0' + std::get<0>(version));
+  result += '.';
+  result += (char)('0' + std::get<1>(version));
+}
+} // namespace detail
 
-  if (r.body.length() > 0) {
-    result << r.body << "\r\n\r\n";
+request::operator std::string() const {
+  return stringify(*this);
+}
+
+std::string request::stringify(const request& r, const http::headers& headers) {
+  std::string target;
+  if (r.method == method::CONNECT) {
+    // "host:port", every url has at least the path "/"
+    target += r.url.host();
+    if (r.url.port() != 0) {
+      target += ':';
+      target += std::to_string(r.url.port());
+    }
+  } else {
+    auto url = r.url;
+    url.host("");
+    target = (std::string)url;
   }
 
-  return result.str();
+  std::string_view method = r.method;
+
+  size_t size = method.length() + 1 + target.length() + 11 + detail::headersSize(headers) +
+      detail::headersSize(r.headers) + 2 + r.body.length();
+
+  std::string result;
+  result.reserve(size);
+  result += method;
+  result += ' ';
+  result += target;
+  detail::appendVersion(result, r.version, " HTTP/");
+  result += "\r\n";
+  detail::appendHeaders(result, headers);
+  detail::appendHeaders(result, r.headers);
+  result += "\r\n";
+  result += r.body;
+
+  return result;
 }
 
 response::operator bool() const {
@@ -326,28 +646,46 @@ response::operator std::string() const {
   return stringify(*this);
 }
 
-std::string response::stringify(const response& r, const std::unordered_map<std::string, std::string>& headers) {
-  std::stringstream result;
+std::string response::head(std::string_view date) const {
+  return stringifyHead(*this, {}, date);
+}
 
-  result << "HTTP/" << (int)std::get<0>(r.version) << "." << (int)std::get<1>(r.version) << " ";
-  result << (int)r.status << " ";
-  result << (std::string)r.status << "\r\n";
+std::string response::stringify(const response& r, const http::headers& headers) {
+  std::string result = stringifyHead(r, headers, {}, r.body.length());
+  result += r.body;
 
-  for (const auto& [key, value] : headers) {
-    result << key << ": " << value << "\r\n";
-  }
+  return result;
+}
 
-  for (const auto& [key, value] : r.headers) {
-    result << key << ": " << value << "\r\n";
+std::string response::stringifyHead(
+    const response& r, const http::headers& headers, std::string_view date, size_t reserve_body) {
+  // the first line without "HTTP/x.y", as a literal for every known code
+  std::string_view status_line = detail::status::line(r.status);
+  char unknown_status_line[16];
+  if (status_line.empty()) {
+    int length = snprintf(unknown_status_line, sizeof(unknown_status_line), " %03d \r\n", (int)r.status % 1000);
+    status_line = {unknown_status_line, (size_t)length};
   }
 
-  result << "\r\n";
+  bool add_date = !date.empty() && headers.count("date") == 0 && r.headers.count("date") == 0;
 
-  if (r.body.length() > 0) {
-    result << r.body << "\r\n\r\n";
+  size_t size = 8 + status_line.length() + detail::headersSize(headers) + detail::headersSize(r.headers) +
+      (add_date ? 8 + date.length() : 0) + 2 + reserve_body;
+
+  std::string result;
+  result.reserve(size);
+  detail::appendVersion(result, r.version, "HTTP/");
+  result += status_line;
+  if (add_date) {
+    result += "date: ";
+    result += date;
+    result += "\r\n";
   }
+  detail::appendHeaders(result, headers);
+  detail::appendHeaders(result, r.headers);
+  result += "\r\n";
 
-  return result.str();
+  return result;
 }
 
 error::error(const std::string& s) : std::runtime_error(s) {
@@ -363,4 +701,28 @@ std::string error::errno_string(unsigned int code) {
   return std::string{http_errno_name((http_errno)code)} + ": " +
       std::string{http_errno_description((http_errno)code)};
 }
+
+namespace serve {
+std::string_view date() {
+  static constexpr std::string_view days[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+  static constexpr std::string_view months[] = {
+      "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+  thread_local time_t formatted_at = 0;
+  thread_local char formatted[30];
+
+  time_t now = time(nullptr);
+  if (now != formatted_at) {
+    tm utc;
+    gmtime_r(&now, &utc);
+
+    // strftime would use the names of the current locale
+    snprintf(formatted, sizeof(formatted), "%.3s, %02d %.3s %04d %02d:%02d:%02d GMT", days[utc.tm_wday].data(),
+        utc.tm_mday, months[utc.tm_mon].data(), utc.tm_year + 1900, utc.tm_hour, utc.tm_min, utc.tm_sec);
+    formatted_at = now;
+  }
+
+  return {formatted, 29};
+}
+} // namespace serve
 } // namespace http
@@ -4,13 +4,15 @@
 #include "http/gzip.hpp"
 #include "uvpp/async.hpp"
 #include "uvpp/tcp.hpp"
+#include "cppcoro/cancellation_registration.hpp"
 #ifdef HTTPPP_SSL_DRIVER_INCLUDE
 #include HTTPPP_SSL_DRIVER_INCLUDE
 #endif
 
 namespace http {
 #ifdef HTTPPP_TASK_INCLUDE
-HTTPPP_TASK_TYPE<http::response> fetch(http::request& request, uv::tcp& tcp) {
+namespace detail {
+HTTPPP_TASK_TYPE<http::response> fetch(http::request& request, uv::tcp& tcp, cppcoro::cancellation_token& token) {
   std::optional<http::request> proxy_request;
   if (!request.proxy.host.empty()) {
     proxy_request = http::request{
@@ -55,9 +57,10 @@ HTTPPP_TASK_TYPE<http::response> fetch(http::request& request, uv::tcp& tcp) {
   };
 
   if (proxy_request) {
-    co_await tcp.connect(request.proxy.host, request.proxy.port);
+    co_await tcp.connect(request.proxy.host, request.proxy.port, token);
   } else {
-    co_await tcp.connect(request.url.host(), request.url.port());
+    std::string host{request.url.host()};
+    co_await tcp.connect(host, request.url.port(), token);
     co_await sslHandshake();
   }
 
@@ -110,7 +113,7 @@ HTTPPP_TASK_TYPE<http::response> fetch(http::request& request, uv::tcp& tcp) {
     http::_2::handler<http::response> handler;
 
     handler.onSend([&](auto input) {
-      tcp.write((std::string)input).start();
+      tcp.queueWrite(input);
     });
     handler.onStreamEnd([&](auto, auto&&) {
       tcp.readStop();
@@ -150,17 +153,32 @@ HTTPPP_TASK_TYPE<http::response> fetch(http::request& request, uv::tcp& tcp) {
   }
 
 #ifdef HTTPPP_ZLIB
-  if (response.headers["content-encoding"] == "gzip") {
+  if (response.headers.value(http::headers::CONTENT_ENCODING) == "gzip") {
     http::gzip::uncompress(response.body);
   }
 #endif
 
   co_return response;
 }
+} // namespace detail
+
+HTTPPP_TASK_TYPE<http::response> fetch(http::request& request, uv::tcp& tcp, cppcoro::cancellation_token token) {
+  // aborting the connection fails whatever read or write is pending on it, the dns lookup is cancelled by connect()
+  cppcoro::cancellation_registration registration{token, [&tcp]() {
+    tcp.cancel();
+  }};
+
+  try {
+    co_return co_await detail::fetch(request, tcp, token);
+  } catch (...) {
+    token.throw_if_cancellation_requested();
+    throw;
+  }
+}
 
-HTTPPP_TASK_TYPE<http::response> fetch(http::request& request) {
+HTTPPP_TASK_TYPE<http::response> fetch(http::request& request, cppcoro::cancellation_token token) {
   uv::tcp tcp;
-  co_return co_await fetch(request, tcp);
+  co_return co_await fetch(request, tcp, std::move(token));
 }
 
 // HTTPPP_TASK_TYPE<http::response> fetch(const http::request& request) {
@@ -168,29 +186,31 @@ HTTPPP_TASK_TYPE<http::response> fetch(http::request& request) {
 //   co_return co_await fetch(_request);
 // }
 
-HTTPPP_TASK_TYPE<http::response> fetch(http_method m, http::url&& u, std::string&& b) {
+HTTPPP_TASK_TYPE<http::response> fetch(
+    http_method m, http::url&& u, std::string&& b, cppcoro::cancellation_token token) {
   http::request request{
     .method = m,
     .url = std::move(u),
     .body = std::move(b),
   };
-  co_return co_await fetch(request);
+  co_return co_await fetch(request, std::move(token));
 }
 
-HTTPPP_TASK_TYPE<http::response> fetch(http_method m, http::url&& u, const std::string& b) {
+HTTPPP_TASK_TYPE<http::response> fetch(
+    http_method m, http::url&& u, const std::string& b, cppcoro::cancellation_token token) {
   http::request request{
     .method = m,
     .url = std::move(u),
     .body = b,
   };
-  co_return co_await fetch(request);
+  co_return co_await fetch(request, std::move(token));
 }
 
-HTTPPP_TASK_TYPE<http::response> fetch(http::url&& u) {
+HTTPPP_TASK_TYPE<http::response> fetch(http::url&& u, cppcoro::cancellation_token token) {
   http::request request{
     .url = std::move(u),
   };
-  co_return co_await fetch(request);
+  co_return co_await fetch(request, std::move(token));
 }
 #endif
 } // namespace http
@@ -0,0 +1,179 @@
+#include "http/headers.hpp"
+#include <algorithm>
+
+namespace http {
+namespace detail {
+char lower(char c) noexcept {
+  return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c;
+}
+
+// `lowercase` has to be lowercase already
+bool iequals(std::string_view name, std::string_view lowercase) noexcept {
+  if (name.length() != lowercase.length()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < name.length(); i++) {
+    if (lower(name[i]) != lowercase[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+} // namespace detail
+
+headers::headers(std::initializer_list<value_type> fields) {
+  _fields.reserve(fields.size());
+
+  for (const auto& [name, value] : fields) {
+    (*this)[name] = value;
+  }
+}
+
+std::string& headers::operator[](std::string_view name) {
+  size_t index = indexOf(name);
+  if (index != _fields.size()) {
+    return _fields[index].second;
+  }
+
+  return append(name, {});
+}
+
+std::string_view headers::value(std::string_view name) const noexcept {
+  size_t index = indexOf(name);
+  if (index == _fields.size()) {
+    return {};
+  }
+
+  return _fields[index].second;
+}
+
+std::string_view headers::value(known name) const noexcept {
+  if (name == KNOWN_COUNT || _known[name] == 0) {
+    return {};
+  }
+
+  return _fields[_known[name] - 1].second;
+}
+
+headers::const_iterator headers::find(std::string_view name) const noexcept {
+  return _fields.begin() + indexOf(name);
+}
+
+size_t headers::count(std::string_view name) const noexcept {
+  return indexOf(name) != _fields.size() ? 1 : 0;
+}
+
+std::pair<headers::iterator, bool> headers::emplace(std::string_view name, std::string_view value) {
+  size_t index = indexOf(name);
+  if (index != _fields.size()) {
+    return {_fields.cbegin() + index, false};
+  }
+
+  append(name, value);
+  return {_fields.cend() - 1, true};
+}
+
+size_t headers::erase(std::string_view name) {
+  size_t index = indexOf(name);
+  if (index == _fields.size()) {
+    return 0;
+  }
+
+  _fields.erase(_fields.begin() + index);
+
+  // the positions behind the erased field moved
+  std::fill(std::begin(_known), std::end(_known), 0);
+  for (size_t i = 0; i < _fields.size(); i++) {
+    auto id = knownOf(_fields[i].first);
+    if (id != KNOWN_COUNT) {
+      _known[id] = i + 1;
+    }
+  }
+
+  return 1;
+}
+
+void headers::clear() noexcept {
+  _fields.clear();
+  std::fill(std::begin(_known), std::end(_known), 0);
+}
+
+void headers::reserve(size_t size) {
+  _fields.reserve(size);
+}
+
+size_t headers::size() const noexcept {
+  return _fields.size();
+}
+
+bool headers::empty() const noexcept {
+  return _fields.empty();
+}
+
+headers::const_iterator headers::begin() const noexcept {
+  return _fields.begin();
+}
+
+headers::const_iterator headers::end() const noexcept {
+  return _fields.end();
+}
+
+headers::known headers::knownOf(std::string_view name) noexcept {
+  switch (name.length()) {
+    case 4:
+      return detail::iequals(name, "host") ? HOST : KNOWN_COUNT;
+    case 10:
+      return detail::iequals(name, "connection") ? CONNECTION : KNOWN_COUNT;
+    case 12:
+      return detail::iequals(name, "content-type") ? CONTENT_TYPE : KNOWN_COUNT;
+    case 14:
+      return detail::iequals(name, "content-length") ? CONTENT_LENGTH : KNOWN_COUNT;
+    case 15:
+      return detail::iequals(name, "accept-encoding") ? ACCEPT_ENCODING : KNOWN_COUNT;
+    case 16:
+      return detail::iequals(name, "content-encoding") ? CONTENT_ENCODING : KNOWN_COUNT;
+    case 17:
+      return detail::iequals(name, "transfer-encoding") ? TRANSFER_ENCODING : KNOWN_COUNT;
+    default:
+      return KNOWN_COUNT;
+  }
+}
+
+size_t headers::indexOf(std::string_view name) const noexcept {
+  auto id = knownOf(name);
+  if (id != KNOWN_COUNT) {
+    return _known[id] != 0 ? _known[id] - 1 : _fields.size();
+  }
+
+  for (size_t i = 0; i < _fields.size(); i++) {
+    const auto& field = _fields[i].first;
+    if (field.length() == name.length() &&
+        std::equal(name.begin(), name.end(), field.begin(), [](char a, char b) {
+          return detail::lower(a) == b;
+        })) {
+      return i;
+    }
+  }
+
+  return _fields.size();
+}
+
+std::string& headers::append(std::string_view name, std::string_view value) {
+  if (_fields.empty()) {
+    // enough for most messages without growing
+    _fields.reserve(16);
+  }
+
+  auto& field = _fields.emplace_back(name, value);
+  std::transform(field.first.begin(), field.first.end(), field.first.begin(), detail::lower);
+
+  auto id = knownOf(field.first);
+  if (id != KNOWN_COUNT) {
+    _known[id] = _fields.size();
+  }
+
+  return field.second;
+}
+} // namespace http
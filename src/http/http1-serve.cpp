@@ -1,50 +1,330 @@
 #ifdef HTTPPP_TASK_INCLUDE
 #include "http/http1-serve.hpp"
+#include "finally.hpp"
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdio>
 
 namespace http::_1 {
-task<void> accept(uv::tcp& client, const http::serve::handler& callback) {
+namespace detail {
+// plaintext goes through sendfile. TLS needs the bytes in userspace, they are sent as encrypted chunks of one record
+task<void> writeFile(uv::tcp& client, const http::response::file_body& file) {
+  uint64_t offset = file.offset;
+  uint64_t end = file.offset + file.length;
+  std::string chunk;
+
+#ifdef UVPP_SSL_INCLUDE
+  bool encrypted = (bool)client.sslState();
+#else
+  bool encrypted = false;
+#endif
+
+  while (offset < end) {
+    if (!encrypted) {
+      try {
+        auto sent = co_await uv::fs::sendfile(client.fileno(), file.fd, offset, end - offset, client.loop());
+        if (sent == 0) {
+          throw uv::error{UV_EOF};
+        }
+
+        offset += sent;
+        continue;
+      } catch (const uv::error& error) {
+        if (error.code != UV_EAGAIN) {
+          throw;
+        }
+      }
+
+      // the send buffer is full, a regular write waits for the socket to drain before sendfile is tried again
+    }
+
+    chunk.resize(std::min<uint64_t>(end - offset, encrypted ? 16 * 1024 : 64 * 1024));
+    auto data = co_await uv::fs::read(file.fd, chunk.data(), chunk.length(), offset, client.loop());
+    if (data.empty()) {
+      // the file was truncated, the announced content-length can not be met anymore
+      throw uv::error{UV_EOF};
+    }
+
+    auto buf = uv_buf_init((char*)data.data(), data.length());
+    co_await client.write(std::span<const uv_buf_t>{&buf, 1});
+    offset += data.length();
+  }
+}
+
+// HTTP/1.1 frames every produced chunk, HTTP/1.0 has no chunked encoding so the end of the body is the end of the
+// connection. returns false if the connection has to be closed
+task<bool> writeProduced(uv::tcp& client, const http::request& request, http::response& response) {
+  bool chunked = request.version >= std::tuple<uint8_t, uint8_t>{1, 1};
+  response.headers.erase("content-length");
+  if (chunked) {
+    response.headers["transfer-encoding"] = "chunked";
+  } else {
+    response.headers["connection"] = "close";
+  }
+
+  auto head = response.head(http::serve::date());
+  auto buf = uv_buf_init(head.data(), head.length());
+  co_await client.write(std::span<const uv_buf_t>{&buf, 1});
+
+  if (request.method == http::HEAD) {
+    co_return chunked;
+  }
+
+  char size[24];
+  while (true) {
+    std::optional<std::string> chunk;
+    try {
+      chunk = co_await response.producer();
+    } catch (...) {
+      // the body can not be finished, the client sees the connection end before the last chunk
+      co_return false;
+    }
+    if (!chunk) {
+      break;
+    }
+
+    // an empty chunk would end the body
+    if (chunk->empty()) {
+      continue;
+    }
+
+    if (!chunked) {
+      auto buf = uv_buf_init(chunk->data(), chunk->length());
+      co_await client.write(std::span<const uv_buf_t>{&buf, 1});
+      continue;
+    }
+
+    int size_length = snprintf(size, sizeof(size), "%zx\r\n", chunk->length());
+    std::array<uv_buf_t, 3> bufs = {
+        uv_buf_init(size, size_length),
+        uv_buf_init(chunk->data(), chunk->length()),
+        uv_buf_init((char*)"\r\n", 2),
+    };
+    co_await client.write(bufs);
+  }
+
+  if (chunked) {
+    auto buf = uv_buf_init((char*)"0\r\n\r\n", 5);
+    co_await client.write(std::span<const uv_buf_t>{&buf, 1});
+  }
+
+  co_return chunked;
+}
+
+// HTTP/1.1 connections stay open unless the client asks to close them, HTTP/1.0 ones only if it asks to keep them
+bool keepAlive(const http::request& request) {
+  auto connection = request.headers.find("connection");
+  if (connection == request.headers.end()) {
+    return request.version >= std::tuple<uint8_t, uint8_t>{1, 1};
+  }
+
+  auto equals = [&connection](std::string_view token) {
+    return std::equal(connection->second.begin(), connection->second.end(), token.begin(), token.end(), [](char a, char b) {
+      return std::tolower((unsigned char)a) == b;
+    });
+  };
+
+  if (request.version >= std::tuple<uint8_t, uint8_t>{1, 1}) {
+    return !equals("close");
+  }
+
+  return equals("keep-alive");
+}
+
+// answers a request that can not be read any further (a body above options::max_body_size or a malformed request).
+// the rest of the connection is never read, so it is closed afterwards
+task<void> refuse(uv::tcp& client, http::status status) {
+  if (client.isClosing()) {
+    co_return;
+  }
+
+  http::response response;
+  response.status = status;
+  response.headers["content-length"] = "0";
+  response.headers["connection"] = "close";
+
+  auto head = response.head(http::serve::date());
+  auto buf = uv_buf_init(head.data(), head.length());
+  co_await client.write(std::span<const uv_buf_t>{&buf, 1});
+  co_await client.shutdown();
+}
+} // namespace detail
+
+task<void> accept(uv::tcp& client, const http::serve::handler& callback, http::serve::options options) {
   auto sockname = client.sockname();
   auto peername = client.peername();
 
+  // one parser for the whole connection. pipelined requests wait in it until the response before them was written, so
+  // responses go out in the order of the requests
+  http::_1::parser<http::request> parser;
+  parser.maxBodySize(options.max_body_size);
+
+  if (options.stream_bodies) {
+    parser.streamBody(
+        [&client](bool pause) {
+          if (pause) {
+            client.readSuspend();
+          } else {
+            client.readResume();
+          }
+        },
+        options.body_high_watermark);
+  }
+
+  // the client outlives the parser and still reports EOF to this callback once it is closed
+  auto parsing = std::make_shared<bool>(true);
+  finally stop_parsing{[parsing]() {
+    *parsing = false;
+  }};
+
+  // ends the read like an EOF, which ends the loop below. it only runs until the next request head arrived, a slow body
+  // is no idle connection
+  uv::timer_wheel::entry idle{[&client]() {
+    client.readStop();
+  }};
+
+  bool pipeline_full = false;
+  client.readStart([&, parsing](auto chunk, auto error) {
+    if (!*parsing) {
+      return;
+    }
+
+    if (error) {
+      parser.close();
+      return;
+    }
+
+    parser.execute(chunk);
+    if (parser.headersComplete()) {
+      uv::timer_wheel::of(client.loop()).cancel(idle);
+    }
+    if (parser.pending() > options.pipeline_buffer_size) {
+      pipeline_full = true;
+      client.readSuspend();
+    }
+  });
+
+  size_t served = 0;
   while (true) {
-    http::_1::parser<http::request> parser;
+    // a pipelined head may already be parsed
+    if (options.keep_alive_timeout != 0 && !parser.headersComplete()) {
+      uv::timer_wheel::of(client.loop()).schedule(idle, options.keep_alive_timeout);
+    }
 
-    client.readStart([&](auto chunk, auto error) {
-      if (error) {
-        parser.close();
+    http::request request;
+    bool malformed = false;
+    try {
+      if (options.stream_bodies) {
+        request = co_await parser.onHeaders();
       } else {
-        parser.execute(chunk);
+        request = co_await parser.onComplete();
       }
-    });
+    } catch (const http::error&) {
+      malformed = !parser.bodyTooLarge();
+    }
+
+    uv::timer_wheel::of(client.loop()).cancel(idle);
 
-    http::request request = co_await parser.onComplete();
-    if (!parser) {
+    if (parser.bodyTooLarge() || malformed) {
+      http::status status = malformed ? http::BAD_REQUEST : http::status::PAYLOAD_TOO_LARGE;
+      co_await detail::refuse(client, status);
+      break;
+    }
+    if (options.stream_bodies ? !parser.headersComplete() : !parser) {
       break;
     }
 
-    request.headers[":peername"] = peername;
-    if (request.headers[":peername"] == sockname) {
-      if (request.headers.count("x-forwarded-for") != 0) {
-        request.headers[":peername"] = request.headers["x-forwarded-for"];
-      }
+    // behind a proxy on the same host the peer is the proxy. the value is copied before the field is added, which may
+    // move the other fields
+    auto forwarded_for = request.headers.find("x-forwarded-for");
+    if (peername == sockname && forwarded_for != request.headers.end()) {
+      request.headers[":peername"] = std::string{forwarded_for->second};
+    } else {
+      request.headers[":peername"] = peername;
     }
 
     http::response response;
-    co_await callback(request, response);
+    bool body_failed = false;
+    try {
+      co_await callback(request, response);
+    } catch (...) {
+      // a streamed body that exceeded the limit or was cut off by the client fails the handler's reads
+      if (!options.stream_bodies || parser) {
+        throw;
+      }
 
-    // request.headers["connection"] = "close";
-    // response.headers["connection"] = "close";
+      body_failed = true;
+    }
+
+    if (parser.bodyTooLarge()) {
+      co_await detail::refuse(client, http::status::PAYLOAD_TOO_LARGE);
+      break;
+    }
+    if (body_failed) {
+      break;
+    }
+
+    served += 1;
+
+    // the rest of a body the handler did not wait for is not read just to be thrown away
+    bool keep_alive = detail::keepAlive(request) && parser &&
+        (options.max_requests_per_connection == 0 || served < options.max_requests_per_connection);
+    auto connection = response.headers.find("connection");
+    if (connection != response.headers.end() && connection->second == "close") {
+      keep_alive = false;
+    }
+
+    if (!keep_alive) {
+      response.headers["connection"] = "close";
+    } else if (request.version < std::tuple<uint8_t, uint8_t>{1, 1}) {
+      response.headers["connection"] = "keep-alive";
+    }
 
-    if (client.isActive()) {
-      co_await client.write((std::string)response);
+    if (client.isClosing()) {
+      break;
+    }
+
+    // a client that went away fails the write
+    bool written = true;
+    try {
+      if (response.producer) {
+        keep_alive = co_await detail::writeProduced(client, request, response) && keep_alive;
+      } else if (response.file) {
+        auto head = response.head(http::serve::date());
+        auto buf = uv_buf_init(head.data(), head.length());
+        co_await client.write(std::span<const uv_buf_t>{&buf, 1});
 
-      if (request.headers["connection"] == "close") {
-        co_await client.shutdown();
-        break;
+        if (request.method != http::HEAD) {
+          co_await detail::writeFile(client, *response.file);
+        }
+      } else {
+        // the body is sent straight from the response instead of being copied behind the headers. anything behind
+        // content-length would be taken for the start of the next response
+        auto head = response.head(http::serve::date());
+        std::array<uv_buf_t, 2> bufs = {
+            uv_buf_init(head.data(), head.length()),
+            uv_buf_init(response.body.data(), request.method == http::HEAD ? 0 : response.body.length()),
+        };
+        co_await client.write(bufs);
       }
-    } else {
+    } catch (const uv::error&) {
+      written = false;
+    }
+
+    if (!written) {
+      break;
+    }
+    if (!keep_alive) {
+      co_await client.shutdown();
       break;
     }
+
+    parser.next();
+    if (pipeline_full) {
+      pipeline_full = false;
+      client.readResume();
+    }
   }
 }
 }
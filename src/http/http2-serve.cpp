@@ -1,23 +1,111 @@
 #ifdef HTTPPP_TASK_INCLUDE
 #ifdef HTTPPP_HTTP2
 #include "http/http2-serve.hpp"
+#include "finally.hpp"
 
 namespace http::_2 {
+namespace detail {
+// the streams of a connection are started detached, accept() waits for all of them before the handler and the client
+// go away
+struct connection_state {
+  bool closed = false;
+  size_t streams = 0;
+  std::function<void()> on_idle;
+};
+
+// HTTP/2 frames a file body like a produced one, the next chunk is only read once nghttp2 took the one before
+task<std::optional<std::string>> readFileChunk(http::response::file_body& file, uv_loop_t* native_loop) {
+  if (file.length == 0) {
+    co_return std::nullopt;
+  }
+
+  std::string chunk(std::min<uint64_t>(file.length, 64 * 1024), '\0');
+  auto data = co_await uv::fs::read(file.fd, chunk.data(), chunk.length(), file.offset, native_loop);
+  if (data.empty()) {
+    // the file was truncated, the announced content-length can not be met anymore
+    throw uv::error{UV_EOF};
+  }
+
+  chunk.resize(data.length());
+  file.offset += data.length();
+  file.length -= data.length();
+  co_return std::move(chunk);
+}
+
+// `connection.closed` is checked after every co_await, the handler and the client must not be used once it is set
+task<void> respond(uv::tcp& client, http::_2::handler<http::request>& handler, const http::serve::handler& callback,
+    int32_t id, http::request& request, connection_state& connection) {
+  http::response response;
+  co_await callback(request, response);
+  if (connection.closed) {
+    co_return;
+  }
+
+  if (response.file) {
+    if (request.method != http::HEAD) {
+      auto file = std::make_shared<http::response::file_body>(std::move(*response.file));
+      auto native_loop = client.loop();
+      response.producer = [file, native_loop]() {
+        return readFileChunk(*file, native_loop);
+      };
+    }
+
+    response.file.reset();
+  }
+
+  if (request.method == http::HEAD || (!response.producer && response.body.empty())) {
+    response.body.clear();
+    handler.submitResponse(id, response, []() {});
+    handler.sendSession();
+    co_return;
+  }
+
+  // every body goes out through writeData, which is failed once the stream or the connection is closed
+  handler.submitStreamingResponse(id, response);
+  handler.sendSession();
+
+  if (!response.producer) {
+    co_await handler.writeData(id, std::move(response.body), true);
+    co_return;
+  }
+
+  while (true) {
+    auto chunk = co_await response.producer();
+    if (connection.closed) {
+      co_return;
+    }
+
+    bool eof = !chunk;
+    std::string data;
+    if (chunk) {
+      data = std::move(*chunk);
+    }
+
+    bool written = co_await handler.writeData(id, std::move(data), eof);
+    if (connection.closed || !written || eof) {
+      co_return;
+    }
+
+    co_await client.drain();
+    if (connection.closed) {
+      co_return;
+    }
+  }
+}
+} // namespace detail
+
 task<void> accept(uv::tcp& client, const http::serve::handler& callback) {
   http::_2::handler<http::request> handler;
 
   handler.onSend([&](auto input) {
-    client.write((std::string)input).start();
+    client.queueWrite(input);
   });
 
-  std::unordered_map<int32_t, std::function<void()>> on_close;
+  detail::connection_state connection;
 
   client.readStart([&](auto chunk, auto error) {
     if (error) {
-      for (auto& [key, fn] : on_close) {
-        fn();
-      }
-
+      connection.closed = true;
       handler.close();
     } else {
       handler.execute(chunk);
@@ -28,26 +116,28 @@ task<void> accept(uv::tcp& client, const http::serve::handler& callback) {
   handler.sendSession();
 
   handler.onStreamEnd([&](int32_t id, http::request&& request) {
-    task<>::run([&handler, &callback, id, &request, &on_close]() -> task<void> {
-      bool closed = false;
-      on_close.emplace(id, [&closed]() {
-        closed = true;
-      });
-
-      http::request _request = std::move(request);
-      http::response _response;
-      co_await callback(_request, _response);
-
-      if (closed) {
-        co_return;
-      } else {
-        on_close.erase(id);
-      }
+    connection.streams += 1;
 
-      auto on_sent = handler.submitResponse(id, _response);
-      handler.sendSession();
-      co_await on_sent;
-    });
+    // parameters instead of captures, the lambda itself is gone once the task first suspends
+    [](uv::tcp& client, http::_2::handler<http::request>& handler, const http::serve::handler& callback, int32_t id,
+        http::request _request, detail::connection_state& connection) -> task<void> {
+      finally done{[&connection]() {
+        connection.streams -= 1;
+        if (connection.streams == 0 && connection.on_idle) {
+          connection.on_idle();
+        }
+      }};
+
+      try {
+        co_await detail::respond(client, handler, callback, id, _request, connection);
+      } catch (...) {
+        // a failed handler or producer ends its own stream only
+        if (!connection.closed) {
+          handler.resetStream(id);
+          handler.sendSession();
+        }
+      }
+    }(client, handler, callback, id, std::move(request), connection).start();
   });
 
   co_await handler.onComplete();
@@ -55,6 +145,21 @@ task<void> accept(uv::tcp& client, const http::serve::handler& callback) {
     // throw http::error{"unexpected EOF"};
   }
 
+  // a session that ended by itself still has the read callback, which refers to this frame
+  client.readStop();
+  connection.closed = true;
+
+  // streams waiting for nghttp2 return right away, the others once their handler or producer did
+  handler.cancelWrites();
+  if (connection.streams != 0) {
+    co_await HTTPPP_TASK_CREATE<void>([&connection](auto& resolve, auto&) {
+      connection.on_idle = resolve;
+    });
+  }
+
+  // the last stream or the handler itself may have resumed this from inside its callbacks
+  co_await uv::timer_wheel::of(client.loop()).sleep(0);
+
   if (client.isActive()) {
     co_await client.shutdown();
   }
@@ -1,11 +1,257 @@
 #ifdef HTTPPP_TASK_INCLUDE
 #include "http/serve.hpp"
+#include "cppcoro/cancellation_registration.hpp"
+#include <charconv>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
 namespace http::serve {
-void listen(uv::tcp& server, http::serve::handler&& callback) {
-  server.listen([&server, callback{std::move(callback)}](auto error) {
-    task<>::run([&]() -> task<void> {
-      uv::tcp client;
+namespace detail {
+struct file_metadata {
+  uint64_t size = 0;
+  std::string etag;
+  uint64_t checked_at = 0;
+};
+
+// shared by all loops of a multi loop server
+struct file_metadata_cache_t {
+  static constexpr uint64_t ttl = 1000000000;
+  static constexpr size_t max_size = 4096;
+
+  std::mutex mutex;
+  std::unordered_map<std::string, file_metadata> entries;
+};
+
+file_metadata_cache_t file_metadata_cache;
+
+std::optional<file_metadata> findFileMetadata(const std::string& path) {
+  auto& cache = file_metadata_cache;
+  std::lock_guard lock{cache.mutex};
+
+  auto entry = cache.entries.find(path);
+  if (entry == cache.entries.end() || uv_hrtime() - entry->second.checked_at > cache.ttl) {
+    return std::nullopt;
+  }
+
+  return entry->second;
+}
+
+file_metadata storeFileMetadata(const std::string& path, const uv_stat_t& info) {
+  char etag[64];
+  auto length = snprintf(etag, sizeof(etag), "\"%llx-%llx\"",
+      (unsigned long long)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec, (unsigned long long)info.st_size);
+
+  file_metadata metadata{info.st_size, std::string{etag, (size_t)length}, uv_hrtime()};
+
+  auto& cache = file_metadata_cache;
+  std::lock_guard lock{cache.mutex};
+
+  if (cache.entries.size() >= cache.max_size) {
+    cache.entries.clear();
+  }
+  cache.entries[path] = metadata;
+
+  return metadata;
+}
+
+void eraseFileMetadata(const std::string& path) {
+  auto& cache = file_metadata_cache;
+  std::lock_guard lock{cache.mutex};
+
+  cache.entries.erase(path);
+}
+
+std::string_view contentType(std::string_view path) {
+  static const std::unordered_map<std::string_view, std::string_view> types = {
+      {"html", "text/html; charset=utf-8"},
+      {"css", "text/css; charset=utf-8"},
+      {"js", "text/javascript; charset=utf-8"},
+      {"json", "application/json"},
+      {"txt", "text/plain; charset=utf-8"},
+      {"svg", "image/svg+xml"},
+      {"png", "image/png"},
+      {"jpg", "image/jpeg"},
+      {"jpeg", "image/jpeg"},
+      {"gif", "image/gif"},
+      {"webp", "image/webp"},
+      {"ico", "image/x-icon"},
+      {"woff2", "font/woff2"},
+      {"wasm", "application/wasm"},
+  };
+
+  auto dot = path.rfind('.');
+  if (dot != std::string_view::npos) {
+    auto type = types.find(path.substr(dot + 1));
+    if (type != types.end()) {
+      return type->second;
+    }
+  }
+
+  return "application/octet-stream";
+}
+
+bool matchesETag(std::string_view header, std::string_view etag) {
+  while (!header.empty()) {
+    auto comma = header.find(',');
+    auto candidate = header.substr(0, comma);
+    header = comma == std::string_view::npos ? std::string_view{} : header.substr(comma + 1);
+
+    while (!candidate.empty() && candidate.front() == ' ') {
+      candidate.remove_prefix(1);
+    }
+    while (!candidate.empty() && candidate.back() == ' ') {
+      candidate.remove_suffix(1);
+    }
+
+    // If-None-Match uses the weak comparison
+    if (candidate.starts_with("W/")) {
+      candidate.remove_prefix(2);
+    }
+
+    if (candidate == "*" || candidate == etag) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+std::optional<byte_range> parseRange(std::string_view header, uint64_t size) {
+  if (!header.starts_with("bytes=") || header.find(',') != std::string_view::npos) {
+    return std::nullopt;
+  }
+  header.remove_prefix(6);
+
+  auto dash = header.find('-');
+  if (dash == std::string_view::npos) {
+    return std::nullopt;
+  }
+
+  auto parse = [](std::string_view str, uint64_t& value) {
+    auto [end, error] = std::from_chars(str.data(), str.data() + str.length(), value);
+    return !str.empty() && error == std::errc{} && end == str.data() + str.length();
+  };
+
+  auto first_str = header.substr(0, dash);
+  auto last_str = header.substr(dash + 1);
+
+  if (first_str.empty()) {
+    uint64_t suffix;
+    if (!parse(last_str, suffix)) {
+      return std::nullopt;
+    }
+
+    if (suffix == 0 || size == 0) {
+      return byte_range{0, 0, false};
+    }
+
+    return byte_range{size > suffix ? size - suffix : 0, size - 1};
+  }
+
+  uint64_t first;
+  uint64_t last = UINT64_MAX;
+  if (!parse(first_str, first) || (!last_str.empty() && (!parse(last_str, last) || last < first))) {
+    return std::nullopt;
+  }
+
+  if (first >= size) {
+    return byte_range{0, 0, false};
+  }
+
+  return byte_range{first, std::min(last, size - 1)};
+}
+} // namespace detail
+
+task<void> file(const http::request& request, http::response& response, std::string_view path,
+    uv_loop_t* native_loop) {
+  std::string key{path};
+  auto metadata = detail::findFileMetadata(key);
+
+  auto not_found = [&response]() {
+    response.status = http::NOT_FOUND;
+    response.headers["content-length"] = "0";
+  };
+
+  uv::file file{0, native_loop};
+  auto open = [&]() -> task<bool> {
+    try {
+      file = co_await uv::fs::open(path, O_RDONLY, 0, native_loop);
+      co_return true;
+    } catch (const uv::error&) {
+      co_return false;
+    }
+  };
+
+  if (!metadata) {
+    if (!co_await open()) {
+      not_found();
+      co_return;
+    }
+
+    auto info = co_await uv::fs::stat(file, native_loop);
+    if ((info.st_mode & S_IFMT) != S_IFREG) {
+      not_found();
+      co_return;
+    }
+
+    metadata = detail::storeFileMetadata(key, info);
+  }
+
+  response.headers["etag"] = metadata->etag;
+  response.headers["accept-ranges"] = "bytes";
+  if (response.headers.count("content-type") == 0) {
+    response.headers["content-type"] = detail::contentType(path);
+  }
+
+  auto if_none_match = request.headers.find("if-none-match");
+  if (if_none_match != request.headers.end() && detail::matchesETag(if_none_match->second, metadata->etag)) {
+    response.status = http::status::NOT_MODIFIED;
+    co_return;
+  }
+
+  // the metadata may be cached from before the file was removed
+  if (!file && !co_await open()) {
+    detail::eraseFileMetadata(key);
+    not_found();
+    co_return;
+  }
+
+  uint64_t offset = 0;
+  uint64_t length = metadata->size;
+  response.status = http::OK;
+
+  auto range_header = request.headers.find("range");
+  if (range_header != request.headers.end()) {
+    if (auto range = detail::parseRange(range_header->second, metadata->size)) {
+      if (!range->satisfiable) {
+        response.status = http::status::RANGE_NOT_SATISFIABLE;
+        response.headers["content-range"] = "bytes */" + std::to_string(metadata->size);
+        response.headers["content-length"] = "0";
+        co_return;
+      }
+
+      offset = range->first;
+      length = range->last - range->first + 1;
+      response.status = http::status::PARTIAL_CONTENT;
+      response.headers["content-range"] = "bytes " + std::to_string(range->first) + "-" +
+          std::to_string(range->last) + "/" + std::to_string(metadata->size);
+    }
+  }
+
+  response.headers["content-length"] = std::to_string(length);
+
+  int fd = file;
+  response.file = http::response::file_body{fd, offset, length, std::make_shared<uv::file>(std::move(file))};
+}
+
+void listen(uv::tcp& server, http::serve::handler&& callback, http::serve::options options) {
+  server.listen([&server, callback{std::move(callback)}, options](auto error) {
+    [](uv::tcp& server, const http::serve::handler& callback, http::serve::options options) -> task<void> {
+      uv::tcp client{server.loop()};
       co_await server.accept(client);
 
 #ifdef UVPP_SSL_INCLUDE
@@ -19,10 +265,79 @@ void listen(uv::tcp& server, http::serve::handler&& callback) {
         co_await http::_2::accept(client, callback);
 #endif
       } else {
-        co_await http::_1::accept(client, callback);
+        co_await http::_1::accept(client, callback, options);
       }
-    });
+    }(server, callback, options).start();
   });
 }
+
+void listen(const char* ip, int port, size_t loops, std::function<http::serve::handler()> make_handler,
+    std::function<void(uv::tcp&)> configure, cppcoro::cancellation_token token, http::serve::options options) {
+  if (loops == 0) {
+    loops = 1;
+  }
+
+  struct worker {
+    uv_loop_t loop;
+    std::optional<uv::tcp> server;
+    std::optional<uv::async> stop;
+  };
+
+  // everything is set up on this thread so bind errors reach the caller, the loops only run on their own threads
+  std::vector<std::unique_ptr<worker>> workers;
+  for (size_t i = 0; i < loops; i++) {
+    auto& w = *workers.emplace_back(std::make_unique<worker>());
+    uv::error::test(uv_loop_init(&w.loop));
+
+    w.server.emplace(&w.loop);
+    if (configure) {
+      configure(*w.server);
+    }
+    w.server->reusePort(true);
+    w.server->bind4(ip, port);
+    listen(*w.server, make_handler(), options);
+
+    if (token.can_be_cancelled()) {
+      w.stop.emplace(&w.loop);
+      w.stop->start([&w]() {
+        w.server->close([]() {});
+        w.stop->close([]() {});
+      });
+    }
+  }
+
+  std::optional<cppcoro::cancellation_registration> registration;
+  if (token.can_be_cancelled()) {
+    registration.emplace(token, [&workers]() {
+      for (auto& w : workers) {
+        w->stop->notify();
+      }
+    });
+  }
+
+  std::vector<std::thread> threads;
+  for (auto& w : workers) {
+    threads.emplace_back([&w]() {
+      uv_run(&w->loop, UV_RUN_DEFAULT);
+
+      // the per loop state lives on this thread, a loop of a later listen() may get the same address
+      uv::release(&w->loop);
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  registration.reset();
+
+  for (auto& w : workers) {
+    w->stop.reset();
+    w->server.reset();
+
+    uv_run(&w->loop, UV_RUN_DEFAULT);
+    uv_loop_close(&w->loop);
+  }
+}
 }
 #endif
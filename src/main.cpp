@@ -20,6 +20,7 @@
 #include "uv.hpp"
 #include "http/base64.hpp"
 #include <algorithm>
+#include <csignal>
 #include <random>
 #include "http.hpp"
 #include "http/serve.hpp"
@@ -512,6 +513,57 @@ auto selectTriviaQuestions(db::orm::repository& repo, const TriviaQuestionSelect
   }
 }
 
+json simplifyTriviaQuestion(const TriviaQuestion& question) {
+  return {
+    {"id", question.id},
+    {"category", question.category.name},
+    {"question", question.question},
+    {"answer", question.answer},
+    {"hint1", question.hint1},
+    {"hint2", question.hint2},
+    {"submitter", question.submitter},
+  };
+}
+
+// writes the same document as json::dump(2, ' ') a few questions at a time, so neither the json tree nor the full text
+// of the listing is held while it is sent
+http::response::body_producer produceTriviaQuestions(std::vector<TriviaQuestion>&& questions, bool simplified) {
+  constexpr size_t batch_size = 16;
+
+  auto items = std::make_shared<std::vector<TriviaQuestion>>(std::move(questions));
+  auto index = std::make_shared<size_t>(0);
+  auto done = std::make_shared<bool>(false);
+
+  return [items, index, done, simplified]() {
+    std::optional<std::string> chunk;
+
+    if (items->empty() && !*done) {
+      chunk = "[]";
+      *done = true;
+    } else if (*index < items->size()) {
+      chunk = *index == 0 ? "[\n" : ",\n";
+
+      size_t end = std::min(*index + batch_size, items->size());
+      for (; *index < end; *index += 1) {
+        auto& question = (*items)[*index];
+        std::string element = simplified ? simplifyTriviaQuestion(question).dump(2, ' ') : json(question).dump(2, ' ');
+        string_replace_all(element, "\n", "\n  ");
+
+        *chunk += "  ";
+        *chunk += element;
+        if (*index + 1 < end) {
+          *chunk += ",\n";
+        }
+      }
+    } else if (!*done) {
+      chunk = "\n]";
+      *done = true;
+    }
+
+    return task<std::optional<std::string>>::resolve(chunk);
+  };
+}
+
 task<int> amain2() {
   while (true) {
     uv::signalof<SIGINT> sigint;
@@ -543,7 +595,7 @@ task<int> amain2() {
     });
 
     ws.onSend([&](auto chunk) {
-      tcp.write(chunk).start();
+      tcp.queueWrite(chunk);
     });
 
     ws.onRecv([&](const auto& msg) {
@@ -654,8 +706,8 @@ task<int> amain() {
     .count<TriviaQuestion>();
 
   if (count == 0) {
-    auto data = co_await uv::fs::readAll("./questions.json");
-    auto json = json::parse(data);
+    auto data = co_await uv::fs::mapFile("./questions.json");
+    auto json = json::parse(data.begin(), data.end());
 
     db::orm::repository repo{datasource};
     db::transaction transaction{repo};
@@ -689,22 +741,30 @@ task<int> amain() {
 
   std::cout << "ready" << std::endl;
 
+  // queries run on their own threads, finished ones are handed back to this loop in batches
+  uv::resume_queue db_completions{uv_default_loop()};
+  db::executor db_executor{datasource, 4, [&db_completions](std::coroutine_handle<> waiter) {
+    db_completions.push(waiter);
+  }};
+
   uv::tcp server;
   server.bind4("127.0.0.1", 8001);
 
   http::serve::listen(server, [&](http::request& request, http::response& response) -> task<void> {
-    db::orm::repository repo{datasource};
+    db::orm::repository repo{db_executor};
 
     TriviaQuestionSelectOptions options;
     http::serve::deserializeQuery(request.url, options);
 
-    auto questions = selectTriviaQuestions(repo, options);
+    auto questions = co_await repo.async().run([&options](db::orm::repository& repo) {
+      return selectTriviaQuestions(repo, options);
+    });
 
     std::set<ulid::ULID> categoryids;
     for (auto& question : questions) {
       categoryids.emplace(question.categoryId);
     }
-    auto categories = repo.findManyById<TriviaCategory>(categoryids).toVector();
+    auto categories = co_await repo.async().findManyById<TriviaCategory>(categoryids);
 
     for (auto& question : questions) {
       for (auto& category : categories) {
@@ -715,27 +775,9 @@ task<int> amain() {
       }
     }
 
+    response.status = http::OK;
     response.headers["content-type"] = "application/json";
-
-    if (request.url.queryvalue<bool>("simplified").value_or(false)) {
-      json body;
-      for (auto& question : questions) {
-        body.push_back({
-          {"id", question.id},
-          {"category", question.category.name},
-          {"question", question.question},
-          {"answer", question.answer},
-          {"hint1", question.hint1},
-          {"hint2", question.hint2},
-          {"submitter", question.submitter},
-        });
-      }
-
-      response.body = body.dump(2, ' ');
-    } else {
-      json body = questions;
-      response.body = body.dump(2, ' ');
-    }
+    response.producer = produceTriviaQuestions(std::move(questions), request.url.queryvalue<bool>("simplified").value_or(false));
 
     http::serve::normalize(response);
     co_return;
@@ -744,10 +786,19 @@ task<int> amain() {
   std::cout << "listening" << std::endl;
 
   co_await uv::signal::sonce(SIGINT);
+
+  // the queries still running finish first, then everyone waiting for them is resumed before the queue goes away
+  db_executor.stop();
+  co_await db_completions.close();
+
   co_return 0;
 }
 
 int main() {
+  // a client that goes away in the middle of a (long, produced) response has to fail that write with EPIPE instead of
+  // killing the process
+  std::signal(SIGPIPE, SIG_IGN);
+
   return amain2().start_blocking([]() {
     uv::run();
   });
@@ -114,6 +114,30 @@ void driver::state::encrypt(std::string_view data, std::function<void(std::excep
   }
 }
 
+void driver::state::encrypt(std::span<const std::string_view> data, std::function<void(std::exception_ptr)> cb) {
+  if (!ready()) {
+    throw openssl_error("ssl_is_init_finished = 0");
+  }
+
+  // the write BIO is a growing memory BIO so every record ends up in a single pending buffer
+  for (auto segment : data) {
+    while (!segment.empty()) {
+      int rc = SSL_write(_native_state, segment.data(), segment.length());
+      if (rc <= 0) {
+        throw openssl_error(getError(rc));
+      }
+
+      segment.remove_prefix(rc);
+    }
+  }
+
+  if (BIO_pending(_write) > 0) {
+    sendPending(std::move(cb));
+  } else {
+    cb(nullptr);
+  }
+}
+
 void driver::state::onReadDecrypted(std::function<void(std::string_view)>& value) {
   _on_read_decrypted = std::move(value);
 }
@@ -113,6 +113,10 @@ SSLPP_TASK_TYPE<void> state::encrypt(std::string_view data) {
 }
 #endif
 
+void state::encrypt(std::span<const std::string_view> data, std::function<void(std::exception_ptr)> cb) {
+  _driver_state->encrypt(data, cb);
+}
+
 void state::onReadDecrypted(std::function<void(std::string_view)> value) {
   _driver_state->onReadDecrypted(value);
 }
@@ -0,0 +1,141 @@
+#include "task-executor.hpp"
+
+namespace taskpp {
+namespace detail {
+thread_local executor* current_executor = nullptr;
+thread_local size_t current_worker = 0;
+}
+
+executor::executor(size_t thread_count) {
+  if (thread_count == 0) {
+    thread_count = 1;
+  }
+
+  _workers.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; i++) {
+    _workers.push_back(std::make_unique<worker>());
+  }
+
+  for (size_t i = 0; i < thread_count; i++) {
+    _workers[i]->thread = std::thread{[this, i]() {
+      loop(i);
+    }};
+  }
+}
+
+executor::~executor() {
+  stop();
+}
+
+void executor::post(std::coroutine_handle<> handle) {
+  // counted before it can be taken, a worker that takes it decrements right away
+  _pending.fetch_add(1);
+
+  if (detail::current_executor == this) {
+    auto& self = *_workers[detail::current_worker];
+
+    std::lock_guard lock{self.mutex};
+    self.queue.push_back(handle);
+  } else {
+    std::lock_guard lock{_inject_mutex};
+    _inject.push_back(handle);
+  }
+
+  if (_sleeping.load() > 0) {
+    std::lock_guard lock{_sleep_mutex};
+    _sleep_cv.notify_one();
+  }
+}
+
+void executor::stop() {
+  if (_stopping.exchange(true)) {
+    return;
+  }
+
+  {
+    std::lock_guard lock{_sleep_mutex};
+    _sleep_cv.notify_all();
+  }
+
+  for (auto& worker : _workers) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+}
+
+size_t executor::size() const noexcept {
+  return _workers.size();
+}
+
+bool executor::isWorkerThread() const noexcept {
+  return detail::current_executor == this;
+}
+
+std::coroutine_handle<> executor::take(size_t index) {
+  {
+    auto& self = *_workers[index];
+
+    std::lock_guard lock{self.mutex};
+    if (!self.queue.empty()) {
+      auto handle = self.queue.back();
+      self.queue.pop_back();
+      return handle;
+    }
+  }
+
+  {
+    std::lock_guard lock{_inject_mutex};
+    if (!_inject.empty()) {
+      auto handle = _inject.front();
+      _inject.pop_front();
+      return handle;
+    }
+  }
+
+  for (size_t i = 1; i < _workers.size(); i++) {
+    auto& victim = *_workers[(index + i) % _workers.size()];
+
+    std::unique_lock lock{victim.mutex, std::try_to_lock};
+    if (lock && !victim.queue.empty()) {
+      auto handle = victim.queue.front();
+      victim.queue.pop_front();
+      return handle;
+    }
+  }
+
+  return nullptr;
+}
+
+void executor::loop(size_t index) {
+  detail::current_executor = this;
+  detail::current_worker = index;
+
+  while (true) {
+    if (_pending.load() > 0) {
+      if (auto handle = take(index)) {
+        _pending.fetch_sub(1);
+        handle.resume();
+        continue;
+      }
+
+      // the pending handle is not pushed yet or another worker holds the lock of its queue
+      std::this_thread::yield();
+      continue;
+    }
+
+    std::unique_lock lock{_sleep_mutex};
+    _sleeping.fetch_add(1);
+    _sleep_cv.wait(lock, [this]() {
+      return _pending.load() > 0 || _stopping.load();
+    });
+    _sleeping.fetch_sub(1);
+
+    if (_stopping.load() && _pending.load() == 0) {
+      break;
+    }
+  }
+
+  detail::current_executor = nullptr;
+}
+} // namespace taskpp
@@ -1,24 +1,112 @@
 #include "task.hpp"
-#include <queue>
-#include <mutex>
-#include <shared_mutex>
+#include <new>
+#include <utility>
 
 namespace taskpp {
 namespace detail {
-std::queue<std::function<void()>> completed_tasks;
-std::shared_mutex completed_tasks_rwlock;
+// frames are pooled in size classes of 64 bytes up to 2 KiB, larger frames go straight to operator new
+constexpr std::size_t frame_pool_granularity = 64;
+constexpr std::size_t frame_pool_classes = 32;
+constexpr std::size_t frame_pool_capacity = 256;
 
-void deleteTask(std::function<void()> deleter) {
-  std::unique_lock lock{detail::completed_tasks_rwlock};
+struct frame_pool_block {
+  frame_pool_block* next;
+};
 
-  while (!detail::completed_tasks.empty()) {
-    auto& existing_deleter = detail::completed_tasks.front();
+// trivially destructible, so they can still be used while (and after) the thread's thread_local objects are destroyed.
+// a task completing that late is deleted by the next one, the last one is leaked with the exiting thread
+thread_local bool thread_state_destroyed = false;
+thread_local completed_task* completed_after_destruction = nullptr;
 
-    existing_deleter();
-    detail::completed_tasks.pop();
+struct thread_state_t {
+  // a finished task may only be deleted once its frame has fully unwound, which is guaranteed by the time the next
+  // task completes on the same thread. completions on other threads give no such guarantee, so the slot is per thread.
+  completed_task* last_completed = nullptr;
+
+  frame_pool_block* frame_pool[frame_pool_classes] = {};
+  std::size_t frame_pool_size[frame_pool_classes] = {};
+
+  frame_stats stats;
+
+  ~thread_state_t() {
+    if (auto last = std::exchange(last_completed, nullptr)) {
+      last->destroy(last);
+    }
+
+    // frames freed by thread_local objects destroyed after this one go straight to operator delete
+    thread_state_destroyed = true;
+
+    for (auto& head : frame_pool) {
+      while (head) {
+        ::operator delete(std::exchange(head, head->next));
+      }
+    }
+  }
+};
+
+thread_local thread_state_t thread_state;
+
+void deleteTask(completed_task* completed) {
+  auto last = thread_state_destroyed ? std::exchange(completed_after_destruction, completed)
+                                     : std::exchange(detail::thread_state.last_completed, completed);
+
+  if (last) {
+    last->destroy(last);
+  }
+}
+
+void* allocate_frame(std::size_t size) {
+  if (thread_state_destroyed) {
+    return ::operator new(size);
+  }
+
+  auto& state = detail::thread_state;
+  state.stats.allocations += 1;
+
+  std::size_t index = (size - 1) / frame_pool_granularity;
+  if (index >= frame_pool_classes) {
+    state.stats.pool_misses += 1;
+    return ::operator new(size);
+  }
+
+  if (auto block = state.frame_pool[index]) {
+    state.frame_pool[index] = block->next;
+    state.frame_pool_size[index] -= 1;
+    state.stats.pool_hits += 1;
+    return block;
+  }
+
+  state.stats.pool_misses += 1;
+  return ::operator new((index + 1) * frame_pool_granularity);
+}
+
+void deallocate_frame(void* ptr, std::size_t size) noexcept {
+  if (thread_state_destroyed) {
+    ::operator delete(ptr);
+    return;
   }
 
-  detail::completed_tasks.push(std::move(deleter));
+  auto& state = detail::thread_state;
+  state.stats.deallocations += 1;
+
+  std::size_t index = (size - 1) / frame_pool_granularity;
+  if (index >= frame_pool_classes || state.frame_pool_size[index] >= frame_pool_capacity) {
+    ::operator delete(ptr);
+    return;
+  }
+
+  auto block = static_cast<frame_pool_block*>(ptr);
+  block->next = state.frame_pool[index];
+  state.frame_pool[index] = block;
+  state.frame_pool_size[index] += 1;
+}
 }
+
+frame_stats current_frame_stats() noexcept {
+  if (detail::thread_state_destroyed) {
+    return {};
+  }
+
+  return detail::thread_state.stats;
 }
 }
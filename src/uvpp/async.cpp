@@ -45,6 +45,15 @@ void async::send(std::function<void()> async_cb) {
   error::test(uv_async_send(*this));
 }
 
+void async::start(std::function<void()> async_cb) {
+  data* data_ptr = getData<data>();
+  data_ptr->async_cb = std::move(async_cb);
+}
+
+void async::notify() {
+  error::test(uv_async_send(*this));
+}
+
 #ifdef UVPP_TASK_INCLUDE
 task<void> async::send() {
   return task<void>::create([this](auto& resolve, auto& reject) {
@@ -69,4 +78,43 @@ task<void> async::ssend() {
   });
 }
 #endif
+
+resume_queue::resume_queue(uv_loop_t* native_loop) : _async(native_loop) {
+  _async.start([this]() {
+    resumeAll();
+  });
+}
+
+void resume_queue::push(std::coroutine_handle<> waiter) {
+  {
+    std::lock_guard lock{_mutex};
+    _waiters.push_back(waiter);
+  }
+
+  _async.notify();
+}
+
+void resume_queue::resumeAll() {
+  std::vector<std::coroutine_handle<>> batch;
+  {
+    std::lock_guard lock{_mutex};
+    batch.swap(_waiters);
+  }
+
+  for (auto waiter : batch) {
+    waiter.resume();
+  }
+}
+
+void resume_queue::close(std::function<void()> cb) {
+  resumeAll();
+  _async.close(std::move(cb));
+}
+
+#ifdef UVPP_TASK_INCLUDE
+task<void> resume_queue::close() {
+  resumeAll();
+  co_await _async.close();
+}
+#endif
 } // namespace uv
@@ -0,0 +1,114 @@
+#include "uvpp/buffer.hpp"
+#include "uvpp/loop.hpp"
+#include <memory>
+#include <unordered_map>
+
+namespace uv {
+namespace detail {
+struct buffer_pools_t {
+  std::unordered_map<uv_loop_t*, std::unique_ptr<buffer_pool>> pools;
+
+  // nearly every lookup is for the same loop
+  uv_loop_t* last_loop = nullptr;
+  buffer_pool* last_pool = nullptr;
+};
+
+thread_local buffer_pools_t buffer_pools;
+} // namespace detail
+
+buffer_pool::buffer_pool(size_t buffer_size, size_t capacity) : _buffer_size(buffer_size), _capacity(capacity) {
+}
+
+buffer_pool::~buffer_pool() {
+  clear();
+}
+
+buffer_pool& buffer_pool::of(uv_loop_t* native_loop) {
+  auto& state = detail::buffer_pools;
+  if (state.last_loop == native_loop) {
+    return *state.last_pool;
+  }
+
+  auto& pool = state.pools[native_loop];
+  if (!pool) {
+    pool = std::make_unique<buffer_pool>();
+
+    uv::detail::atRelease(native_loop, [native_loop]() {
+      auto& state = detail::buffer_pools;
+      state.pools.erase(native_loop);
+      if (state.last_loop == native_loop) {
+        state.last_loop = nullptr;
+        state.last_pool = nullptr;
+      }
+    });
+  }
+
+  state.last_loop = native_loop;
+  state.last_pool = pool.get();
+  return *pool;
+}
+
+void buffer_pool::configure(size_t buffer_size, size_t capacity) {
+  if (_stats.in_use > 0) {
+    throw uv::error{"buffer pool is in use"};
+  }
+
+  clear();
+
+  _buffer_size = buffer_size;
+  _capacity = capacity;
+}
+
+uv_buf_t buffer_pool::acquire(size_t size) {
+  _stats.in_use += 1;
+
+  if (size > _buffer_size) {
+    _stats.misses += 1;
+    return uv_buf_init(new char[size], size);
+  }
+
+  if (_idle.empty()) {
+    _stats.misses += 1;
+    return uv_buf_init(new char[_buffer_size], size);
+  }
+
+  _stats.hits += 1;
+
+  auto base = _idle.back();
+  _idle.pop_back();
+  return uv_buf_init(base, size);
+}
+
+void buffer_pool::release(const uv_buf_t& buf) noexcept {
+  if (buf.base == nullptr) {
+    return;
+  }
+
+  _stats.in_use -= 1;
+
+  if (buf.len > _buffer_size || _idle.size() >= _capacity) {
+    delete[] buf.base;
+    return;
+  }
+
+  _idle.push_back(buf.base);
+}
+
+size_t buffer_pool::bufferSize() const noexcept {
+  return _buffer_size;
+}
+
+buffer_pool_stats buffer_pool::stats() const noexcept {
+  auto stats = _stats;
+  stats.idle = _idle.size();
+  return stats;
+}
+
+void buffer_pool::clear() noexcept {
+  for (auto base : _idle) {
+    delete[] base;
+  }
+
+  _idle.clear();
+}
+} // namespace uv
@@ -1,4 +1,6 @@
 #include "uvpp/dns.hpp"
+#include "uvpp/loop.hpp"
+#include <utility>
 
 namespace uv {
 namespace dns {
@@ -36,22 +38,232 @@ void getaddrinfo(const std::string& node, const std::string& service, std::funct
 }
 
 #ifdef UVPP_TASK_INCLUDE
-task<uv::dns::addrinfo> getaddrinfo(
-    const std::string& node, const std::string& service, uv_loop_t* native_loop) {
-  return task<uv::dns::addrinfo>::create(
-      [node, service, native_loop](auto& resolve, auto& reject) {
-        uv::dns::getaddrinfo(
-            node, service,
-            [&resolve, &reject](auto result, auto error) {
-              if (error) {
-                reject(std::make_exception_ptr(error));
-              } else {
-                resolve(result);
-              }
-            },
-            native_loop);
-      });
+task<uv::dns::addrinfo> getaddrinfo(std::string node, std::string service, uv_loop_t* native_loop,
+    cppcoro::cancellation_token token) {
+  struct getaddrinfo_awaiter : public uv::detail::req_awaiter<uv_getaddrinfo_t> {
+    uv_loop_t* native_loop;
+    const std::string& node;
+    const std::string& service;
+    uv::dns::addrinfo addr;
+
+    getaddrinfo_awaiter(uv_loop_t* l, const std::string& n, const std::string& s, cppcoro::cancellation_token token)
+        : req_awaiter(std::move(token)), native_loop(l), node(n), service(s) {
+    }
+
+    void await_suspend(std::coroutine_handle<> waiter) {
+      this->waiter = waiter;
+      error::test(uv_getaddrinfo(
+          native_loop, &native_req,
+          [](uv_getaddrinfo_t* native_req, int status, ::addrinfo* res) {
+            auto self = (getaddrinfo_awaiter*)native_req->data;
+            self->addr = uv::dns::addrinfo{res, &uv_freeaddrinfo};
+            resume(native_req, status);
+          },
+          node.data(), service.data(), nullptr));
+
+      cancelWithUvCancel();
+    }
+  };
+
+  getaddrinfo_awaiter awaiter{native_loop, node, service, std::move(token)};
+  co_await awaiter;
+
+  co_return std::move(awaiter.addr);
+}
+#endif
+
+namespace detail {
+struct caches_t {
+  std::unordered_map<uv_loop_t*, std::unique_ptr<cache>> caches;
+
+  uv_loop_t* last_loop = nullptr;
+  cache* last_cache = nullptr;
+};
+
+thread_local caches_t caches;
+} // namespace detail
+
+cache::cache(uv_loop_t* native_loop, uint64_t ttl, uint64_t negative_ttl, size_t max_size)
+    : _native_loop(native_loop), _ttl(ttl), _negative_ttl(negative_ttl), _max_size(max_size) {
+}
+
+cache& cache::of(uv_loop_t* native_loop) {
+  auto& state = detail::caches;
+  if (state.last_loop == native_loop) {
+    return *state.last_cache;
+  }
+
+  auto& c = state.caches[native_loop];
+  if (!c) {
+    c = std::make_unique<cache>(native_loop);
+
+    // a loop that stopped has no lookups left
+    uv::detail::atRelease(native_loop, [native_loop]() {
+      auto& state = detail::caches;
+      state.caches.erase(native_loop);
+      if (state.last_loop == native_loop) {
+        state.last_loop = nullptr;
+        state.last_cache = nullptr;
+      }
+    });
+  }
+
+  state.last_loop = native_loop;
+  state.last_cache = c.get();
+  return *c;
+}
+
+void cache::resolve(const std::string& node, const std::string& service, std::function<void(uv::dns::addrinfo, uv::error)> cb) {
+  lookup(node, service, std::move(cb));
+}
+
+#ifdef UVPP_TASK_INCLUDE
+task<uv::dns::addrinfo> cache::resolve(std::string node, std::string service, cppcoro::cancellation_token token) {
+  uv::timer_wheel::entry cancelled;
+
+  co_return co_await uv::detail::awaitCallback<uv::dns::addrinfo>(
+      [this, &node, &service, &cancelled](auto& awaiter) {
+        auto position = lookup(node, service, [&awaiter](uv::dns::addrinfo addr, uv::error error) {
+          if (error) {
+            awaiter.reject(error);
+          } else {
+            awaiter.resolve(std::move(addr));
+          }
+        });
+
+        if (!position) {
+          return;
+        }
+
+        // the shared request keeps running for everyone else, only this waiter leaves (on the next tick instead of
+        // from inside the cancellation callback). its node may already have been taken over by complete()
+        awaiter.cancelWith([this, position, &awaiter, &cancelled]() {
+          **position = nullptr;
+
+          uv::timer_wheel::of(_native_loop).schedule(cancelled, 0, [&awaiter]() {
+            awaiter.reject(uv::error{UV_ECANCELED});
+          });
+        });
+      },
+      std::move(token));
 }
 #endif
+
+void cache::expire() noexcept {
+  for (auto& [key, e] : _entries) {
+    e.expires = 0;
+  }
+}
+
+size_t cache::size() const noexcept {
+  return _entries.size();
+}
+
+const cache::statistics& cache::stats() const noexcept {
+  return _stats;
+}
+
+std::optional<std::list<cache::waiter>::iterator> cache::lookup(
+    const std::string& node, const std::string& service, waiter cb) {
+  std::string key;
+  key.reserve(node.length() + service.length() + 1);
+  key += node;
+  key += ':';
+  key += service;
+
+  if (_entries.size() >= _max_size && !_entries.contains(key)) {
+    evict();
+  }
+
+  auto& e = _entries[key];
+
+  if (e.pending) {
+    _stats.coalesced += 1;
+    return e.waiters.insert(e.waiters.end(), std::move(cb));
+  }
+
+  if (uv_now(_native_loop) < e.expires) {
+    if (e.error) {
+      _stats.negative_hits += 1;
+    } else {
+      _stats.hits += 1;
+    }
+
+    cb(e.addr, e.error);
+    return std::nullopt;
+  }
+
+  _stats.misses += 1;
+  e.pending = true;
+  auto position = e.waiters.insert(e.waiters.end(), std::move(cb));
+
+  // entries with a pending request are never erased, so `e` outlives the request
+  try {
+    uv::dns::getaddrinfo(
+        node, service,
+        [this, &e](auto addr, auto error) {
+          complete(e, std::move(addr), error);
+        },
+        _native_loop);
+  } catch (...) {
+    e.pending = false;
+    e.waiters.erase(position);
+    throw;
+  }
+
+  return position;
+}
+
+void cache::complete(entry& e, uv::dns::addrinfo addr, uv::error error) {
+  if (error) {
+    addr = nullptr;
+  }
+
+  e.pending = false;
+  e.addr = addr;
+  e.error = error;
+  e.expires = uv_now(_native_loop) + (error ? _negative_ttl : _ttl);
+
+  // a waiter that resolves another name may evict `e`, so all of them leave it before the first one is called and `e`
+  // is not touched afterwards. cancelling one that is still queued here clears its callback
+  auto waiters = std::move(e.waiters);
+  e.waiters.clear();
+
+  for (auto& cb : waiters) {
+    if (!cb) {
+      continue;
+    }
+
+    auto callback = std::move(cb);
+    cb = nullptr;
+    callback(addr, error);
+  }
+}
+
+void cache::evict() {
+  auto now = uv_now(_native_loop);
+  auto first = _entries.end();
+
+  for (auto it = _entries.begin(); it != _entries.end();) {
+    if (it->second.pending) {
+      ++it;
+      continue;
+    }
+
+    if (it->second.expires <= now) {
+      it = _entries.erase(it);
+      continue;
+    }
+
+    if (first == _entries.end() || it->second.expires < first->second.expires) {
+      first = it;
+    }
+    ++it;
+  }
+
+  if (_entries.size() >= _max_size && first != _entries.end()) {
+    _entries.erase(first);
+  }
+}
 } // namespace dns
 } // namespace uv
@@ -1,4 +1,7 @@
 #include "uvpp/fs.hpp"
+#include <cerrno>
+#include <cstdlib>
+#include <sys/mman.h>
 
 namespace uv {
 uv::file::file(uv_file fd, uv_loop_t* native_loop) : _fd(fd), _native_loop(native_loop) {}
@@ -33,7 +36,57 @@ uv::file::operator bool() const {
   return _fd != 0;
 }
 
+uv::mapped_file::mapped_file(void* data, size_t size) : _data(data), _size(size) {}
+
+uv::mapped_file::~mapped_file() {
+  if (_data) {
+    munmap(_data, _size);
+  }
+}
+
+uv::mapped_file::mapped_file(mapped_file&& o) {
+  *this = std::move(o);
+}
+
+uv::mapped_file& uv::mapped_file::operator=(uv::mapped_file&& o) {
+  std::swap(_data, o._data);
+  std::swap(_size, o._size);
+  return *this;
+}
+
+const char* uv::mapped_file::data() const noexcept {
+  return (const char*)_data;
+}
+
+size_t uv::mapped_file::size() const noexcept {
+  return _size;
+}
+
+const char* uv::mapped_file::begin() const noexcept {
+  return data();
+}
+
+const char* uv::mapped_file::end() const noexcept {
+  return data() + _size;
+}
+
+std::string_view uv::mapped_file::view() const noexcept {
+  return {data(), _size};
+}
+
+uv::mapped_file::operator std::string_view() const noexcept {
+  return view();
+}
+
+uv_buf_t uv::mapped_file::buf() const noexcept {
+  return uv_buf_init((char*)_data, _size);
+}
+
 namespace fs {
+void preferIoUring() {
+  setenv("UV_USE_IO_URING", "1", 0);
+}
+
 void close(uv::file& file, std::function<void()> cb, uv_loop_t* native_loop) {
   struct data_t : public uv::detail::req::data {
     std::function<void()> cb;
@@ -57,14 +110,23 @@ void close(uv::file& file, std::function<void()> cb, uv_loop_t* native_loop) {
 
 #ifdef UVPP_TASK_INCLUDE
 task<void> close(uv::file& file, uv_loop_t* native_loop) {
-  return task<void>::create([&file, native_loop](auto& resolve, auto& reject) mutable {
-    uv::fs::close(
-        file,
-        [&resolve, &reject]() {
-          resolve();
-        },
-        native_loop);
-  });
+  struct close_awaiter : public uv::detail::req_awaiter<uv_fs_t> {
+    uv_loop_t* native_loop;
+    uv_file fd;
+
+    close_awaiter(uv_loop_t* l, uv_file f) : native_loop(l), fd(f) {
+    }
+
+    void await_suspend(std::coroutine_handle<> waiter) {
+      this->waiter = waiter;
+      error::test(uv_fs_close(native_loop, &native_req, fd, &close_awaiter::resume));
+    }
+  };
+
+  uv_file fd = file;
+  file = 0;
+
+  co_await close_awaiter{native_loop, fd};
 }
 #endif
 
@@ -95,19 +157,29 @@ void open(std::string_view path, int flags, int mode, std::function<void(uv::fil
 }
 
 #ifdef UVPP_TASK_INCLUDE
-task<uv::file> open(std::string_view path, int flags, int mode, uv_loop_t* native_loop) {
-  return task<uv::file>::create([path, flags, mode, native_loop](auto& resolve, auto& reject) {
-    uv::fs::open(
-        path, flags, mode,
-        [&resolve, &reject](auto result, auto error) {
-          if (error) {
-            reject(make_exception_ptr(error));
-          } else {
-            resolve(result);
-          }
-        },
-        native_loop);
-  });
+task<uv::file> open(std::string_view path, int flags, int mode, uv_loop_t* native_loop,
+    cppcoro::cancellation_token token) {
+  struct open_awaiter : public uv::detail::req_awaiter<uv_fs_t> {
+    uv_loop_t* native_loop;
+    std::string path;
+    int flags;
+    int mode;
+
+    open_awaiter(uv_loop_t* l, std::string_view p, int f, int m, cppcoro::cancellation_token token)
+        : req_awaiter(std::move(token)), native_loop(l), path(p), flags(f), mode(m) {
+    }
+
+    void await_suspend(std::coroutine_handle<> waiter) {
+      this->waiter = waiter;
+      error::test(uv_fs_open(native_loop, &native_req, path.data(), flags, mode, &open_awaiter::resume));
+
+      cancelWithUvCancel();
+    }
+  };
+
+  auto fd = co_await open_awaiter{native_loop, path, flags, mode, std::move(token)};
+
+  co_return uv::file{(uv_file)fd, native_loop};
 }
 #endif
 
@@ -157,35 +229,154 @@ void read(uv_file file, std::function<void(std::string_view, uv::error)> cb, cha
 
 #ifdef UVPP_TASK_INCLUDE
 task<std::string_view> read(uv_file file, char* buf, size_t buf_len, int64_t offset,
-    uv_loop_t* native_loop) {
-  return task<std::string_view>::create([file, buf, buf_len, offset, native_loop](auto& resolve, auto& reject) {
-    uv::fs::read(
-        file,
-        [&resolve, &reject](auto result, auto error) {
-          if (error) {
-            reject(make_exception_ptr(error));
-          } else {
-            resolve(result);
-          }
+    uv_loop_t* native_loop, cppcoro::cancellation_token token) {
+  if (buf == nullptr) {
+    co_return co_await uv::detail::awaitCallback<std::string_view>(
+        [&](auto& awaiter) {
+          uv::fs::read(
+              file,
+              [&awaiter](auto result, auto error) {
+                if (error) {
+                  awaiter.reject(error);
+                } else {
+                  awaiter.resolve(result);
+                }
+              },
+              buf, buf_len, offset, native_loop);
+
+          // the request is owned by the callback version, a short read is simply awaited
+          awaiter.cancelWith([]() {
+          });
         },
-        buf, buf_len, offset, native_loop);
-  });
+        std::move(token));
+  }
+
+  struct read_awaiter : public uv::detail::req_awaiter<uv_fs_t> {
+    uv_loop_t* native_loop;
+    uv_file file;
+    uv::fs::buf buf;
+    int64_t offset;
+
+    read_awaiter(uv_loop_t* l, uv_file f, char* b, size_t b_len, int64_t o, cppcoro::cancellation_token token)
+        : req_awaiter(std::move(token)), native_loop(l), file(f), buf(uv_buf_init(b, b_len)), offset(o) {
+    }
+
+    void await_suspend(std::coroutine_handle<> waiter) {
+      this->waiter = waiter;
+      error::test(uv_fs_read(native_loop, &native_req, file, &buf, 1, offset, &read_awaiter::resume));
+
+      cancelWithUvCancel();
+    }
+  };
+
+  auto length = co_await read_awaiter{native_loop, file, buf, buf_len, offset, std::move(token)};
+
+  co_return std::string_view{buf, (size_t)length};
+}
+#endif
+
+#ifdef UVPP_TASK_INCLUDE
+task<uv_stat_t> stat(uv_file file, uv_loop_t* native_loop, cppcoro::cancellation_token token) {
+  struct stat_awaiter : public uv::detail::req_awaiter<uv_fs_t> {
+    uv_loop_t* native_loop;
+    uv_file file;
+
+    stat_awaiter(uv_loop_t* l, uv_file f, cppcoro::cancellation_token token)
+        : req_awaiter(std::move(token)), native_loop(l), file(f) {
+    }
+
+    void await_suspend(std::coroutine_handle<> waiter) {
+      this->waiter = waiter;
+      error::test(uv_fs_fstat(native_loop, &native_req, file, &stat_awaiter::resume));
+
+      cancelWithUvCancel();
+    }
+  };
+
+  // statbuf is left alone by uv_fs_req_cleanup
+  stat_awaiter awaiter{native_loop, file, std::move(token)};
+  co_await awaiter;
+
+  co_return awaiter.native_req.statbuf;
+}
+#endif
+
+#ifdef UVPP_TASK_INCLUDE
+task<uv_stat_t> stat(std::string_view path, uv_loop_t* native_loop, cppcoro::cancellation_token token) {
+  struct stat_awaiter : public uv::detail::req_awaiter<uv_fs_t> {
+    uv_loop_t* native_loop;
+    std::string path;
+
+    stat_awaiter(uv_loop_t* l, std::string_view p, cppcoro::cancellation_token token)
+        : req_awaiter(std::move(token)), native_loop(l), path(p) {
+    }
+
+    void await_suspend(std::coroutine_handle<> waiter) {
+      this->waiter = waiter;
+      error::test(uv_fs_stat(native_loop, &native_req, path.data(), &stat_awaiter::resume));
+
+      cancelWithUvCancel();
+    }
+  };
+
+  stat_awaiter awaiter{native_loop, path, std::move(token)};
+  co_await awaiter;
+
+  co_return awaiter.native_req.statbuf;
+}
+#endif
+
+#ifdef UVPP_TASK_INCLUDE
+task<size_t> sendfile(uv_file out, uv_file in, int64_t offset, size_t length, uv_loop_t* native_loop,
+    cppcoro::cancellation_token token) {
+  struct sendfile_awaiter : public uv::detail::req_awaiter<uv_fs_t> {
+    uv_loop_t* native_loop;
+    uv_file out;
+    uv_file in;
+    int64_t offset;
+    size_t length;
+
+    sendfile_awaiter(uv_loop_t* l, uv_file o, uv_file i, int64_t off, size_t len, cppcoro::cancellation_token token)
+        : req_awaiter(std::move(token)), native_loop(l), out(o), in(i), offset(off), length(len) {
+    }
+
+    void await_suspend(std::coroutine_handle<> waiter) {
+      this->waiter = waiter;
+      error::test(uv_fs_sendfile(native_loop, &native_req, out, in, offset, length, &sendfile_awaiter::resume));
+
+      cancelWithUvCancel();
+    }
+  };
+
+  co_return (size_t)co_await sendfile_awaiter{native_loop, out, in, offset, length, std::move(token)};
 }
 #endif
 
 #ifdef UVPP_TASK_INCLUDE
-task<std::string> readAll(uv_file file, int64_t offset, uv_loop_t* native_loop) {
+task<std::string> readAll(uv_file file, int64_t offset, uv_loop_t* native_loop, cppcoro::cancellation_token token) {
+  auto info = co_await stat(file, native_loop, token);
+
+  bool regular = (info.st_mode & S_IFMT) == S_IFREG;
+  size_t expected = regular && (int64_t)info.st_size > offset ? info.st_size - offset : 0;
+
+  // the read that finds the end of a regular file goes into the spare page instead of moving the whole contents
   std::string result;
+  result.reserve(expected + 4096);
 
-  char buf[65536];
   while (true) {
-    auto chunk = co_await read(file, buf, sizeof(buf), offset + result.length(), native_loop);
+    // the size from stat() is read at once. files without a known size (procfs, pipes) or that grew since are read in
+    // chunks until a read returns nothing
+    size_t length = result.length();
+    size_t spare = result.capacity() - length;
+    size_t chunk_length = length < expected ? expected - length : (spare >= 4096 ? spare : 65536);
+
+    result.resize(length + chunk_length);
+    auto chunk = co_await read(file, result.data() + length, chunk_length, offset + length, native_loop, token);
+    result.resize(length + chunk.length());
 
     if (chunk.length() == 0) {
       break;
     }
-
-    result += chunk;
   }
 
   co_return result;
@@ -193,13 +384,50 @@ task<std::string> readAll(uv_file file, int64_t offset, uv_loop_t* native_loop)
 #endif
 
 #ifdef UVPP_TASK_INCLUDE
-task<std::string> readAll(std::string_view path, int64_t offset, uv_loop_t* native_loop) {
-  uv::file file = co_await uv::fs::open(path, O_RDONLY, S_IRUSR, native_loop);
+task<std::string> readAll(std::string_view path, int64_t offset, uv_loop_t* native_loop,
+    cppcoro::cancellation_token token) {
+  uv::file file = co_await uv::fs::open(path, O_RDONLY, S_IRUSR, native_loop, token);
   // finally f{[file, native_loop]() {
   //   uv::fs::close(file, []() {}, native_loop);
   // }};
 
-  co_return co_await uv::fs::readAll(file, offset, native_loop);
+  co_return co_await uv::fs::readAll(file, offset, native_loop, std::move(token));
+}
+#endif
+
+#ifdef UVPP_TASK_INCLUDE
+task<uv::mapped_file> mapFile(std::string_view path, uv_loop_t* native_loop, cppcoro::cancellation_token token) {
+  uv::file file = co_await uv::fs::open(path, O_RDONLY, S_IRUSR, native_loop, token);
+  auto info = co_await stat(file, native_loop, std::move(token));
+
+  if (info.st_size == 0) {
+    co_return uv::mapped_file{};
+  }
+
+  // only sets up the page tables, the file is read by page faults once the bytes are touched
+  void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+  if (data == MAP_FAILED) {
+    throw uv::error{uv_translate_sys_error(errno)};
+  }
+
+  // read ahead aggressively and let the kernel drop pages behind the reader, keeps peak RSS low for big imports.
+  // no MADV_WILLNEED, it would read the whole file in up front
+  madvise(data, info.st_size, MADV_SEQUENTIAL);
+
+  co_return uv::mapped_file{data, (size_t)info.st_size};
+}
+#endif
+
+#ifdef UVPP_TASK_INCLUDE
+task<std::vector<std::string>> readAll(std::vector<std::string> paths, uv_loop_t* native_loop,
+    cppcoro::cancellation_token token) {
+  std::vector<task<std::string>> reads;
+  reads.reserve(paths.size());
+  for (const auto& path : paths) {
+    reads.push_back(uv::fs::readAll(path, 0, native_loop, token));
+  }
+
+  co_return co_await taskpp::when_all(std::move(reads));
 }
 #endif
 } // namespace fs
@@ -15,9 +15,10 @@ handle::handle(uv_handle_t* native_handle, data* data_ptr) : _native_handle(nati
 handle::~handle() noexcept {
   data* data_ptr = getData<data>();
 
-  if (isClosing()) {
+  if (data_ptr->closed) {
     delete data_ptr;
   } else {
+    // a pending close still needs the data (and the native handle owned by it)
     close([data_ptr]() {
       delete data_ptr;
     });
@@ -32,29 +33,64 @@ handle::operator const uv_handle_t*() const noexcept {
   return _native_handle;
 }
 
+void handle::swapNative(handle& other) noexcept {
+  std::swap(_native_handle, other._native_handle);
+}
+
+uv_loop_t* handle::loop() const noexcept {
+  return _native_handle->loop;
+}
+
 bool handle::isActive() const noexcept {
   return uv_is_active(*this) != 0;
 }
 
+uv_os_fd_t handle::fileno() const {
+  uv_os_fd_t fd;
+  error::test(uv_fileno(*this, &fd));
+  return fd;
+}
+
 bool handle::isClosing() const noexcept {
   return uv_is_closing(*this) != 0;
 }
 
 void handle::close(std::function<void()> close_cb) noexcept {
   data* data_ptr = getData<data>();
+
+  if (data_ptr->closed) {
+    close_cb();
+    return;
+  }
+
+  if (isClosing()) {
+    data_ptr->close_cb = [first{std::move(data_ptr->close_cb)}, then{std::move(close_cb)}]() {
+      if (first) {
+        first();
+      }
+
+      then();
+    };
+    return;
+  }
+
   data_ptr->close_cb = close_cb;
 
   uv_close(*this, [](uv_handle_t* native_handle) {
     data* data_ptr = handle::getData<data>(native_handle);
-    data_ptr->close_cb();
+    data_ptr->closed = true;
+
+    // the callback may delete data_ptr
+    auto close_cb = std::move(data_ptr->close_cb);
+    close_cb();
   });
 }
 
 #ifdef UVPP_TASK_INCLUDE
 task<void> handle::close() {
-  return task<void>::create([this](auto& resolve, auto& reject) {
-    close([&resolve]() {
-      resolve();
+  co_await uv::detail::awaitCallback([this](auto& awaiter) {
+    close([&awaiter]() {
+      awaiter.resolve();
     });
   });
 }
@@ -0,0 +1,51 @@
+#include "uvpp/idle.hpp"
+
+namespace uv {
+idle::data::data(uv_idle_t* native_idle) : _native_idle(native_idle) {
+}
+
+idle::data::~data() {
+  delete _native_idle;
+}
+
+idle::idle(uv_loop_t* native_loop, uv_idle_t* native_idle)
+    : handle(native_idle, new data(native_idle)), _native_idle(native_idle) {
+  error::test(uv_idle_init(native_loop, native_idle));
+}
+
+idle::idle(uv_loop_t* native_loop) : idle(native_loop, new uv_idle_t()) {
+}
+
+idle::idle(uv_idle_t* native_idle) : idle(uv_default_loop(), native_idle) {
+}
+
+idle::idle() : idle(uv_default_loop(), new uv_idle_t()) {
+}
+
+idle::idle(idle&& source) noexcept
+    : handle(source._native_idle, handle::getData<data>(source._native_idle)),
+      _native_idle(std::exchange(source._native_idle, nullptr)) {
+}
+
+idle::operator uv_idle_t*() noexcept {
+  return _native_idle;
+}
+
+idle::operator const uv_idle_t*() const noexcept {
+  return _native_idle;
+}
+
+void idle::start(std::function<void()> idle_cb) {
+  data* data_ptr = getData<data>();
+  data_ptr->idle_cb = idle_cb;
+
+  error::test(uv_idle_start(*this, [](uv_idle_t* native_idle) {
+    data* data_ptr = handle::getData<data>(native_idle);
+    data_ptr->idle_cb();
+  }));
+}
+
+void idle::stop() {
+  error::test(uv_idle_stop(*this));
+}
+} // namespace uv
@@ -0,0 +1,27 @@
+#include "uvpp/loop.hpp"
+#include <unordered_map>
+#include <vector>
+
+namespace uv {
+namespace detail {
+thread_local std::unordered_multimap<uv_loop_t*, std::function<void()>> releases;
+
+void atRelease(uv_loop_t* native_loop, std::function<void()> release) {
+  releases.emplace(native_loop, std::move(release));
+}
+} // namespace detail
+
+void release(uv_loop_t* native_loop) {
+  // a release may register for the same loop again, those are left for the next call
+  auto [begin, end] = detail::releases.equal_range(native_loop);
+  std::vector<std::function<void()>> pending;
+  for (auto it = begin; it != end; ++it) {
+    pending.push_back(std::move(it->second));
+  }
+  detail::releases.erase(native_loop);
+
+  for (auto& release : pending) {
+    release();
+  }
+}
+} // namespace uv
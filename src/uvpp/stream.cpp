@@ -1,4 +1,5 @@
 #include "uvpp/stream.hpp"
+#include "uvpp/wheel.hpp"
 
 namespace uv {
 stream::stream(uv_stream_t* native_stream, data* data_ptr) : handle(native_stream, data_ptr), _native_stream(native_stream) {
@@ -8,6 +9,11 @@ stream::~stream() noexcept {
   readStop();
 }
 
+void stream::swapNative(stream& other) noexcept {
+  handle::swapNative(other);
+  std::swap(_native_stream, other._native_stream);
+}
+
 stream::operator uv_stream_t*() noexcept {
   return _native_stream;
 }
@@ -21,12 +27,35 @@ void stream::close(std::function<void()> close_cb) noexcept {
   handle::close(close_cb);
 }
 
+void stream::cancel() noexcept {
+  if (isClosing()) {
+    return;
+  }
+
+  uv_read_stop(*this);
+
+  // a pending read is failed once the handle is closed, like libuv does for pending requests
+  auto data_ptr = getData<data>();
+  bool reading = !data_ptr->sent_eof && data_ptr->read_cb;
+  data_ptr->sent_eof = true;
+
+  handle::close([data_ptr, reading]() {
+    if (reading && data_ptr->read_cb) {
+      auto read_cb = std::move(data_ptr->read_cb);
+      read_cb({}, uv::error{UV_ECANCELED});
+    }
+  });
+}
+
 void stream::shutdown(std::function<void(uv::error)> cb) {
   struct data_t : public uv::detail::req::data {
     std::function<void(uv::error)> cb;
   };
   using req_t = uv::req<uv_shutdown_t, data_t>;
 
+  // uv_shutdown waits for the submitted writes only
+  submitWriteQueue();
+
   auto req = new req_t();
   auto data = req->dataPtr();
   data->cb = std::move(cb);
@@ -42,15 +71,20 @@ void stream::shutdown(std::function<void(uv::error)> cb) {
 
 #ifdef UVPP_TASK_INCLUDE
 task<void> stream::shutdown() {
-  return task<void>::create([this](auto& resolve, auto& reject) {
-    shutdown([&resolve, &reject](auto error) {
-      if (error) {
-        reject(std::make_exception_ptr(error));
-      } else {
-        resolve();
-      }
-    });
-  });
+  struct shutdown_awaiter : public uv::detail::req_awaiter<uv_shutdown_t> {
+    uv_stream_t* native_stream;
+
+    shutdown_awaiter(uv_stream_t* s) : native_stream(s) {
+    }
+
+    void await_suspend(std::coroutine_handle<> waiter) {
+      this->waiter = waiter;
+      error::test(uv_shutdown(&native_req, native_stream, &shutdown_awaiter::resume));
+    }
+  };
+
+  submitWriteQueue();
+  co_await shutdown_awaiter{*this};
 }
 #endif
 
@@ -84,49 +118,61 @@ void stream::readStart(std::function<void(std::string_view, uv::error)> cb) {
 #endif
   data_ptr->read_cb = std::move(cb);
 
-  error::test(uv_read_start(
+  startReading();
+}
+
+void stream::startReading() {
+  // already reading (e.g. readStart for the next request of a connection), the new callback is used from now on
+  int result = uv_read_start(
       *this,
       [](uv_handle_t* native_handle, size_t suggested_size, uv_buf_t* buf) {
-        buf->base = new char[suggested_size];
-        buf->len = suggested_size;
+        auto data_ptr = handle::getData<data>(native_handle);
+        auto& pool = uv::buffer_pool::of(native_handle->loop);
+
+        *buf = pool.acquire(data_ptr->read_buffer_size ? data_ptr->read_buffer_size : pool.bufferSize());
       },
       [](uv_stream_t* native_stream, ssize_t nread, const uv_buf_t* buf) {
         auto data_ptr = handle::getData<data>(native_stream);
+        auto& pool = uv::buffer_pool::of(native_stream->loop);
 
         if (nread < 0) {
-          if (nread == UV_EOF) {
-            data_ptr->sent_eof = true;
-          }
+          // any error ends the read, readStop() must not report another EOF afterwards
+          data_ptr->sent_eof = true;
 
           data_ptr->read_cb(std::string_view{nullptr, 0}, uv::error{(int)nread});
-        } else {
+        } else if (nread > 0) {
+          // 0 is EAGAIN, not EOF. parsers would take an empty chunk as the end of the stream
           data_ptr->read_cb(std::string_view{buf->base, (std::string_view::size_type)nread}, uv::error{0});
         }
 
-        delete buf->base;
-      }));
+        pool.release(*buf);
+      });
+  if (result != UV_EALREADY) {
+    error::test(result);
+  }
 }
 
 #ifdef UVPP_TASK_INCLUDE
-task<void> stream::readStartUntilEOF(std::function<void(std::string_view)> cb) {
-  return task<void>::create([this, cb{std::move(cb)}](auto& resolve, auto& reject) {
-    readStart([&resolve, &reject, cb{std::move(cb)}](auto chunk, auto error) {
-      if (error) {
-        if (error == UV_EOF) {
-          resolve();
-        } else {
-          reject(std::make_exception_ptr(error));
-        }
-      } else {
-        try {
-          cb(chunk);
-        } catch (const std::exception& e) {
-          // reject(std::make_exception_ptr(e));
-          throw;
-        }
-      }
-    });
-  });
+task<void> stream::readStartUntilEOF(std::function<void(std::string_view)> cb, cppcoro::cancellation_token token) {
+  co_await uv::detail::awaitCallback(
+      [this, &cb](auto& awaiter) {
+        readStart([&awaiter, &cb](auto chunk, auto error) {
+          if (error) {
+            if (error == UV_EOF) {
+              awaiter.resolve();
+            } else {
+              awaiter.reject(error);
+            }
+          } else {
+            cb(chunk);
+          }
+        });
+
+        awaiter.cancelWith([this]() {
+          cancel();
+        });
+      },
+      std::move(token));
 }
 #endif
 
@@ -143,6 +189,23 @@ void stream::readStop() {
   }
 }
 
+void stream::readSuspend() {
+  uv_read_stop(*this);
+}
+
+void stream::readResume() {
+  auto data_ptr = getData<data>();
+  if (data_ptr->sent_eof || !data_ptr->read_cb || isClosing()) {
+    return;
+  }
+
+  startReading();
+}
+
+void stream::readBufferSize(size_t size) noexcept {
+  getData<data>()->read_buffer_size = size;
+}
+
 void stream::readPause() {
   auto data_ptr = getData<data>();
   if (!data_ptr->sent_eof) {
@@ -179,60 +242,46 @@ void stream::readPause() {
 
 void stream::readLines(std::function<void(std::string&&, uv::error)> cb) {
   struct state_t {
-    std::stringstream stream;
+    uv::line_splitter lines;
+    std::function<void(std::string&&, uv::error)> cb;
   };
-  auto state = new state_t();
 
-  readStart([cb{std::move(cb)}, state](auto chunk, auto error) {
-    if (error) {
-      if (error == UV_EOF) {
-        // std::string line;
-        // std::getline(state->stream, line);
-        // cb(std::move(line), uv::error{0});
-      }
+  // owned by the read callback, so it goes away with it when the reader stops early or the handle is closed
+  readStart([state{std::make_shared<state_t>(state_t{{}, std::move(cb)})}](auto chunk, auto error) {
+    // `cb` may replace this read callback, the local copy keeps the state alive until feed() returned
+    auto keep = state;
 
-      delete state;
-      cb({}, error);
+    if (error) {
+      keep->cb({}, error);
     } else {
-      state->stream << chunk;
-
-      std::string line;
-      while (std::getline(state->stream, line)) {
-        if (line.ends_with('\r')) {
-          line.resize(line.size() - 1);
-        }
-
-        cb(std::move(line), uv::error{0});
-      }
-
-      if (state->stream.eof()) {
-        state->stream.clear();
-        state->stream.str({});
-      }
+      keep->lines.feed(chunk, [&keep](auto line) {
+        keep->cb((std::string)line, uv::error{0});
+      });
     }
   });
 }
 
 #ifdef UVPP_TASK_INCLUDE
-task<void> stream::readLinesUntilEOF(std::function<void(std::string&&)> cb) {
-  return task<void>::create([this, cb{std::move(cb)}](auto& resolve, auto& reject) {
-    readLines([&resolve, &reject, cb{std::move(cb)}](auto&& line, auto error) {
-      if (error) {
-        if (error == UV_EOF) {
-          resolve();
-        } else {
-          reject(std::make_exception_ptr(error));
-        }
-      } else {
-        try {
-          cb(std::move(line));
-        } catch (const std::exception& e) {
-          // reject(std::make_exception_ptr(e));
-          throw;
-        }
-      }
-    });
-  });
+task<void> stream::readLinesUntilEOF(std::function<void(std::string&&)> cb, cppcoro::cancellation_token token) {
+  co_await uv::detail::awaitCallback(
+      [this, &cb](auto& awaiter) {
+        readLines([&awaiter, &cb](auto&& line, auto error) {
+          if (error) {
+            if (error == UV_EOF) {
+              awaiter.resolve();
+            } else {
+              awaiter.reject(error);
+            }
+          } else {
+            cb(std::move(line));
+          }
+        });
+
+        awaiter.cancelWith([this]() {
+          cancel();
+        });
+      },
+      std::move(token));
 }
 
 // task<void> readLinesUntilEOF(std::function<task<void>(std::string&&)> cb) {
@@ -243,84 +292,105 @@ task<void> stream::readLinesUntilEOF(std::function<void(std::string&&)> cb) {
 #endif
 
 void stream::readLinesAsViews(std::function<void(std::string_view, uv::error)> cb) {
-  readStart([cb{std::move(cb)}](auto chunk, auto error) {
+  struct state_t {
+    uv::line_splitter lines;
+    std::function<void(std::string_view, uv::error)> cb;
+  };
+
+  // owned by the read callback, so it goes away with it when the reader stops early or the handle is closed
+  readStart([state{std::make_shared<state_t>(state_t{{}, std::move(cb)})}](auto chunk, auto error) {
+    // `cb` may replace this read callback, the local copy keeps the state alive until feed() returned
+    auto keep = state;
+
     if (error) {
-      cb({}, error);
+      keep->cb({}, error);
     } else {
-      size_t offset = 0;
-      size_t length = chunk.length();
-      for (size_t i = offset; i < length; i++) {
-        if (chunk[i] == '\n') {
-          short rm = 0;
-          if (chunk[i - 1] == '\r') {
-            rm = 1;
-          }
-
-          cb(chunk.substr(offset, (i - rm) - offset), uv::error{0});
-          offset = i + rm;
-        }
-      }
+      keep->lines.feed(chunk, [&keep](auto line) {
+        keep->cb(line, uv::error{0});
+      });
     }
   });
 }
 
 #ifdef UVPP_TASK_INCLUDE
-task<void> stream::readLinesAsViewsUntilEOF(std::function<void(std::string_view)> cb) {
-  return task<void>::create([this, cb{std::move(cb)}](auto& resolve, auto& reject) {
-    readLinesAsViews([&resolve, &reject, cb{std::move(cb)}](auto line, auto error) {
-      if (error) {
-        if (error == UV_EOF) {
-          resolve();
-        } else {
-          reject(std::make_exception_ptr(error));
-        }
-      } else {
-        try {
-          cb(line);
-        } catch (const std::exception& e) {
-          // reject(std::make_exception_ptr(e));
-          throw;
-        }
-      }
-    });
-  });
+task<void> stream::readLinesAsViewsUntilEOF(std::function<void(std::string_view)> cb, cppcoro::cancellation_token token) {
+  co_await uv::detail::awaitCallback(
+      [this, &cb](auto& awaiter) {
+        readLinesAsViews([&awaiter, &cb](auto line, auto error) {
+          if (error) {
+            if (error == UV_EOF) {
+              awaiter.resolve();
+            } else {
+              awaiter.reject(error);
+            }
+          } else {
+            cb(line);
+          }
+        });
+
+        awaiter.cancelWith([this]() {
+          cancel();
+        });
+      },
+      std::move(token));
 }
 #endif
 
 void stream::readAll(std::function<void(std::string&&, uv::error)> cb) {
-  struct state_t {
-    std::string result;
-  };
-  auto state = new state_t();
-
-  readStart([cb{std::move(cb)}, state](auto chunk, auto error) {
+  // owned by the read callback like the state of readLines()
+  readStart([cb{std::move(cb)}, result{std::make_shared<std::string>()}](auto chunk, auto error) {
     if (error) {
-      std::string result = std::move(state->result);
-      delete state;
+      // `cb` may replace this read callback
+      auto done = cb;
+      std::string all = std::move(*result);
 
       if (error == UV_EOF) {
-        cb(std::move(result), uv::error{0});
+        done(std::move(all), uv::error{0});
       } else {
-        cb({}, error);
+        done({}, error);
       }
     } else {
-      state->result += chunk;
+      *result += chunk;
     }
   });
 }
 
 #ifdef UVPP_TASK_INCLUDE
-task<std::string> stream::readAll() {
-  return task<std::string>::create([this](auto& resolve, auto& reject) {
-    readAll([&resolve, &reject](auto&& result, auto error) {
-      if (error) {
-        reject(std::make_exception_ptr(error));
-      } else {
-        resolve(result);
+task<std::string> stream::readAll(cppcoro::cancellation_token token) {
+  co_return co_await uv::detail::awaitCallback<std::string>(
+      [this](auto& awaiter) {
+        readAll([&awaiter](auto&& result, auto error) {
+          if (error) {
+            awaiter.reject(error);
+          } else {
+            awaiter.resolve(std::move(result));
+          }
+        });
+
+        awaiter.cancelWith([this]() {
+          cancel();
+        });
+      },
+      std::move(token));
+}
+#endif
+
+#ifdef UVPP_SSL_INCLUDE
+namespace detail {
+std::function<void(std::exception_ptr)> settleEncryptedWrite(std::function<void(uv::error)> cb) {
+  return [cb{std::move(cb)}](auto error) {
+    if (error) {
+      try {
+        std::rethrow_exception(error);
+      } catch (const uv::error& e) {
+        cb(e);
       }
-    });
-  });
+    } else {
+      cb(uv::error{0});
+    }
+  };
 }
+} // namespace detail
 #endif
 
 #ifdef UVPP_SSL_INCLUDE
@@ -328,6 +398,15 @@ void stream::write(std::string&& input, std::function<void(uv::error)> cb, bool
 #else
 void stream::write(std::string&& input, std::function<void(uv::error)> cb) {
 #endif
+#ifdef UVPP_SSL_INCLUDE
+  // raw writes carry ciphertext of the ssl state, queued plaintext has to go through it first
+  if (encrypted) {
+    submitWriteQueue();
+  }
+#else
+  submitWriteQueue();
+#endif
+
   auto _write = [this](std::string&& input, std::function<void(uv::error)>& cb) {
     struct data_t : public uv::detail::req::data {
       std::string input;
@@ -353,17 +432,7 @@ void stream::write(std::string&& input, std::function<void(uv::error)> cb) {
 
 #ifdef UVPP_SSL_INCLUDE
   if (_ssl_state && encrypted) {
-    _ssl_state.encrypt(std::move(input), [cb{std::move(cb)}](auto error) {
-      if (error) {
-        try {
-          std::rethrow_exception(error);
-        } catch (const uv::error& e) {
-          cb(e);
-        }
-      } else {
-        cb(uv::error{0});
-      }
-    });
+    _ssl_state.encrypt(std::move(input), uv::detail::settleEncryptedWrite(std::move(cb)));
   } else {
     _write(std::move(input), cb);
   }
@@ -384,23 +453,333 @@ void stream::write(std::string_view input, std::function<void(uv::error)> cb) {
 #endif
 }
 
+#ifdef UVPP_SSL_INCLUDE
+void stream::write(std::span<const uv_buf_t> bufs, std::function<void(uv::error)> cb, bool encrypted) {
+  if (encrypted) {
+    submitWriteQueue();
+  }
+
+  if (_ssl_state && encrypted) {
+    // every segment is fed to SSL_write directly, only the ciphertext ends up in a single buffer
+    std::vector<std::string_view> segments;
+    segments.reserve(bufs.size());
+    for (const auto& buf : bufs) {
+      segments.emplace_back(buf.base, buf.len);
+    }
+
+    _ssl_state.encrypt(segments, uv::detail::settleEncryptedWrite(std::move(cb)));
+    return;
+  }
+#else
+void stream::write(std::span<const uv_buf_t> bufs, std::function<void(uv::error)> cb) {
+  submitWriteQueue();
+#endif
+  struct data_t : public uv::detail::req::data {
+    std::function<void(uv::error)> cb;
+  };
+  using req_t = uv::req<uv_write_t, data_t>;
+
+  auto req = new req_t();
+  auto data = req->dataPtr();
+  data->cb = std::move(cb);
+
+  error::test(uv_write(*req, *this, bufs.data(), bufs.size(), [](uv_write_t* req, int status) {
+    auto data = req_t::dataPtr(req);
+    auto cb = std::move(data->cb);
+    delete data->req;
+
+    cb(uv::error{status});
+  }));
+}
+
+#ifdef UVPP_SSL_INCLUDE
+void stream::writev(
+    std::vector<std::shared_ptr<const std::string>> chunks, std::function<void(uv::error)> cb, bool encrypted) {
+#else
+void stream::writev(std::vector<std::shared_ptr<const std::string>> chunks, std::function<void(uv::error)> cb) {
+#endif
+  std::vector<uv_buf_t> bufs;
+  bufs.reserve(chunks.size());
+  for (const auto& chunk : chunks) {
+    bufs.push_back(uv_buf_init((char*)chunk->data(), chunk->length()));
+  }
+
+  // uv_write copies the buf descriptors, only the chunks themselves have to outlive the request
+  auto release = [chunks{std::move(chunks)}, cb{std::move(cb)}](auto error) {
+    cb(error);
+  };
+
+#ifdef UVPP_SSL_INCLUDE
+  write(bufs, std::move(release), encrypted);
+#else
+  write(bufs, std::move(release));
+#endif
+}
+
+#ifdef UVPP_TASK_INCLUDE
+namespace detail {
+auto awaitWrite(uv::stream& stream, std::span<const uv_buf_t> bufs, cppcoro::cancellation_token token) {
+  struct write_awaiter : public uv::detail::req_awaiter<uv_write_t> {
+    uv::stream& stream;
+    std::span<const uv_buf_t> bufs;
+
+    write_awaiter(uv::stream& s, std::span<const uv_buf_t> b, cppcoro::cancellation_token token)
+        : req_awaiter(std::move(token)), stream(s), bufs(b) {
+    }
+
+    void await_suspend(std::coroutine_handle<> waiter) {
+      this->waiter = waiter;
+      stream.submitWriteQueue();
+      error::test(uv_write(&native_req, stream, bufs.data(), bufs.size(), &write_awaiter::resume));
+
+      cancelWith([this]() {
+        stream.cancel();
+      });
+    }
+  };
+
+  return write_awaiter{stream, bufs, std::move(token)};
+}
+
+#ifdef UVPP_SSL_INCLUDE
+auto awaitEncryptedWrite(uv::stream& stream, std::span<const uv_buf_t> bufs, cppcoro::cancellation_token token) {
+  return uv::detail::awaitCallback(
+      [&stream, bufs](auto& awaiter) {
+        stream.write(bufs, [&awaiter](auto error) {
+          awaiter.settle(error);
+        });
+
+        awaiter.cancelWith([&stream]() {
+          stream.cancel();
+        });
+      },
+      std::move(token));
+}
+#endif
+
+task<void> write(uv::stream& stream, std::string input, cppcoro::cancellation_token token) {
+  uv_buf_t buf = uv_buf_init(input.data(), input.length());
+
+#ifdef UVPP_SSL_INCLUDE
+  if (stream.sslState()) {
+    co_await awaitEncryptedWrite(stream, {&buf, 1}, std::move(token));
+    co_return;
+  }
+#endif
+
+  co_await awaitWrite(stream, {&buf, 1}, std::move(token));
+}
+
+task<void> write(uv::stream& stream, std::span<const uv_buf_t> bufs, cppcoro::cancellation_token token) {
+#ifdef UVPP_SSL_INCLUDE
+  if (stream.sslState()) {
+    co_await awaitEncryptedWrite(stream, bufs, std::move(token));
+    co_return;
+  }
+#endif
+
+  co_await awaitWrite(stream, bufs, std::move(token));
+}
+
+task<void> writev(uv::stream& stream, std::vector<std::shared_ptr<const std::string>> chunks,
+    cppcoro::cancellation_token token) {
+  std::vector<uv_buf_t> bufs;
+  bufs.reserve(chunks.size());
+  for (const auto& chunk : chunks) {
+    bufs.push_back(uv_buf_init((char*)chunk->data(), chunk->length()));
+  }
+
+  co_await write(stream, bufs, std::move(token));
+}
+} // namespace detail
+
+task<void> stream::write(std::string&& input, cppcoro::cancellation_token token) {
+  return uv::detail::write(*this, std::move(input), std::move(token));
+}
+
+task<void> stream::write(std::string_view input, cppcoro::cancellation_token token) {
+  return write((std::string)input, std::move(token));
+}
+
+task<void> stream::write(std::span<const uv_buf_t> bufs, cppcoro::cancellation_token token) {
+  return uv::detail::write(*this, bufs, std::move(token));
+}
+
+task<void> stream::writev(std::vector<std::shared_ptr<const std::string>> chunks, cppcoro::cancellation_token token) {
+  return uv::detail::writev(*this, std::move(chunks), std::move(token));
+}
+#endif
+
+namespace detail {
+void settleDrains(uv::stream::data* data_ptr) {
+  // a resumed producer may queue more data, wait again or cancel another drain while this runs
+  while (!data_ptr->drain_cbs.empty()) {
+    if (!data_ptr->write_error && data_ptr->write_queue_size > data_ptr->write_low_watermark) {
+      return;
+    }
+
+    auto cb = std::move(data_ptr->drain_cbs.front());
+    data_ptr->drain_cbs.pop_front();
+
+    cb(data_ptr->write_error);
+  }
+}
+
+void failWriteQueue(uv::stream::data* data_ptr, uv::error error) {
+  data_ptr->write_error = error;
+
+  for (const auto& input : data_ptr->write_queue) {
+    data_ptr->write_queue_size -= input.length();
+  }
+  data_ptr->write_queue.clear();
+
+  settleDrains(data_ptr);
+}
+} // namespace detail
+
+bool stream::queueWrite(std::string&& input) {
+  auto data_ptr = getData<data>();
+  if (data_ptr->write_error) {
+    return false;
+  }
+
+  if (!input.empty()) {
+    data_ptr->write_queue_size += input.length();
+    data_ptr->write_queue.push_back(std::move(input));
+
+    if (!_write_flush) {
+      _write_flush = std::make_unique<uv::check>(((uv_handle_t*)_native_stream)->loop);
+      _write_flush_idle = std::make_unique<uv::idle>(((uv_handle_t*)_native_stream)->loop);
+    }
+
+    // check handles run right after the poll phase, so everything queued by io callbacks goes out together
+    if (!_write_flush->isActive()) {
+      _write_flush->start([this]() {
+        flushWriteQueue();
+      });
+
+      // queued outside of the poll phase (timers, deferred write callbacks, the check itself) the next poll would block
+      // before the check runs. an active idle handle makes it return right away
+      _write_flush_idle->start([]() {});
+    }
+  }
+
+  return data_ptr->write_queue_size < data_ptr->write_high_watermark;
+}
+
+bool stream::queueWrite(std::string_view input) {
+  return queueWrite((std::string)input);
+}
+
+size_t stream::writeQueueSize() const noexcept {
+  return handle::getData<data>(_native_stream)->write_queue_size;
+}
+
+void stream::writeWatermarks(size_t low, size_t high) noexcept {
+  auto data_ptr = getData<data>();
+  data_ptr->write_low_watermark = low;
+  data_ptr->write_high_watermark = high;
+}
+
+void stream::drain(std::function<void(uv::error)> cb) {
+  auto data_ptr = getData<data>();
+
+  if (data_ptr->write_error || data_ptr->write_queue_size <= data_ptr->write_low_watermark) {
+    cb(data_ptr->write_error);
+    return;
+  }
+
+  data_ptr->drain_cbs.push_back(std::move(cb));
+}
+
 #ifdef UVPP_TASK_INCLUDE
-task<void> stream::write(std::string&& input) {
-  return task<void>::create([this, input{std::move(input)}](auto& resolve, auto& reject) mutable {
-    write(std::move(input), [&resolve, &reject](auto error) {
+task<void> stream::drain(cppcoro::cancellation_token token) {
+  uv::timer_wheel::entry cancelled;
+
+  co_await uv::detail::awaitCallback(
+      [this, &cancelled](auto& awaiter) {
+        auto data_ptr = getData<data>();
+
+        if (data_ptr->write_error || data_ptr->write_queue_size <= data_ptr->write_low_watermark) {
+          awaiter.settle(data_ptr->write_error);
+          return;
+        }
+
+        auto it = data_ptr->drain_cbs.insert(data_ptr->drain_cbs.end(), [&awaiter](auto error) {
+          awaiter.settle(error);
+        });
+
+        // only stops waiting, the queued data is still written. rejected on the next tick instead of from inside the
+        // cancellation callback
+        awaiter.cancelWith([this, data_ptr, it, &awaiter, &cancelled]() {
+          data_ptr->drain_cbs.erase(it);
+
+          uv::timer_wheel::of(loop()).schedule(cancelled, 0, [&awaiter]() {
+            awaiter.reject(uv::error{UV_ECANCELED});
+          });
+        });
+      },
+      std::move(token));
+}
+#endif
+
+void stream::flushWriteQueue() {
+  auto data_ptr = getData<data>();
+  _write_flush_idle->stop();
+
+  if (isClosing()) {
+    _write_flush->stop();
+    uv::detail::failWriteQueue(data_ptr, uv::error{UV_ECANCELED});
+    return;
+  }
+
+  // the check keeps running until the pending writes completed, so the next batch collects everything queued meanwhile
+  if (data_ptr->writes_in_flight) {
+    return;
+  }
+
+  _write_flush->stop();
+  submitWriteQueue();
+}
+
+void stream::submitWriteQueue() {
+  auto data_ptr = getData<data>();
+  if (data_ptr->write_queue.empty()) {
+    return;
+  }
+
+  // taken before write() runs, which submits the queue itself
+  auto chunks = std::make_shared<std::vector<std::string>>(std::move(data_ptr->write_queue));
+  data_ptr->write_queue.clear();
+
+  std::vector<uv_buf_t> bufs;
+  bufs.reserve(chunks->size());
+  size_t size = 0;
+  for (auto& chunk : *chunks) {
+    bufs.push_back(uv_buf_init(chunk.data(), chunk.length()));
+    size += chunk.length();
+  }
+
+  data_ptr->writes_in_flight += 1;
+
+  try {
+    write(bufs, [data_ptr, chunks, size](auto error) {
+      data_ptr->writes_in_flight -= 1;
+      data_ptr->write_queue_size -= size;
+
       if (error) {
-        reject(std::make_exception_ptr(error));
+        uv::detail::failWriteQueue(data_ptr, error);
       } else {
-        resolve();
+        uv::detail::settleDrains(data_ptr);
       }
     });
-  });
-}
+  } catch (const uv::error& error) {
+    data_ptr->writes_in_flight -= 1;
+    data_ptr->write_queue_size -= size;
 
-task<void> stream::write(std::string_view input) {
-  return write((std::string)input);
+    uv::detail::failWriteQueue(data_ptr, error);
+  }
 }
-#endif
 
 bool stream::isReadable() const noexcept {
   return uv_is_readable(*this) != 0;
@@ -438,18 +817,23 @@ void stream::useSSL(ssl::context& ssl_context) {
 }
 
 void stream::handshake(std::function<void(uv::error)> cb) {
-  _ssl_state.handshake([this, cb]() {
-    cb(uv::error{0});
+  // `cb` settles the handshake only, a read error after it completed must not report to it again
+  auto handshake_cb = std::make_shared<std::function<void(uv::error)>>(std::move(cb));
+
+  _ssl_state.handshake([handshake_cb]() {
+    if (auto cb = std::exchange(*handshake_cb, nullptr)) {
+      cb(uv::error{0});
+    }
   });
 
   readStart(
-      [this, cb](auto data, auto error) {
+      [this, handshake_cb](auto data, auto error) {
         if (error) {
           auto data_ptr = getData<uv::stream::data>();
 
           if (data_ptr->read_decrypted_cb) {
             data_ptr->read_decrypted_cb(std::string_view{nullptr, 0}, error);
-          } else if (cb) {
+          } else if (auto cb = std::exchange(*handshake_cb, nullptr)) {
             cb(error);
           }
         } else {
@@ -460,16 +844,18 @@ void stream::handshake(std::function<void(uv::error)> cb) {
 }
 
 #ifdef UVPP_TASK_INCLUDE
-task<void> stream::handshake() {
-  return task<void>::create([this](auto& resolve, auto& reject) {
-    handshake([&resolve, &reject](auto error) {
-      if (error) {
-        reject(std::make_exception_ptr(error));
-      } else {
-        resolve();
-      }
-    });
-  });
+task<void> stream::handshake(cppcoro::cancellation_token token) {
+  co_await uv::detail::awaitCallback(
+      [this](auto& awaiter) {
+        handshake([&awaiter](auto error) {
+          awaiter.settle(error);
+        });
+
+        awaiter.cancelWith([this]() {
+          cancel();
+        });
+      },
+      std::move(token));
 }
 #endif
 
@@ -1,6 +1,201 @@
 #include "uvpp/tcp.hpp"
+#include "uvpp/loop.hpp"
+#include "uvpp/wheel.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 namespace uv {
+namespace detail {
+thread_local std::unordered_map<uv_loop_t*, tcp::connect_statistics> connect_statistics;
+
+// one connect() over all candidates of an addrinfo. every attempt but a lone candidate connects its own handle, the
+// target swaps its unused native handle with the one of the winner
+struct connect_race : public std::enable_shared_from_this<connect_race> {
+  uv::tcp& target;
+  uv::dns::addrinfo addr;
+  std::vector<const sockaddr*> candidates;
+  std::function<void(uv::error)> cb;
+
+  size_t next = 0;
+  size_t pending = 0;
+  std::list<uv::tcp> attempts;
+  uv::timer_wheel::entry delay;
+  uv::error error;
+  uint64_t started = uv_hrtime();
+  bool aborted = false;
+  bool done = false;
+
+  connect_race(uv::tcp& t, uv::dns::addrinfo a, std::function<void(uv::error)> c)
+      : target(t), addr(std::move(a)), cb(std::move(c)) {
+    std::vector<const sockaddr*> v6;
+    std::vector<const sockaddr*> v4;
+    for (auto info = addr.get(); info; info = info->ai_next) {
+      if (info->ai_socktype != 0 && info->ai_socktype != SOCK_STREAM) {
+        continue;
+      }
+
+      if (info->ai_family == AF_INET6) {
+        v6.push_back(info->ai_addr);
+      } else if (info->ai_family == AF_INET) {
+        v4.push_back(info->ai_addr);
+      }
+    }
+
+    // alternate families, starting with the one getaddrinfo preferred
+    bool v6_first = addr && addr->ai_family == AF_INET6;
+    auto& first = v6_first ? v6 : v4;
+    auto& second = v6_first ? v4 : v6;
+    for (size_t i = 0; i < std::max(first.size(), second.size()); i++) {
+      if (i < first.size()) {
+        candidates.push_back(first[i]);
+      }
+      if (i < second.size()) {
+        candidates.push_back(second[i]);
+      }
+    }
+  }
+
+  void start() {
+    if (candidates.empty()) {
+      finish(uv::error{UV_EAI_NONAME});
+      return;
+    }
+
+    startAttempt();
+  }
+
+  void abort() {
+    if (done || aborted) {
+      return;
+    }
+
+    // the closed attempts fail with UV_ECANCELED, the last one finishes the race
+    aborted = true;
+    uv::timer_wheel::of(target.loop()).cancel(delay);
+    attempts.clear();
+
+    if (candidates.size() == 1) {
+      target.cancel();
+    }
+  }
+
+  void startAttempt() {
+    struct data_t : public uv::detail::req::data {
+      std::shared_ptr<connect_race> race;
+      std::list<uv::tcp>::iterator attempt;
+    };
+    using req_t = uv::req<uv_connect_t, data_t>;
+
+    auto candidate = candidates[next++];
+    tcp::connectStats(target.loop()).attempts += 1;
+
+    uv::tcp* handle = &target;
+    std::list<uv::tcp>::iterator attempt;
+    if (candidates.size() > 1) {
+      attempt = attempts.emplace(attempts.end(), target.loop());
+      handle = &*attempt;
+    }
+
+    auto req = new req_t();
+    auto data = req->dataPtr();
+    data->race = shared_from_this();
+    data->attempt = attempt;
+
+    int status = uv_tcp_connect(*req, *handle, candidate, [](uv_connect_t* req, int status) {
+      auto data = req_t::dataPtr(req);
+      auto race = std::move(data->race);
+      auto attempt = data->attempt;
+      delete data->req;
+
+      race->pending -= 1;
+      race->onAttempt(attempt, status);
+    });
+
+    if (status != 0) {
+      // e.g. no IPv6 on this host, counts as a failed attempt
+      delete req;
+      onAttempt(attempt, status);
+      return;
+    }
+
+    pending += 1;
+
+    if (next < candidates.size()) {
+      uv::timer_wheel::of(target.loop()).schedule(delay, tcp::connection_attempt_delay, [this]() {
+        startAttempt();
+      });
+    }
+  }
+
+  void onAttempt(std::list<uv::tcp>::iterator attempt, int status) {
+    if (done) {
+      return;
+    }
+
+    if (aborted) {
+      if (pending == 0) {
+        finish(uv::error{UV_ECANCELED});
+      }
+      return;
+    }
+
+    if (status == 0) {
+      if (candidates.size() > 1) {
+        // the target was cancelled (closed) while the attempts were running
+        if (target.isClosing()) {
+          finish(uv::error{UV_ECANCELED});
+          return;
+        }
+
+        // the target's native handle ends up in the attempt, which is closed with the others
+        target.swapNative(*attempt);
+      }
+
+      finish(uv::error{status});
+      return;
+    }
+
+    error = uv::error{status};
+    if (candidates.size() > 1) {
+      attempts.erase(attempt);
+    }
+
+    if (next < candidates.size()) {
+      // a failed attempt starts the next one right away
+      uv::timer_wheel::of(target.loop()).cancel(delay);
+      startAttempt();
+    } else if (pending == 0) {
+      finish(error);
+    }
+  }
+
+  void finish(uv::error result) {
+    done = true;
+    uv::timer_wheel::of(target.loop()).cancel(delay);
+    attempts.clear();
+
+    auto& stats = tcp::connectStats(target.loop());
+    if (result) {
+      stats.failures += 1;
+    } else {
+      auto connect_time = std::chrono::nanoseconds{uv_hrtime() - started};
+      stats.connects += 1;
+      stats.connect_time += connect_time;
+      stats.max_connect_time = std::max(stats.max_connect_time, connect_time);
+    }
+
+    auto callback = std::move(cb);
+    callback(result);
+  }
+};
+} // namespace detail
+
 tcp::data::data(uv_tcp_t* native_tcp) : _native_tcp(native_tcp) {
 }
 
@@ -22,6 +217,11 @@ tcp::tcp(uv_tcp_t* native_tcp) : tcp(uv_default_loop(), native_tcp) {
 tcp::tcp() : tcp(uv_default_loop(), new uv_tcp_t()) {
 }
 
+void tcp::swapNative(tcp& other) noexcept {
+  stream::swapNative(other);
+  std::swap(_native_tcp, other._native_tcp);
+}
+
 tcp::operator uv_tcp_t*() noexcept {
   return _native_tcp;
 }
@@ -68,7 +268,40 @@ void tcp::simultaneousAccepts(bool enable) {
   uv_tcp_simultaneous_accepts(*this, enable);
 }
 
+void tcp::reusePort(bool enable) {
+#ifdef SO_REUSEPORT
+  getData<data>()->reuse_port = enable;
+#else
+  if (enable) {
+    throw uv::error{UV_ENOTSUP};
+  }
+#endif
+}
+
 void tcp::bind(const sockaddr* addr, unsigned int flags) {
+#ifdef SO_REUSEPORT
+  // libuv only creates the socket in uv_tcp_bind, so the option has to be set on a socket opened by hand
+  if (getData<data>()->reuse_port) {
+    uv_os_sock_t sock = socket(addr->sa_family, SOCK_STREAM, 0);
+    if (sock < 0) {
+      throw uv::error{uv_translate_sys_error(errno)};
+    }
+
+    int enable = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) != 0) {
+      int code = uv_translate_sys_error(errno);
+      ::close(sock);
+      throw uv::error{code};
+    }
+
+    int code = uv_tcp_open(*this, sock);
+    if (code != 0) {
+      ::close(sock);
+      throw uv::error{code};
+    }
+  }
+#endif
+
   error::test(uv_tcp_bind(*this, addr, flags));
 }
 
@@ -113,22 +346,7 @@ std::string tcp::peername() {
 
 void tcp::connect(uv::dns::addrinfo addr, std::function<void(uv::error)> cb) {
   auto _connect = [this](uv::dns::addrinfo addr, std::function<void(uv::error)>& cb) {
-    struct data_t : public uv::detail::req::data {
-      std::function<void(uv::error)> cb;
-    };
-    using req_t = uv::req<uv_connect_t, data_t>;
-
-    auto req = new req_t();
-    auto data = req->dataPtr();
-    data->cb = cb;
-
-    error::test(uv_tcp_connect(*req, *this, addr->ai_addr, [](uv_connect_t* req, int status) {
-      auto data = req_t::dataPtr(req);
-      auto cb = std::move(data->cb);
-      delete data->req;
-
-      cb(uv::error{status});
-    }));
+    std::make_shared<detail::connect_race>(*this, std::move(addr), std::move(cb))->start();
   };
 
 #ifdef UVPP_SSL_INCLUDE
@@ -152,21 +370,30 @@ void tcp::connect(uv::dns::addrinfo addr, std::function<void(uv::error)> cb) {
 }
 
 #ifdef UVPP_TASK_INCLUDE
-task<void> tcp::connect(uv::dns::addrinfo addr) {
-  return task<void>::create([this, &addr](auto& resolve, auto& reject) {
-    connect(addr, [&resolve, &reject](auto error) {
-      if (error) {
-        reject(std::make_exception_ptr(error));
-      } else {
-        resolve();
-      }
-    });
-  });
+task<void> tcp::connect(uv::dns::addrinfo addr, cppcoro::cancellation_token token) {
+  co_await uv::detail::awaitCallback(
+      [this, &addr](auto& awaiter) {
+        auto race = std::make_shared<detail::connect_race>(*this, std::move(addr), [&awaiter](uv::error error) {
+          awaiter.settle(error);
+        });
+        race->start();
+
+        awaiter.cancelWith([race]() {
+          race->abort();
+        });
+      },
+      token);
+
+#ifdef UVPP_SSL_INCLUDE
+  if (_ssl_state) {
+    co_await handshake(std::move(token));
+  }
+#endif
 }
 #endif
 
 void tcp::connect(const std::string& node, const std::string& service, std::function<void(uv::error)> cb) {
-  uv::dns::getaddrinfo(node, service, [this, cb](auto addr, auto error) {
+  uv::dns::cache::of(_native_tcp->loop).resolve(node, service, [this, cb](auto addr, auto error) {
     if (error) {
       cb(error);
       return;
@@ -177,10 +404,10 @@ void tcp::connect(const std::string& node, const std::string& service, std::func
 }
 
 #ifdef UVPP_TASK_INCLUDE
-task<void> tcp::connect(const std::string& node, const std::string& service) {
-  auto addr = co_await uv::dns::getaddrinfo(node, service);
+task<void> tcp::connect(const std::string& node, const std::string& service, cppcoro::cancellation_token token) {
+  auto addr = co_await uv::dns::cache::of(_native_tcp->loop).resolve(node, service, token);
 
-  co_await connect(addr);
+  co_await connect(addr, std::move(token));
 }
 #endif
 
@@ -189,8 +416,20 @@ void tcp::connect(const std::string& node, short port, std::function<void(uv::er
 }
 
 #ifdef UVPP_TASK_INCLUDE
-task<void> tcp::connect(const std::string& node, short port) {
-  co_await connect(node, std::to_string(port));
+task<void> tcp::connect(const std::string& node, short port, cppcoro::cancellation_token token) {
+  co_await connect(node, std::to_string(port), std::move(token));
 }
 #endif
+
+tcp::connect_statistics& tcp::connectStats(uv_loop_t* native_loop) {
+  auto [stats, inserted] = detail::connect_statistics.try_emplace(native_loop);
+  if (inserted) {
+    // a loop initialized later may get the same address
+    uv::detail::atRelease(native_loop, [native_loop]() {
+      detail::connect_statistics.erase(native_loop);
+    });
+  }
+
+  return stats->second;
+}
 } // namespace uv
@@ -53,10 +53,21 @@ void timer::startOnce(uint64_t timeout, std::function<void()> cb) {
 }
 
 #ifdef UVPP_TASK_INCLUDE
-task<void> timer::startOnce(uint64_t timeout) {
-  return task<void>::create([this, timeout](auto& resolve, auto& reject) {
-    startOnce(timeout, resolve);
-  });
+task<void> timer::startOnce(uint64_t timeout, cppcoro::cancellation_token token) {
+  co_await uv::detail::awaitCallback(
+      [this, timeout](auto& awaiter) {
+        startOnce(timeout, [&awaiter]() {
+          awaiter.resolve();
+        });
+
+        // fail on the next loop iteration instead of completing from inside the cancellation callback
+        awaiter.cancelWith([this, &awaiter]() {
+          startOnce(0, [&awaiter]() {
+            awaiter.reject(uv::error{UV_ECANCELED});
+          });
+        });
+      },
+      std::move(token));
 }
 #endif
 
@@ -85,9 +96,31 @@ void timeout(uint64_t timeout, std::function<void()> cb) {
 }
 
 #ifdef UVPP_TASK_INCLUDE
-task<void> timeout(uint64_t timeout) {
+task<void> timeout(uint64_t timeout, cppcoro::cancellation_token token) {
   uv::timer timer;
-  co_await timer.startOnce(timeout);
+  co_await timer.startOnce(timeout, std::move(token));
+}
+
+deadline::deadline(uint64_t timeout, uv_loop_t* native_loop) : _timer(native_loop) {
+  _timer.startOnce(timeout, [source{_source}]() mutable {
+    source.request_cancellation();
+  });
+}
+
+cppcoro::cancellation_token deadline::token() const noexcept {
+  return _source.token();
+}
+
+deadline::operator cppcoro::cancellation_token() const noexcept {
+  return token();
+}
+
+bool deadline::expired() const noexcept {
+  return _source.is_cancellation_requested();
+}
+
+void deadline::cancel() {
+  _source.request_cancellation();
 }
 #endif
 } // namespace uv
@@ -0,0 +1,279 @@
+#include "uvpp/wheel.hpp"
+#include "uvpp/loop.hpp"
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+
+namespace uv {
+namespace detail {
+struct timer_wheels_t {
+  std::unordered_map<uv_loop_t*, std::unique_ptr<timer_wheel>> wheels;
+
+  uv_loop_t* last_loop = nullptr;
+  timer_wheel* last_wheel = nullptr;
+};
+
+thread_local timer_wheels_t timer_wheels;
+
+void unlink(wheel_link& link) noexcept {
+  link.prev->next = link.next;
+  link.next->prev = link.prev;
+  link.prev = nullptr;
+  link.next = nullptr;
+}
+
+void append(wheel_link& list, wheel_link& link) noexcept {
+  link.prev = list.prev;
+  link.next = &list;
+  list.prev->next = &link;
+  list.prev = &link;
+}
+
+// moves all links of `source` into the empty list `target`
+void splice(wheel_link& source, wheel_link& target) noexcept {
+  if (source.next == &source) {
+    return;
+  }
+
+  target.next = source.next;
+  target.prev = source.prev;
+  target.next->prev = &target;
+  target.prev->next = &target;
+
+  source.next = &source;
+  source.prev = &source;
+}
+} // namespace detail
+
+timer_wheel::entry::entry(std::function<void()> cb) : cb(std::move(cb)) {
+}
+
+timer_wheel::entry::~entry() {
+  if (_wheel) {
+    _wheel->cancel(*this);
+  }
+}
+
+bool timer_wheel::entry::active() const noexcept {
+  return _wheel != nullptr;
+}
+
+timer_wheel::timer_wheel(uv_loop_t* native_loop, uint64_t resolution)
+    : _native_loop(native_loop), _resolution(resolution == 0 ? 1 : resolution) {
+  for (auto& level : _slots) {
+    for (auto& slot : level) {
+      slot.prev = &slot;
+      slot.next = &slot;
+    }
+  }
+}
+
+timer_wheel::~timer_wheel() {
+  for (auto& level : _slots) {
+    for (auto& slot : level) {
+      while (slot.next != &slot) {
+        auto& e = static_cast<entry&>(*slot.next);
+        detail::unlink(e);
+        e._wheel = nullptr;
+      }
+    }
+  }
+}
+
+timer_wheel& timer_wheel::of(uv_loop_t* native_loop) {
+  auto& state = detail::timer_wheels;
+  if (state.last_loop == native_loop) {
+    return *state.last_wheel;
+  }
+
+  auto& wheel = state.wheels[native_loop];
+  if (!wheel) {
+    wheel = std::make_unique<timer_wheel>(native_loop);
+
+    // closes the uv timer of the wheel, so it does not outlive its loop
+    uv::detail::atRelease(native_loop, [native_loop]() {
+      auto& state = detail::timer_wheels;
+      state.wheels.erase(native_loop);
+      if (state.last_loop == native_loop) {
+        state.last_loop = nullptr;
+        state.last_wheel = nullptr;
+      }
+    });
+  }
+
+  state.last_loop = native_loop;
+  state.last_wheel = wheel.get();
+  return *wheel;
+}
+
+void timer_wheel::schedule(entry& e, uint64_t timeout) {
+  if (e._wheel == this) {
+    remove(e);
+  } else if (e._wheel) {
+    e._wheel->cancel(e);
+  }
+
+  auto tick = now();
+  if (_size == 0) {
+    // nothing is pending, so the skipped ticks do not have to be walked
+    _current = tick;
+  }
+
+  e._wheel = this;
+  e._expires = std::max(tick + (timeout + _resolution - 1) / _resolution, _current + 1);
+  insert(e);
+  _size += 1;
+
+  if (_next_tick == 0 || e._expires < _next_tick) {
+    arm(e._expires);
+  }
+}
+
+void timer_wheel::schedule(entry& e, uint64_t timeout, std::function<void()> cb) {
+  e.cb = std::move(cb);
+  schedule(e, timeout);
+}
+
+void timer_wheel::cancel(entry& e) noexcept {
+  if (e._wheel != this) {
+    return;
+  }
+
+  remove(e);
+
+  // an idle wheel must not keep its loop alive
+  if (_size == 0) {
+    _next_tick = 0;
+    _timer.reset();
+  }
+}
+
+size_t timer_wheel::size() const noexcept {
+  return _size;
+}
+
+#ifdef UVPP_TASK_INCLUDE
+task<void> timer_wheel::sleep(uint64_t timeout, cppcoro::cancellation_token token) {
+  entry sleeper;
+
+  co_await uv::detail::awaitCallback(
+      [this, &sleeper, timeout](auto& awaiter) {
+        schedule(sleeper, timeout, [&awaiter]() {
+          awaiter.resolve();
+        });
+
+        // fail on the next tick instead of completing from inside the cancellation callback
+        awaiter.cancelWith([this, &sleeper, &awaiter]() {
+          schedule(sleeper, 0, [&awaiter]() {
+            awaiter.reject(uv::error{UV_ECANCELED});
+          });
+        });
+      },
+      std::move(token));
+}
+#endif
+
+void timer_wheel::remove(entry& e) noexcept {
+  detail::unlink(e);
+  e._wheel = nullptr;
+  _size -= 1;
+}
+
+uint64_t timer_wheel::now() const noexcept {
+  return uv_now(_native_loop) / _resolution;
+}
+
+void timer_wheel::insert(entry& e) noexcept {
+  uint64_t delta = e._expires - _current;
+
+  for (size_t level = 0; level < levels; level++) {
+    if (delta < (uint64_t)1 << (slot_bits * (level + 1))) {
+      size_t index = (e._expires >> (slot_bits * level)) & (slots - 1);
+      detail::append(_slots[level][index], e);
+      return;
+    }
+  }
+
+  // beyond the range of the wheel, parked in the slot cascaded last and re-inserted from there
+  size_t index = ((_current >> (slot_bits * (levels - 1))) - 1) & (slots - 1);
+  detail::append(_slots[levels - 1][index], e);
+}
+
+void timer_wheel::cascade(size_t level, size_t index) noexcept {
+  detail::wheel_link pending;
+  detail::splice(_slots[level][index], pending);
+
+  while (pending.next && pending.next != &pending) {
+    auto& e = static_cast<entry&>(*pending.next);
+    detail::unlink(e);
+    insert(e);
+  }
+}
+
+void timer_wheel::advance(uint64_t tick) {
+  while (_current < tick) {
+    _current += 1;
+
+    for (size_t level = 1; level < levels; level++) {
+      if ((_current & (((uint64_t)1 << (slot_bits * level)) - 1)) != 0) {
+        break;
+      }
+
+      cascade(level, (_current >> (slot_bits * level)) & (slots - 1));
+    }
+
+    // callbacks may schedule or cancel any entry, including the ones still pending here
+    detail::wheel_link pending;
+    detail::splice(_slots[0][_current & (slots - 1)], pending);
+
+    while (pending.next && pending.next != &pending) {
+      auto& e = static_cast<entry&>(*pending.next);
+      detail::unlink(e);
+      e._wheel = nullptr;
+      _size -= 1;
+
+      e.cb();
+    }
+  }
+}
+
+void timer_wheel::arm(uint64_t tick) {
+  _next_tick = tick;
+
+  auto current = now();
+  uint64_t timeout = tick > current ? (tick - current) * _resolution : 0;
+
+  if (!_timer) {
+    _timer.emplace(_native_loop);
+    _timer->start(
+        [this]() {
+          onTimer();
+        },
+        timeout, std::max<uint64_t>(timeout, 1));
+    return;
+  }
+
+  // again() restarts the timer with the repeat value, so the callback is only ever set once
+  _timer->repeat(std::max<uint64_t>(timeout, 1));
+  _timer->again();
+}
+
+void timer_wheel::onTimer() {
+  advance(now());
+
+  if (_size == 0) {
+    _next_tick = 0;
+    _timer.reset();
+    return;
+  }
+
+  // the next non-empty slot of the lowest level, or the next cascade. this also covers entries scheduled by the
+  // callbacks above, so whatever they armed is overridden
+  uint64_t tick = _current + 1;
+  while ((tick & (slots - 1)) != 0 && _slots[0][tick & (slots - 1)].next == &_slots[0][tick & (slots - 1)]) {
+    tick += 1;
+  }
+
+  arm(tick);
+}
+} // namespace uv
@@ -0,0 +1,135 @@
+#include "http.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <unordered_map>
+
+// a typical browser request parsed by one parser per connection, the handler reads a few fields and adds one.
+// prints ns and allocations per request, then the same fields stored in http::headers and in the
+// std::unordered_map<std::string, std::string> that was used before.
+// usage: bench_http_headers [requests]
+
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+  allocations += 1;
+  if (void* p = std::malloc(size != 0 ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+static constexpr std::string_view request_text = "GET /api/trivia/questions?limit=20&offset=40 HTTP/1.1\r\n"
+                                                 "Host: api.example.com\r\n"
+                                                 "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:109.0) Gecko/20100101 Firefox/118.0\r\n"
+                                                 "Accept: application/json, text/plain, */*\r\n"
+                                                 "Accept-Language: en-US,en;q=0.5\r\n"
+                                                 "Accept-Encoding: gzip, deflate, br\r\n"
+                                                 "Referer: https://example.com/\r\n"
+                                                 "Origin: https://example.com\r\n"
+                                                 "Connection: keep-alive\r\n"
+                                                 "Sec-Fetch-Dest: empty\r\n"
+                                                 "Sec-Fetch-Mode: cors\r\n"
+                                                 "Sec-Fetch-Site: same-site\r\n"
+                                                 "\r\n";
+
+static const std::pair<std::string_view, std::string_view> fields[] = {
+    {"Host", "api.example.com"},
+    {"User-Agent", "Mozilla/5.0 (X11; Linux x86_64; rv:109.0) Gecko/20100101 Firefox/118.0"},
+    {"Accept", "application/json, text/plain, */*"},
+    {"Accept-Language", "en-US,en;q=0.5"},
+    {"Accept-Encoding", "gzip, deflate, br"},
+    {"Referer", "https://example.com/"},
+    {"Origin", "https://example.com"},
+    {"Connection", "keep-alive"},
+    {"Sec-Fetch-Dest", "empty"},
+    {"Sec-Fetch-Mode", "cors"},
+    {"Sec-Fetch-Site", "same-site"},
+};
+
+template <typename F>
+static void bench(const char* name, int requests, F&& fn) {
+  size_t sink = 0;
+  size_t allocations_before = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  // the first requests warm up the parser and the allocator
+  int warmup = std::min(1000, requests / 10);
+  for (int i = 0; i < requests; i++) {
+    if (i == warmup) {
+      allocations_before = allocations;
+      start = std::chrono::steady_clock::now();
+    }
+
+    sink += fn();
+  }
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  int measured = requests - warmup;
+  std::printf("%-28s %6.0f ns/request %5.1f allocations/request (%zu)\n", name, seconds * 1e9 / measured,
+      (double)(allocations - allocations_before) / measured, sink);
+}
+
+int main(int argc, char** argv) {
+  int requests = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+  http::_1::parser<http::request> parser;
+  bench("parse + handler", requests, [&]() {
+    size_t sink = 0;
+
+    parser.execute(request_text);
+    parser.onComplete([&](http::request& request) {
+      sink += request.headers.value(http::headers::HOST).size();
+      sink += request.headers.value(http::headers::ACCEPT_ENCODING).find("gzip") != std::string_view::npos;
+      sink += request.headers.value(http::headers::CONNECTION) == "close";
+      sink += request.headers.count("x-forwarded-for");
+      request.headers[":peername"] = "127.0.0.1:12345";
+      sink += request.headers.size();
+    });
+    parser.next();
+
+    return sink;
+  });
+
+  bench("http::headers", requests, [&]() {
+    http::headers headers;
+    for (auto [name, value] : fields) {
+      headers[name] = value;
+    }
+
+    size_t sink = headers.value("host").size();
+    sink += headers.value("accept-encoding").size();
+    sink += headers.value("connection").size();
+    sink += headers.count("x-forwarded-for");
+    return sink;
+  });
+
+  bench("std::unordered_map", requests, [&]() {
+    std::unordered_map<std::string, std::string> headers;
+    for (auto [name, value] : fields) {
+      std::string lowercase{name};
+      std::transform(lowercase.begin(), lowercase.end(), lowercase.begin(), [](unsigned char c) {
+        return std::tolower(c);
+      });
+      headers[lowercase] = value;
+    }
+
+    size_t sink = headers["host"].size();
+    sink += headers["accept-encoding"].size();
+    sink += headers["connection"].size();
+    sink += headers.count("x-forwarded-for");
+    return sink;
+  });
+
+  return 0;
+}
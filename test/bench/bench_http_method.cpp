@@ -0,0 +1,49 @@
+#include "http/common.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// http::method and http::status conversions in both directions, cycling through a few common values.
+// usage: bench_http_method [conversions]
+
+template <typename F>
+static void bench(const char* name, int conversions, F&& fn) {
+  size_t sink = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < conversions; i++) {
+    sink += fn(i);
+  }
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::printf("%-24s %6.2f ns/conversion (%zu)\n", name, seconds * 1e9 / conversions, sink);
+}
+
+int main(int argc, char** argv) {
+  int conversions = argc > 1 ? std::atoi(argv[1]) : 20000000;
+
+  std::vector<std::string> methods = {"GET", "POST", "PUT", "DELETE", "HEAD", "OPTIONS", "PATCH", "CONNECT"};
+  std::vector<http_method> method_values = {
+      HTTP_GET, HTTP_POST, HTTP_PUT, HTTP_DELETE, HTTP_HEAD, HTTP_OPTIONS, HTTP_PATCH, HTTP_CONNECT};
+  std::vector<std::string> statuses = {
+      "OK", "NOT_FOUND", "CREATED", "BAD_REQUEST", "INTERNAL_SERVER_ERROR", "NO_CONTENT", "NOT_MODIFIED", "FORBIDDEN"};
+  std::vector<http_status> status_values = {HTTP_STATUS_OK, HTTP_STATUS_NOT_FOUND, HTTP_STATUS_CREATED,
+      HTTP_STATUS_BAD_REQUEST, HTTP_STATUS_INTERNAL_SERVER_ERROR, HTTP_STATUS_NO_CONTENT, HTTP_STATUS_NOT_MODIFIED,
+      HTTP_STATUS_FORBIDDEN};
+
+  bench("method(string_view)", conversions, [&](int i) {
+    return (size_t)(http_method)http::method{methods[i & 7]};
+  });
+  bench("method -> string_view", conversions, [&](int i) {
+    return ((std::string_view)http::method{method_values[i & 7]}).length();
+  });
+  bench("status(string_view)", conversions, [&](int i) {
+    return (size_t)(http_status)http::status{statuses[i & 7]};
+  });
+  bench("status -> string_view", conversions, [&](int i) {
+    return ((std::string_view)http::status{status_values[i & 7]}).length();
+  });
+
+  return 0;
+}
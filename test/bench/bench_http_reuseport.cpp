@@ -0,0 +1,105 @@
+#include "http.hpp"
+#include "http/serve.hpp"
+#include "uv.hpp"
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+// requests/s of the multi loop http::serve::listen. the clients run on their own loop and open one connection per
+// request, so the accept path is spread over the server loops too. prints how many requests each loop served.
+// usage: bench_http_reuseport [loops] [concurrent clients] [requests] [port]
+
+static int requests = 20000;
+static int port = 18100;
+static int started = 0;
+static int finished = 0;
+
+static std::atomic<int> served[64];
+
+static void request(uv_loop_t* loop) {
+  if (started >= requests) {
+    return;
+  }
+  started += 1;
+
+  auto client = new uv::tcp(loop);
+  client->connect("127.0.0.1", (short)port, [client, loop](auto error) {
+    if (error) {
+      std::fprintf(stderr, "connect: %s\n", error.what());
+      std::exit(1);
+    }
+
+    client->write(std::string_view{"GET / HTTP/1.1\r\nhost: localhost\r\nconnection: close\r\n\r\n"}, [](auto) {});
+    client->readStart([client, loop](auto, auto error) {
+      if (error) {
+        client->close([client, loop]() {
+          delete client;
+
+          finished += 1;
+          request(loop);
+        });
+      }
+    });
+  });
+}
+
+int main(int argc, char** argv) {
+  size_t loops = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1;
+  int clients = argc > 2 ? std::atoi(argv[2]) : 32;
+  requests = argc > 3 ? std::atoi(argv[3]) : requests;
+  port = argc > 4 ? std::atoi(argv[4]) : port;
+
+  if (loops == 0 || loops > 64) {
+    std::fprintf(stderr, "loops has to be within 1..64\n");
+    return 1;
+  }
+
+  std::signal(SIGPIPE, SIG_IGN);
+
+  cppcoro::cancellation_source stop;
+  std::thread server{[&]() {
+    std::atomic<int> index = 0;
+    http::serve::listen("127.0.0.1", port, loops,
+        [&]() -> http::serve::handler {
+          int i = index++;
+          return [i](http::request&, http::response& response) -> task<void> {
+            served[i] += 1;
+            response.status = http::OK;
+            response.body = "hello";
+            http::serve::normalize(response);
+            co_return;
+          };
+        },
+        {}, stop.token());
+  }};
+
+  // give every loop the time to bind
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  uint64_t start = uv_hrtime();
+  for (int i = 0; i < clients; i++) {
+    request(&loop);
+  }
+  uv_run(&loop, UV_RUN_DEFAULT);
+  double seconds = (uv_hrtime() - start) / 1e9;
+
+  std::printf("loops=%zu clients=%d requests=%d req/s=%.0f per loop:", loops, clients, finished, finished / seconds);
+  for (size_t i = 0; i < loops; i++) {
+    std::printf(" %d", served[i].load());
+  }
+  std::printf("\n");
+
+  stop.request_cancellation();
+  server.join();
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  uv_loop_close(&loop);
+
+  return 0;
+}
@@ -0,0 +1,90 @@
+#include "db/orm.hpp" // FOR_EACH
+#include "http.hpp"
+#include "http/serve.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// parsing a request target, looking up one query parameter and deserializing the whole query into a struct.
+// prints ns and allocations per operation.
+// usage: bench_http_url [operations]
+
+static size_t allocations = 0;
+
+void* operator new(size_t size) {
+  allocations += 1;
+  if (void* p = std::malloc(size != 0 ? size : 1)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  std::free(p);
+}
+
+struct list_options {
+  std::optional<std::string> search;
+  std::optional<std::string> orderBy;
+  std::optional<std::string> orderByDirection;
+  std::optional<uint32_t> offset;
+  std::optional<uint32_t> limit;
+  std::optional<bool> verified = true;
+  std::optional<bool> disabled = false;
+  std::optional<bool> reported;
+  std::optional<bool> shuffle = false;
+};
+
+HTTP_QUERY_PARAMS_SPECIALIZE(list_options, search, orderBy, orderByDirection, offset, limit, verified, disabled, reported,
+    shuffle);
+
+template <typename F>
+static void bench(const char* name, int operations, F&& fn) {
+  size_t sink = 0;
+  size_t allocations_before = allocations;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < operations; i++) {
+    sink += fn();
+  }
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::printf("%-24s %6.0f ns %5.1f allocations (%zu)\n", name, seconds * 1e9 / operations,
+      (double)(allocations - allocations_before) / operations, sink);
+}
+
+int main(int argc, char** argv) {
+  int operations = argc > 1 ? std::atoi(argv[1]) : 500000;
+
+  std::string_view target = "/api/trivia/questions?search=hello%20world&orderBy=createdAt&orderByDirection=DESC&limit=20"
+                            "&offset=40&verified=true&shuffle=false";
+
+  bench("url(target)", operations, [&]() {
+    http::url url{target, http::url::IN};
+    return url.path().length();
+  });
+
+  http::url url{target, http::url::IN};
+  bench("queryvalue<uint32_t>", operations, [&]() {
+    return (size_t)url.queryvalue<uint32_t>("limit").value_or(0);
+  });
+
+  bench("deserializeQuery", operations, [&]() {
+    list_options options;
+    http::serve::deserializeQuery(url, options);
+    return (size_t)options.limit.value_or(0) + options.search->length();
+  });
+
+  bench("url + deserializeQuery", operations, [&]() {
+    http::url url{target, http::url::IN};
+    list_options options;
+    http::serve::deserializeQuery(url, options);
+    return (size_t)options.limit.value_or(0);
+  });
+
+  return 0;
+}
@@ -0,0 +1,44 @@
+#include "task.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// starts and finishes detached tasks on every thread, which is what each accepted connection and spawned handler does.
+// a lock or an allocation in the reclaim path shows up as tasks/s dropping with the thread count.
+// usage: bench_task_detached [tasks per thread]
+
+static task<void> detached(std::atomic<size_t>& counter) {
+  counter.fetch_add(1, std::memory_order_relaxed);
+  co_return;
+}
+
+int main(int argc, char** argv) {
+  size_t tasks = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000000;
+
+  for (size_t threads : {1, 2, 4, 8}) {
+    std::atomic<size_t> counter = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    {
+      std::vector<std::thread> runners;
+      for (size_t t = 0; t < threads; t++) {
+        runners.emplace_back([&counter, tasks]() {
+          for (size_t i = 0; i < tasks; i++) {
+            detached(counter).start();
+          }
+        });
+      }
+      for (auto& runner : runners) {
+        runner.join();
+      }
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("threads=%zu tasks=%zu time=%.3fs tasks/s=%.0f\n", threads, counter.load(), elapsed, counter.load() / elapsed);
+  }
+
+  return 0;
+}
@@ -0,0 +1,51 @@
+#include "task-executor.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+// simulated requests: a few microseconds of cpu work each, spawned from one thread like an accept loop would.
+// requests/sec should go up with the worker count until it reaches the core count.
+// usage: bench_task_executor [requests] [work iterations]
+
+static uint64_t work(uint64_t seed, size_t iterations) {
+  for (size_t i = 0; i < iterations; i++) {
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+  }
+  return seed;
+}
+
+int main(int argc, char** argv) {
+  size_t requests = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+  size_t iterations = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2000;
+
+  size_t max_workers = std::thread::hardware_concurrency();
+  if (max_workers == 0) {
+    max_workers = 1;
+  }
+
+  for (size_t workers = 1; workers <= max_workers * 2; workers *= 2) {
+    std::atomic<uint64_t> sink = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    {
+      taskpp::executor executor{workers};
+      for (size_t i = 0; i < requests; i++) {
+        executor.spawn([&sink, i, iterations]() -> task<void> {
+          sink.fetch_add(work(i + 1, iterations), std::memory_order_relaxed);
+          co_return;
+        });
+      }
+      executor.stop();
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("workers=%zu requests=%zu time=%.3fs requests/s=%.0f (%llu)\n", workers, requests, elapsed, requests / elapsed,
+        (unsigned long long)sink.load());
+  }
+
+  return 0;
+}
@@ -0,0 +1,83 @@
+#include "uv.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+// loopback echo: every client keeps 4 writes of `chunk` bytes in flight and the server writes back whatever it reads.
+// prints the echoed throughput and the read buffer pool counters, with a warm pool nearly every read is a hit.
+// usage: bench_uv_echo [clients] [chunk bytes] [milliseconds] [port]
+
+static uv::tcp server;
+static uint64_t received = 0;
+static bool stopping = false;
+
+int main(int argc, char** argv) {
+  int clients = argc > 1 ? std::atoi(argv[1]) : 8;
+  size_t chunk = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 16384;
+  uint64_t duration = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 3000;
+  const char* port = argc > 4 ? argv[4] : "18095";
+
+  server.bind4("127.0.0.1", std::atoi(port));
+  server.listen([](auto) {
+    auto peer = new uv::tcp();
+    server.accept(*peer, [](auto) {});
+    peer->readStart([peer](auto data, auto error) {
+      if (error) {
+        peer->close([peer]() {
+          delete peer;
+        });
+        return;
+      }
+
+      peer->write(data, [](auto) {});
+    });
+  });
+
+  for (int i = 0; i < clients; i++) {
+    auto client = new uv::tcp();
+    client->connect("127.0.0.1", port, [client, chunk](auto error) {
+      if (error) {
+        std::fprintf(stderr, "connect: %s\n", error.what());
+        return;
+      }
+
+      auto payload = std::make_shared<std::string>(chunk, 'x');
+      auto pump = std::make_shared<std::function<void()>>();
+      *pump = [client, payload, pump]() {
+        if (stopping) {
+          return;
+        }
+
+        client->write(std::string_view{*payload}, [pump](auto error) {
+          if (!error) {
+            (*pump)();
+          }
+        });
+      };
+
+      for (int i = 0; i < 4; i++) {
+        (*pump)();
+      }
+
+      client->readStart([](auto data, auto) {
+        received += data.size();
+      });
+    });
+  }
+
+  static uint64_t start = uv_hrtime();
+  static uv::timer timer;
+  timer.start(
+      []() {
+        stopping = true;
+
+        double seconds = (uv_hrtime() - start) / 1e9;
+        auto stats = uv::buffer_pool::of(uv_default_loop()).stats();
+        std::printf("echo %.1f MB/s over %.1fs, pool hits=%llu misses=%llu idle=%llu\n", received / seconds / 1e6, seconds,
+            (unsigned long long)stats.hits, (unsigned long long)stats.misses, (unsigned long long)stats.idle);
+        std::exit(0);
+      },
+      duration);
+
+  uv::run();
+}
@@ -0,0 +1,96 @@
+#include "uvpp/lines.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <sstream>
+#include <vector>
+
+// splits a generated twitch irc log, fed in random chunks of up to 64 KiB like reads from a socket, once with the
+// stringstream + getline loop the bot used before and once with uv::line_splitter.
+// the line counts differ by the lines split across chunks.
+// usage: bench_uv_lines [log MiB]
+
+static std::string makeLog(size_t bytes) {
+  std::mt19937 rng{42};
+  const char* users[] = {"forsen", "xqc", "pajlada", "somebody_with_a_long_name", "a"};
+
+  std::string log;
+  while (log.size() < bytes) {
+    std::string user = users[rng() % 5];
+    std::string message(rng() % 200 + 1, ' ');
+    for (auto& c : message) {
+      c = "abcdefgh ijklmnop KEKW LUL"[rng() % 26];
+    }
+
+    log += "@badge-info=;badges=;color=#FF0000;display-name=" + user +
+        ";emotes=;flags=;id=1234-5678;mod=0;room-id=22484632;subscriber=0;tmi-sent-ts=1600000000000;turbo=0;user-id=123;"
+        "user-type= :" +
+        user + "!" + user + "@" + user + ".tmi.twitch.tv PRIVMSG #forsen :" + message + "\r\n";
+  }
+  return log;
+}
+
+int main(int argc, char** argv) {
+  size_t mebibytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 32;
+
+  auto log = makeLog(mebibytes << 20);
+
+  std::mt19937 rng{1};
+  std::vector<std::string_view> chunks;
+  for (size_t offset = 0; offset < log.size();) {
+    size_t length = std::min<size_t>(log.size() - offset, rng() % 65536 + 1);
+    chunks.emplace_back(log.data() + offset, length);
+    offset += length;
+  }
+
+  std::printf("log %zu bytes in %zu chunks\n", log.size(), chunks.size());
+
+  auto bench = [&](const char* name, auto&& fn) {
+    double best = 1e9;
+    size_t count = 0;
+    for (int i = 0; i < 5; i++) {
+      auto start = std::chrono::steady_clock::now();
+      count = fn();
+      best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::printf("%-24s %8.1f ms %8.0f MB/s lines=%zu\n", name, best, log.size() / best / 1e3, count);
+  };
+
+  // the loop the bot used before, it also passes both pieces of a line that is split across chunks
+  bench("stringstream + getline", [&]() {
+    std::stringstream stream;
+    size_t count = 0;
+    for (auto chunk : chunks) {
+      stream << chunk;
+
+      std::string line;
+      while (std::getline(stream, line)) {
+        if (line.ends_with('\r')) {
+          line.resize(line.size() - 1);
+        }
+        count += 1;
+      }
+
+      if (stream.eof()) {
+        stream.clear();
+        stream.str({});
+      }
+    }
+    return count;
+  });
+
+  bench("line_splitter", [&]() {
+    uv::line_splitter lines;
+    size_t count = 0;
+    for (auto chunk : chunks) {
+      lines.feed(chunk, [&](std::string_view) {
+        count += 1;
+      });
+    }
+    return count;
+  });
+
+  return 0;
+}
@@ -0,0 +1,66 @@
+#include "uv.hpp"
+#include "cppcoro/async_manual_reset_event.hpp"
+#include <cstdio>
+#include <cstdlib>
+
+// one byte ping-pong over loopback where every write is co_awaited, so the round trip time is mostly the cost of
+// resuming awaiters from libuv callbacks.
+// usage: bench_uv_pingpong [round trips] [port]
+
+static uv::tcp server;
+static uv::tcp client;
+
+int main(int argc, char** argv) {
+  static int round_trips = argc > 1 ? std::atoi(argv[1]) : 50000;
+  static const char* port = argc > 2 ? argv[2] : "18084";
+
+  server.bind4("127.0.0.1", std::atoi(port));
+  server.listen([](auto) {
+    auto peer = new uv::tcp();
+    server.accept(*peer, [](auto) {});
+    peer->readStart([peer](auto chunk, auto error) {
+      if (error) {
+        peer->close([peer]() {
+          delete peer;
+        });
+        return;
+      }
+
+      task<>::run([peer, length = chunk.size()]() -> task<void> {
+        co_await peer->write(std::string(length, 'p'));
+      });
+    });
+  });
+
+  task<>::run([]() -> task<void> {
+    static cppcoro::async_manual_reset_event connected;
+    static cppcoro::async_manual_reset_event pong;
+
+    client.connect("127.0.0.1", port, [](auto) {
+      connected.set();
+    });
+    co_await connected;
+
+    client.readStart([](auto, auto) {
+      pong.set();
+    });
+
+    int warmup = round_trips / 50;
+    uint64_t start = 0;
+    for (int i = 0; i < round_trips; i++) {
+      if (i == warmup) {
+        start = uv_hrtime();
+      }
+
+      pong.reset();
+      co_await client.write(std::string_view{"x"});
+      co_await pong;
+    }
+
+    double average = (uv_hrtime() - start) / 1e3 / (round_trips - warmup);
+    std::printf("round trips=%d avg rtt=%.2fus\n", round_trips - warmup, average);
+    std::exit(0);
+  });
+
+  uv::run();
+}
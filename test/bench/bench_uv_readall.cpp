@@ -0,0 +1,75 @@
+#include "uv.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+// reads many files at once, once with a 64 KiB read loop per file (the previous readAll) and once with uv::fs::readAll,
+// which presizes the result from stat() and reads each file with a single request.
+// set UV_USE_IO_URING=1 to compare the io_uring backend of libuv >= 1.48 with the threadpool.
+// usage: bench_uv_readall [files] [KiB per file]
+
+static task<std::string> chunkedReadAll(std::string path) {
+  auto file = co_await uv::fs::open(path, O_RDONLY, 0);
+
+  std::string result;
+  char buffer[65536];
+  while (true) {
+    auto chunk = co_await uv::fs::read(file, buffer, sizeof(buffer), result.length());
+    if (chunk.length() == 0) {
+      break;
+    }
+
+    result += chunk;
+  }
+
+  co_return result;
+}
+
+int main(int argc, char** argv) {
+  size_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 500;
+  size_t kibibytes = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 256;
+
+  auto directory = std::filesystem::temp_directory_path() / "cpptest-bench-readall";
+  std::filesystem::create_directories(directory);
+
+  std::vector<std::string> paths;
+  std::string content(kibibytes << 10, 'x');
+  for (size_t i = 0; i < count; i++) {
+    paths.push_back((directory / std::to_string(i)).string());
+    std::ofstream{paths.back(), std::ios::binary} << content;
+  }
+
+  for (int round = 0; round < 3; round++) {
+    double chunked = 0;
+    double whole = 0;
+    bool ok = true;
+
+    [](std::vector<std::string>& paths, size_t length, double& chunked, double& whole, bool& ok) -> task<void> {
+      auto t0 = std::chrono::steady_clock::now();
+      std::vector<task<std::string>> reads;
+      for (auto& path : paths) {
+        reads.push_back(chunkedReadAll(path));
+      }
+      auto a = co_await taskpp::when_all(std::move(reads));
+
+      auto t1 = std::chrono::steady_clock::now();
+      auto b = co_await uv::fs::readAll(paths);
+
+      auto t2 = std::chrono::steady_clock::now();
+      chunked = std::chrono::duration<double, std::milli>(t1 - t0).count();
+      whole = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+      for (size_t i = 0; i < paths.size(); i++) {
+        ok = ok && a[i].length() == length && a[i] == b[i];
+      }
+    }(paths, content.length(), chunked, whole, ok).start();
+
+    uv::run();
+    std::printf("%zu files of %zu KiB: chunked %.1f ms, readAll %.1f ms, ok=%d\n", count, kibibytes, chunked, whole, ok);
+  }
+
+  std::filesystem::remove_all(directory);
+  return 0;
+}
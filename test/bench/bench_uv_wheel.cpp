@@ -0,0 +1,79 @@
+#include "uv.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// idle timeouts for many connections: every object is armed with a 30s timeout, re-armed 10 times (activity) and
+// cancelled, once with one uv::timer per object and once with entries on the loop's timer_wheel.
+// usage: bench_uv_wheel [objects]
+
+static double milliseconds(uint64_t nanoseconds) {
+  return nanoseconds / 1e6;
+}
+
+int main(int argc, char** argv) {
+  size_t objects = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+
+  auto loop = uv_default_loop();
+
+  {
+    uint64_t t0 = uv_hrtime();
+    std::vector<uv::timer> timers;
+    timers.reserve(objects);
+    for (size_t i = 0; i < objects; i++) {
+      timers.emplace_back(loop);
+      timers.back().start([]() {}, 30000);
+    }
+
+    uint64_t t1 = uv_hrtime();
+    for (int i = 0; i < 10; i++) {
+      for (auto& timer : timers) {
+        timer.again();
+      }
+    }
+
+    uint64_t t2 = uv_hrtime();
+    for (auto& timer : timers) {
+      timer.stop();
+    }
+    timers.clear();
+    uv_run(loop, UV_RUN_DEFAULT);
+
+    uint64_t t3 = uv_hrtime();
+    std::printf("uv::timer   x%zu: start %.1f ms, 10x rearm %.1f ms, stop+close %.1f ms\n", objects, milliseconds(t1 - t0),
+        milliseconds(t2 - t1), milliseconds(t3 - t2));
+  }
+
+  {
+    auto& wheel = uv::timer_wheel::of(loop);
+
+    uint64_t t0 = uv_hrtime();
+    std::vector<uv::timer_wheel::entry> entries(objects);
+    for (auto& e : entries) {
+      wheel.schedule(e, 30000, []() {});
+    }
+
+    uint64_t t1 = uv_hrtime();
+    for (int i = 0; i < 10; i++) {
+      for (auto& e : entries) {
+        wheel.schedule(e, 30000);
+      }
+    }
+
+    uint64_t t2 = uv_hrtime();
+    for (auto& e : entries) {
+      wheel.cancel(e);
+    }
+    entries.clear();
+    uv_run(loop, UV_RUN_DEFAULT);
+
+    uint64_t t3 = uv_hrtime();
+    std::printf("timer_wheel x%zu: start %.1f ms, 10x rearm %.1f ms, stop+close %.1f ms\n", objects, milliseconds(t1 - t0),
+        milliseconds(t2 - t1), milliseconds(t3 - t2));
+  }
+
+  uv::release(loop);
+  uv_run(loop, UV_RUN_DEFAULT);
+  return uv_loop_close(loop);
+}
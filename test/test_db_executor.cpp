@@ -0,0 +1,102 @@
+#include "catch.hpp"
+#include "db/executor.hpp"
+#include "db/sqlite.hpp"
+#include "uv.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+TEST_CASE("executor requires a resume function", "[db][executor]") {
+  db::sqlite::datasource datasource{":memory:"};
+
+  REQUIRE_THROWS_AS((db::executor{datasource, 1, {}}), std::invalid_argument);
+}
+
+TEST_CASE("executor runs work on its workers and continues on the loop", "[db][executor]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  db::sqlite::datasource datasource{":memory:"};
+
+  std::thread::id loop_thread = std::this_thread::get_id();
+  std::thread::id work_thread;
+  std::thread::id continued_on;
+  int value = 0;
+  bool rethrown = false;
+
+  {
+    uv::resume_queue completions{&loop};
+    db::executor executor{datasource, 2, [&completions](std::coroutine_handle<> waiter) {
+      completions.push(waiter);
+    }};
+
+    [](db::executor& executor, uv::resume_queue& completions, std::thread::id& work_thread,
+        std::thread::id& continued_on, int& value, bool& rethrown) -> task<void> {
+      value = co_await executor.run([&work_thread](db::connection& conn) {
+        work_thread = std::this_thread::get_id();
+        conn.execute("SELECT 1");
+        return 42;
+      });
+      continued_on = std::this_thread::get_id();
+
+      try {
+        co_await executor.run([](db::connection&) {
+          throw std::runtime_error{"query failed"};
+        });
+      } catch (const std::runtime_error&) {
+        rethrown = true;
+      }
+
+      co_await completions.close();
+    }(executor, completions, work_thread, continued_on, value, rethrown).start();
+
+    uv_run(&loop, UV_RUN_DEFAULT);
+  }
+
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(value == 42);
+  REQUIRE(work_thread != loop_thread);
+  REQUIRE(continued_on == loop_thread);
+  REQUIRE(rethrown);
+}
+
+TEST_CASE("executor keeps work with the same affinity on one worker", "[db][executor]") {
+  db::sqlite::datasource datasource{":memory:"};
+
+  std::mutex mutex;
+  std::vector<std::thread::id> pinned;
+  std::atomic<int> shared = 0;
+
+  {
+    db::executor executor{datasource, 4, [](std::coroutine_handle<> waiter) {
+      waiter.resume();
+    }};
+
+    for (int i = 0; i < 50; i++) {
+      executor.post([&](db::connection&) {
+        std::lock_guard lock{mutex};
+        pinned.push_back(std::this_thread::get_id());
+      }, 3);
+
+      executor.post([&](db::connection&) {
+        shared += 1;
+      });
+    }
+
+    // stop() finishes everything that was queued
+    executor.stop();
+
+    auto stats = executor.stats();
+    REQUIRE(stats.completed == 100);
+    REQUIRE(stats.queued == 0);
+    REQUIRE(stats.running == 0);
+
+    REQUIRE_THROWS_AS(executor.post([](db::connection&) {}), db::sql_error);
+  }
+
+  REQUIRE(pinned.size() == 50);
+  REQUIRE(std::count(pinned.begin(), pinned.end(), pinned.front()) == 50);
+  REQUIRE(shared == 50);
+}
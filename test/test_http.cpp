@@ -0,0 +1,83 @@
+#include "catch.hpp"
+#include "http.hpp"
+#include "http/serve.hpp"
+
+using http::serve::detail::matchesETag;
+using http::serve::detail::parseRange;
+
+TEST_CASE("parseRange answers a single range", "[http][serve]") {
+  auto range = parseRange("bytes=0-499", 1000);
+  REQUIRE(range);
+  REQUIRE(range->satisfiable);
+  REQUIRE(range->first == 0);
+  REQUIRE(range->last == 499);
+
+  range = parseRange("bytes=500-", 1000);
+  REQUIRE(range);
+  REQUIRE(range->first == 500);
+  REQUIRE(range->last == 999);
+
+  range = parseRange("bytes=999-999", 1000);
+  REQUIRE(range);
+  REQUIRE(range->first == 999);
+  REQUIRE(range->last == 999);
+}
+
+TEST_CASE("parseRange takes the last bytes for a suffix range", "[http][serve]") {
+  auto range = parseRange("bytes=-200", 1000);
+  REQUIRE(range);
+  REQUIRE(range->first == 800);
+  REQUIRE(range->last == 999);
+
+  // a suffix longer than the file is the whole file
+  range = parseRange("bytes=-2000", 1000);
+  REQUIRE(range);
+  REQUIRE(range->satisfiable);
+  REQUIRE(range->first == 0);
+  REQUIRE(range->last == 999);
+
+  REQUIRE_FALSE(parseRange("bytes=-0", 1000)->satisfiable);
+  REQUIRE_FALSE(parseRange("bytes=-5", 0)->satisfiable);
+}
+
+TEST_CASE("parseRange clamps or refuses ranges past the end of the file", "[http][serve]") {
+  auto range = parseRange("bytes=900-2000", 1000);
+  REQUIRE(range);
+  REQUIRE(range->satisfiable);
+  REQUIRE(range->first == 900);
+  REQUIRE(range->last == 999);
+
+  REQUIRE_FALSE(parseRange("bytes=1000-", 1000)->satisfiable);
+  REQUIRE_FALSE(parseRange("bytes=1000-1001", 1000)->satisfiable);
+  REQUIRE_FALSE(parseRange("bytes=0-", 0)->satisfiable);
+}
+
+TEST_CASE("parseRange ignores multiple and malformed ranges", "[http][serve]") {
+  // answered with the whole file
+  REQUIRE_FALSE(parseRange("bytes=0-1,5-6", 1000));
+  REQUIRE_FALSE(parseRange("bytes=0-1, -5", 1000));
+
+  REQUIRE_FALSE(parseRange("bytes=5-1", 1000));
+  REQUIRE_FALSE(parseRange("bytes=5", 1000));
+  REQUIRE_FALSE(parseRange("bytes=-", 1000));
+  REQUIRE_FALSE(parseRange("bytes=a-b", 1000));
+  REQUIRE_FALSE(parseRange("bytes= 0-1", 1000));
+  REQUIRE_FALSE(parseRange("bytes=-1-2", 1000));
+  REQUIRE_FALSE(parseRange("bytes=99999999999999999999-", 1000));
+  REQUIRE_FALSE(parseRange("items=0-1", 1000));
+  REQUIRE_FALSE(parseRange("", 1000));
+}
+
+TEST_CASE("matchesETag compares every tag of If-None-Match weakly", "[http][serve]") {
+  REQUIRE(matchesETag("\"abc\"", "\"abc\""));
+  REQUIRE(matchesETag("W/\"abc\"", "\"abc\""));
+  REQUIRE(matchesETag("\"x\", W/\"abc\"", "\"abc\""));
+  REQUIRE(matchesETag("  \"x\" ,\"abc\"  ", "\"abc\""));
+  REQUIRE(matchesETag("*", "\"abc\""));
+
+  REQUIRE_FALSE(matchesETag("\"abcd\"", "\"abc\""));
+  REQUIRE_FALSE(matchesETag("abc", "\"abc\""));
+  REQUIRE_FALSE(matchesETag("W/", "\"abc\""));
+  REQUIRE_FALSE(matchesETag("\"x\", \"y\"", "\"abc\""));
+  REQUIRE_FALSE(matchesETag("", "\"abc\""));
+}
@@ -0,0 +1,555 @@
+#include "catch.hpp"
+#include "http.hpp"
+#include "http/serve.hpp"
+#include "uv.hpp"
+#include <deque>
+
+namespace {
+constexpr std::string_view pipelined = "GET /a HTTP/1.1\r\nhost: localhost\r\n\r\n"
+                                       "POST /b HTTP/1.1\r\nhost: localhost\r\ncontent-length: 4\r\n\r\nbody"
+                                       "GET /c HTTP/1.1\r\nhost: localhost\r\n\r\n";
+
+// hands out one chunk per call on a later loop iteration, then ends the body or fails
+task<std::optional<std::string>> nextChunk(uv_loop_t* loop, std::shared_ptr<std::deque<std::string>> chunks, bool fail) {
+  co_await uv::timer_wheel::of(loop).sleep(1);
+
+  if (chunks->empty()) {
+    if (fail) {
+      throw std::runtime_error{"producer failed"};
+    }
+
+    co_return std::nullopt;
+  }
+
+  std::string chunk = std::move(chunks->front());
+  chunks->pop_front();
+  co_return std::move(chunk);
+}
+
+http::response::body_producer produce(uv_loop_t* loop, std::deque<std::string> chunks, bool fail = false) {
+  auto shared = std::make_shared<std::deque<std::string>>(std::move(chunks));
+  return [loop, shared, fail]() {
+    return nextChunk(loop, shared, fail);
+  };
+}
+
+// sends `request_text` on one connection and returns everything received until the server closed it
+std::string exchange(uv_loop_t& loop, int port, std::string_view request_text, http::serve::handler callback,
+    http::serve::options options = {}) {
+  std::string received;
+
+  uv::tcp server{&loop};
+  server.bind4("127.0.0.1", port);
+  http::serve::listen(server, std::move(callback), options);
+
+  uv::tcp client{&loop};
+  client.connect("127.0.0.1", (short)port, [&](auto error) {
+    if (error) {
+      server.close([]() {});
+      return;
+    }
+
+    client.write(request_text, [](auto) {});
+    client.readStart([&](auto chunk, auto error) {
+      received += chunk;
+
+      if (error) {
+        client.close([]() {});
+        server.close([]() {});
+      }
+    });
+  });
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  return received;
+}
+
+size_t count(std::string_view text, std::string_view part) {
+  size_t result = 0;
+  for (auto i = text.find(part); i != std::string_view::npos; i = text.find(part, i + 1)) {
+    result += 1;
+  }
+
+  return result;
+}
+} // namespace
+
+TEST_CASE("http1 parser hands out pipelined requests one at a time", "[http][http1]") {
+  http::_1::parser<http::request> parser;
+  parser.execute(pipelined);
+
+  REQUIRE(parser);
+  REQUIRE(parser.result().url.path() == "/a");
+  REQUIRE(parser.pending() > 0);
+
+  parser.next();
+  REQUIRE(parser);
+  REQUIRE(parser.result().method == http::POST);
+  REQUIRE(parser.result().url.path() == "/b");
+  REQUIRE(parser.result().body == "body");
+
+  parser.next();
+  REQUIRE(parser);
+  REQUIRE(parser.result().url.path() == "/c");
+  REQUIRE(parser.result().body.empty());
+  REQUIRE(parser.pending() == 0);
+
+  parser.next();
+  REQUIRE_FALSE(parser);
+}
+
+TEST_CASE("http1 parser handles pipelined requests split at any byte", "[http][http1]") {
+  http::_1::parser<http::request> parser;
+
+  std::vector<std::string> paths;
+  for (char c : pipelined) {
+    parser.execute({&c, 1});
+
+    while (parser) {
+      paths.emplace_back(parser.result().url.path());
+      parser.next();
+    }
+  }
+
+  REQUIRE(paths == std::vector<std::string>{"/a", "/b", "/c"});
+}
+
+TEST_CASE("http1 parser keeps complete requests when the connection closes", "[http][http1]") {
+  http::_1::parser<http::request> parser;
+  parser.execute(pipelined.substr(0, pipelined.find("GET /c") + 3));
+  parser.close();
+
+  REQUIRE(parser);
+  REQUIRE(parser.result().url.path() == "/a");
+
+  parser.next();
+  REQUIRE(parser);
+  REQUIRE(parser.result().url.path() == "/b");
+
+  // the incomplete third request is dropped
+  parser.next();
+  REQUIRE_FALSE(parser);
+}
+
+TEST_CASE("serve answers pipelined requests in order", "[http][http1]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  std::string received;
+
+  {
+    uv::tcp server{&loop};
+    server.bind4("127.0.0.1", 18121);
+    http::serve::listen(server, [&loop](http::request& request, http::response& response) -> task<void> {
+      // the first response is the slowest, it still has to be sent first
+      if (request.url.path() == "/a") {
+        co_await uv::timer_wheel::of(&loop).sleep(20);
+      }
+
+      response.status = http::OK;
+      response.body = std::string{request.url.path()} + ":" + request.body;
+      http::serve::normalize(response);
+    });
+
+    uv::tcp client{&loop};
+    client.connect("127.0.0.1", (short)18121, [&](auto error) {
+      if (error) {
+        server.close([]() {});
+        return;
+      }
+
+      client.write(pipelined, [](auto) {});
+      client.readStart([&](auto chunk, auto error) {
+        received += chunk;
+
+        if (error || received.find("/c:") != std::string::npos) {
+          client.close([]() {});
+          server.close([]() {});
+        }
+      });
+    });
+
+    uv_run(&loop, UV_RUN_DEFAULT);
+  }
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  auto a = received.find("/a:");
+  auto b = received.find("/b:body");
+  auto c = received.find("/c:");
+  REQUIRE(a != std::string::npos);
+  REQUIRE(b != std::string::npos);
+  REQUIRE(c != std::string::npos);
+  REQUIRE(a < b);
+  REQUIRE(b < c);
+}
+
+TEST_CASE("serve keeps a connection open while a request body arrives slowly", "[http][http1]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  std::string received;
+  bool closed_idle = false;
+
+  {
+    http::serve::options options;
+    options.keep_alive_timeout = 50;
+
+    uv::tcp server{&loop};
+    server.bind4("127.0.0.1", 18122);
+    http::serve::listen(
+        server,
+        [](http::request& request, http::response& response) -> task<void> {
+          response.status = http::OK;
+          response.body = request.body;
+          http::serve::normalize(response);
+          co_return;
+        },
+        options);
+
+    // the rest of the body follows after more than keep_alive_timeout
+    uv::timer_wheel::entry rest;
+    uv::tcp client{&loop};
+    client.connect("127.0.0.1", (short)18122, [&](auto error) {
+      if (error) {
+        server.close([]() {});
+        return;
+      }
+
+      client.write(std::string_view{"POST / HTTP/1.1\r\nhost: localhost\r\ncontent-length: 10\r\n\r\nslow"}, [](auto) {});
+      uv::timer_wheel::of(&loop).schedule(rest, 150, [&]() {
+        client.write(std::string_view{" body"}, [](auto) {});
+        client.write(std::string_view{"!"}, [](auto) {});
+      });
+
+      // the connection is idle once the response was sent, the server closes it after keep_alive_timeout
+      client.readStart([&](auto chunk, auto error) {
+        received += chunk;
+
+        if (error) {
+          closed_idle = error == UV_EOF;
+          client.close([]() {});
+          server.close([]() {});
+        }
+      });
+    });
+
+    uv_run(&loop, UV_RUN_DEFAULT);
+  }
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(received.starts_with("HTTP/1.1 200 OK\r\n"));
+  REQUIRE(received.ends_with("\r\n\r\nslow body!"));
+  REQUIRE(closed_idle);
+}
+
+TEST_CASE("serve sends a produced body chunked", "[http][http1]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  // the second request on the same connection shows the first body ended properly
+  std::string received = exchange(loop, 18123,
+      "GET /a HTTP/1.1\r\nhost: localhost\r\n\r\nGET /b HTTP/1.1\r\nhost: localhost\r\nconnection: close\r\n\r\n",
+      [&loop](http::request& request, http::response& response) -> task<void> {
+        response.status = http::OK;
+        response.producer = produce(&loop, {"ab", "", "cde"});
+        co_return;
+      });
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  // the empty chunk is skipped, it would end the body
+  REQUIRE(count(received, "HTTP/1.1 200 OK\r\n") == 2);
+  REQUIRE(count(received, "transfer-encoding: chunked\r\n") == 2);
+  REQUIRE(count(received, "\r\n\r\n2\r\nab\r\n3\r\ncde\r\n0\r\n\r\n") == 2);
+  REQUIRE(received.ends_with("0\r\n\r\n"));
+}
+
+TEST_CASE("serve ends a produced HTTP/1.0 body with the connection", "[http][http1]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  std::string received = exchange(loop, 18124, "GET / HTTP/1.0\r\n\r\n",
+      [&loop](http::request& request, http::response& response) -> task<void> {
+        response.status = http::OK;
+        response.producer = produce(&loop, {"ab", "cde"});
+        co_return;
+      });
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(received.starts_with("HTTP/1.1 200 OK\r\n"));
+  REQUIRE(received.find("connection: close\r\n") != std::string::npos);
+  REQUIRE(received.find("transfer-encoding") == std::string::npos);
+  REQUIRE(received.ends_with("\r\n\r\nabcde"));
+}
+
+TEST_CASE("serve closes the connection when a producer fails", "[http][http1]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  // the pipelined second request is never answered
+  std::string received = exchange(loop, 18125,
+      "GET /a HTTP/1.1\r\nhost: localhost\r\n\r\nGET /b HTTP/1.1\r\nhost: localhost\r\n\r\n",
+      [&loop](http::request& request, http::response& response) -> task<void> {
+        response.status = http::OK;
+        response.producer = produce(&loop, {"ab", "cde"}, true);
+        co_return;
+      });
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  // without the last chunk the client can tell the body is incomplete
+  REQUIRE(count(received, "HTTP/1.1 200 OK\r\n") == 1);
+  REQUIRE(received.ends_with("\r\n\r\n2\r\nab\r\n3\r\ncde\r\n"));
+}
+
+TEST_CASE("body_stream pauses above the high watermark and resumes at half of it", "[http][http1]") {
+  auto state = std::make_shared<http::body_stream::state>();
+  state->high_watermark = 10;
+
+  std::vector<bool> flow;
+  state->flow = [&flow](bool pause) {
+    flow.push_back(pause);
+  };
+
+  http::body_stream body{state};
+  body.push("12345");
+  body.push("67890");
+  REQUIRE(flow.empty());
+
+  // one byte above the watermark pauses once, more chunks do not pause again
+  body.push("a");
+  body.push("bcdef");
+  REQUIRE(flow == std::vector<bool>{true});
+
+  std::string read;
+  auto consume = [&body, &read]() {
+    body.next([&read](std::optional<std::string> chunk, std::exception_ptr error) {
+      REQUIRE(chunk);
+      read += *chunk;
+    });
+  };
+
+  // 11 and 6 bytes are still above half the watermark
+  consume();
+  consume();
+  REQUIRE(flow == std::vector<bool>{true});
+
+  consume();
+  REQUIRE(flow == std::vector<bool>{true, false});
+
+  consume();
+  REQUIRE(flow == std::vector<bool>{true, false});
+
+  // a reader that waits gets the next chunk directly, it is never buffered
+  std::optional<std::string> waited;
+  body.next([&waited](std::optional<std::string> chunk, std::exception_ptr error) {
+    waited = std::move(chunk);
+  });
+  body.push(std::string(100, 'x'));
+  body.end();
+
+  bool ended = false;
+  body.next([&ended](std::optional<std::string> chunk, std::exception_ptr error) {
+    ended = !chunk && !error;
+  });
+
+  REQUIRE(read == "1234567890abcdef");
+  REQUIRE(waited == std::string(100, 'x'));
+  REQUIRE(flow == std::vector<bool>{true, false});
+  REQUIRE(ended);
+}
+
+TEST_CASE("serve streams a large body to a slow handler through a small watermark", "[http][http1]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  http::serve::options options;
+  options.stream_bodies = true;
+  options.body_high_watermark = 1024;
+
+  std::string body(4 * 1024 * 1024, 0);
+  for (size_t i = 0; i < body.length(); i++) {
+    body[i] = (char)('a' + i % 26);
+  }
+
+  std::string streamed;
+  size_t chunks = 0;
+
+  std::string received = exchange(loop, 18126,
+      "POST / HTTP/1.1\r\nhost: localhost\r\nconnection: close\r\ncontent-length: " + std::to_string(body.length()) +
+          "\r\n\r\n" + body,
+      [&](http::request& request, http::response& response) -> task<void> {
+        // the socket is paused while the handler is not reading
+        co_await uv::timer_wheel::of(&loop).sleep(20);
+
+        while (auto chunk = co_await request.body_stream.next()) {
+          streamed += *chunk;
+          chunks += 1;
+        }
+
+        response.status = http::OK;
+        response.body = std::to_string(streamed.length());
+        http::serve::normalize(response);
+      },
+      options);
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(received.starts_with("HTTP/1.1 200 OK\r\n"));
+  REQUIRE(received.ends_with("\r\n\r\n" + std::to_string(body.length())));
+  REQUIRE(chunks > 1);
+  REQUIRE(streamed == body);
+}
+
+TEST_CASE("serve answers a body above max_body_size with 413 and closes the connection", "[http][http1]") {
+  http::serve::options options;
+  options.max_body_size = 8;
+
+  // a pipelined request after the refused one is never answered
+  std::string declared = "POST / HTTP/1.1\r\nhost: localhost\r\ncontent-length: 16\r\n\r\n0123456789abcdef"
+                         "GET / HTTP/1.1\r\nhost: localhost\r\n\r\n";
+  std::string chunked = "POST / HTTP/1.1\r\nhost: localhost\r\ntransfer-encoding: chunked\r\n\r\n"
+                        "5\r\n01234\r\n5\r\n56789\r\n0\r\n\r\n";
+
+  for (bool stream_bodies : {false, true}) {
+    options.stream_bodies = stream_bodies;
+
+    for (auto [port, request_text] : {std::tuple{18127, declared}, std::tuple{18128, chunked}}) {
+      uv_loop_t loop;
+      uv_loop_init(&loop);
+
+      // the whole request arrives in one read, it is refused before the handler runs
+      size_t handled = 0;
+      std::string received = exchange(loop, port, request_text,
+          [&](http::request& request, http::response& response) -> task<void> {
+            handled += 1;
+            response.status = http::OK;
+            http::serve::normalize(response);
+            co_return;
+          },
+          options);
+
+      uv::release(&loop);
+      uv_run(&loop, UV_RUN_DEFAULT);
+      REQUIRE(uv_loop_close(&loop) == 0);
+
+      REQUIRE(received.starts_with("HTTP/1.1 413 "));
+      REQUIRE(received.find("connection: close\r\n") != std::string::npos);
+      REQUIRE(count(received, "HTTP/1.1 ") == 1);
+      REQUIRE(handled == 0);
+    }
+  }
+}
+
+TEST_CASE("serve fails the body stream of a chunked body that grows above max_body_size", "[http][http1]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  std::string received;
+  std::string read_before;
+  bool read_failed = false;
+
+  {
+    http::serve::options options;
+    options.stream_bodies = true;
+    options.max_body_size = 8;
+
+    uv::tcp server{&loop};
+    server.bind4("127.0.0.1", 18130);
+    http::serve::listen(
+        server,
+        [&](http::request& request, http::response& response) -> task<void> {
+          try {
+            while (auto chunk = co_await request.body_stream.next()) {
+              read_before += *chunk;
+            }
+          } catch (const http::error&) {
+            read_failed = true;
+            throw;
+          }
+
+          response.status = http::OK;
+          http::serve::normalize(response);
+        },
+        options);
+
+    // the handler already runs when the chunk that passes the limit arrives
+    uv::timer_wheel::entry rest;
+    uv::tcp client{&loop};
+    client.connect("127.0.0.1", (short)18130, [&](auto error) {
+      if (error) {
+        server.close([]() {});
+        return;
+      }
+
+      client.write(
+          std::string_view{"POST / HTTP/1.1\r\nhost: localhost\r\ntransfer-encoding: chunked\r\n\r\n5\r\n01234\r\n"},
+          [](auto) {});
+      uv::timer_wheel::of(&loop).schedule(rest, 20, [&]() {
+        client.write(std::string_view{"5\r\n56789\r\n0\r\n\r\n"}, [](auto) {});
+      });
+
+      client.readStart([&](auto chunk, auto error) {
+        received += chunk;
+
+        if (error) {
+          client.close([]() {});
+          server.close([]() {});
+        }
+      });
+    });
+
+    uv_run(&loop, UV_RUN_DEFAULT);
+  }
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(read_before == "01234");
+  REQUIRE(read_failed);
+  REQUIRE(received.starts_with("HTTP/1.1 413 "));
+  REQUIRE(count(received, "HTTP/1.1 ") == 1);
+}
+
+TEST_CASE("serve closes the connection when the handler does not read the body", "[http][http1]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  http::serve::options options;
+  options.stream_bodies = true;
+
+  // the rest of the body never arrives, the server can not tell where the next request would start
+  std::string received = exchange(loop, 18129,
+      "POST /a HTTP/1.1\r\nhost: localhost\r\ncontent-length: 100\r\n\r\nonly the start",
+      [](http::request& request, http::response& response) -> task<void> {
+        response.status = http::OK;
+        response.body = "ignored";
+        http::serve::normalize(response);
+        co_return;
+      },
+      options);
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(count(received, "HTTP/1.1 200 OK\r\n") == 1);
+  REQUIRE(received.find("connection: close\r\n") != std::string::npos);
+  REQUIRE(received.ends_with("\r\n\r\nignored"));
+}
@@ -0,0 +1,542 @@
+#include "catch.hpp"
+#include "http.hpp"
+#include "http/serve.hpp"
+#include "uv.hpp"
+#include <algorithm>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <nghttp2/nghttp2.h>
+
+namespace {
+// HTTP/2 with prior knowledge over plaintext. a bare nghttp2 session instead of http::_2::handler, which has no way to
+// tell a reset stream from a finished one
+struct h2_client {
+  struct stream {
+    int status = 0;
+    std::string body;
+    bool closed = false;
+    uint32_t error_code = 0;
+  };
+
+  uv::tcp& tcp;
+  nghttp2_session* session = nullptr;
+  std::map<int32_t, stream> streams;
+
+  // called after every DATA chunk and once a stream was closed
+  std::function<void(int32_t)> on_update;
+
+  // without `auto_window_update` received DATA is never acknowledged, the server runs out of flow control window
+  h2_client(uv::tcp& t, bool auto_window_update = true) : tcp(t) {
+    nghttp2_session_callbacks* callbacks;
+    nghttp2_session_callbacks_new(&callbacks);
+
+    nghttp2_session_callbacks_set_send_callback(
+        callbacks, [](nghttp2_session*, const uint8_t* data, size_t length, int, void* user_data) {
+          auto client = (h2_client*)user_data;
+          if (!client->tcp.isClosing()) {
+            client->tcp.write(std::string_view{(const char*)data, length}, [](auto) {});
+          }
+
+          return (ssize_t)length;
+        });
+
+    nghttp2_session_callbacks_set_on_header_callback(callbacks,
+        [](nghttp2_session*, const nghttp2_frame* frame, const uint8_t* name, size_t namelen, const uint8_t* value,
+            size_t valuelen, uint8_t, void* user_data) {
+          auto client = (h2_client*)user_data;
+          if (std::string_view{(const char*)name, namelen} == ":status") {
+            client->streams[frame->hd.stream_id].status = std::stoi(std::string{(const char*)value, valuelen});
+          }
+
+          return 0;
+        });
+
+    nghttp2_session_callbacks_set_on_data_chunk_recv_callback(
+        callbacks, [](nghttp2_session*, uint8_t, int32_t stream_id, const uint8_t* data, size_t len, void* user_data) {
+          auto client = (h2_client*)user_data;
+          client->streams[stream_id].body.append((const char*)data, len);
+          if (client->on_update) {
+            client->on_update(stream_id);
+          }
+
+          return 0;
+        });
+
+    nghttp2_session_callbacks_set_on_stream_close_callback(
+        callbacks, [](nghttp2_session*, int32_t stream_id, uint32_t error_code, void* user_data) {
+          auto client = (h2_client*)user_data;
+          auto& stream = client->streams[stream_id];
+          stream.closed = true;
+          stream.error_code = error_code;
+          if (client->on_update) {
+            client->on_update(stream_id);
+          }
+
+          return 0;
+        });
+
+    nghttp2_option* option;
+    nghttp2_option_new(&option);
+    nghttp2_option_set_no_auto_window_update(option, !auto_window_update);
+
+    nghttp2_session_client_new2(&session, callbacks, this, option);
+    nghttp2_session_callbacks_del(callbacks);
+    nghttp2_option_del(option);
+
+    nghttp2_submit_settings(session, NGHTTP2_FLAG_NONE, nullptr, 0);
+  }
+
+  ~h2_client() {
+    nghttp2_session_del(session);
+  }
+
+  int32_t request(std::string_view method, std::string_view path, std::vector<std::pair<std::string, std::string>> headers = {}) {
+    auto nv = [](std::string_view name, std::string_view value) {
+      return nghttp2_nv{(uint8_t*)name.data(), (uint8_t*)value.data(), name.length(), value.length(), NGHTTP2_NV_FLAG_NONE};
+    };
+
+    std::vector<nghttp2_nv> nvs = {nv(":method", method), nv(":scheme", "http"), nv(":authority", "localhost"),
+        nv(":path", path)};
+    for (const auto& [name, value] : headers) {
+      nvs.push_back(nv(name, value));
+    }
+
+    int32_t id = nghttp2_submit_request(session, nullptr, nvs.data(), nvs.size(), nullptr, nullptr);
+    streams[id];
+    nghttp2_session_send(session);
+    return id;
+  }
+
+  void start() {
+    nghttp2_session_send(session);
+
+    tcp.readStart([this](auto chunk, auto error) {
+      if (error) {
+        tcp.close([]() {});
+        return;
+      }
+
+      nghttp2_session_mem_recv(session, (const uint8_t*)chunk.data(), chunk.length());
+      nghttp2_session_send(session);
+    });
+  }
+
+  bool allClosed() const {
+    return std::all_of(streams.begin(), streams.end(), [](const auto& entry) {
+      return entry.second.closed;
+    });
+  }
+};
+
+// serves HTTP/2 without TLS and calls `on_accepted` once accept() returned, after the connection is gone
+void listen(uv::tcp& server, const http::serve::handler& callback, std::function<void()> on_accepted) {
+  server.listen([&server, &callback, on_accepted](auto error) {
+    [](uv::tcp& server, const http::serve::handler& callback, std::function<void()> on_accepted) -> task<void> {
+      uv::tcp client{server.loop()};
+      co_await server.accept(client);
+      co_await http::_2::accept(client, callback);
+      on_accepted();
+    }(server, callback, on_accepted).start();
+  });
+}
+
+// runs `callback` behind accept(), sends the requests of `submit` on one connection and returns the streams once all of
+// them were closed. `accepted` counts the accept() calls that returned
+std::map<int32_t, h2_client::stream> exchange(uv_loop_t& loop, int port, http::serve::handler callback,
+    std::function<void(h2_client&)> submit, size_t& accepted) {
+  std::map<int32_t, h2_client::stream> streams;
+
+  uv::tcp server{&loop};
+  server.bind4("127.0.0.1", port);
+  listen(server, callback, [&]() {
+    accepted += 1;
+    server.close([]() {});
+  });
+
+  uv::tcp tcp{&loop};
+  h2_client client{tcp};
+  client.on_update = [&](int32_t) {
+    if (client.allClosed() && !tcp.isClosing()) {
+      streams = client.streams;
+      tcp.close([]() {});
+    }
+  };
+
+  tcp.connect("127.0.0.1", (short)port, [&](auto error) {
+    if (error) {
+      server.close([]() {});
+      return;
+    }
+
+    submit(client);
+    client.start();
+  });
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  return streams;
+}
+
+// hands out one chunk per call on a later loop iteration, then ends the body or fails
+task<std::optional<std::string>> nextChunk(uv_loop_t* loop, std::shared_ptr<std::deque<std::string>> chunks, bool fail) {
+  co_await uv::timer_wheel::of(loop).sleep(1);
+
+  if (chunks->empty()) {
+    if (fail) {
+      throw std::runtime_error{"producer failed"};
+    }
+
+    co_return std::nullopt;
+  }
+
+  std::string chunk = std::move(chunks->front());
+  chunks->pop_front();
+  co_return std::move(chunk);
+}
+
+// never runs out
+task<std::optional<std::string>> nextChunk(size_t& produced) {
+  produced += 1;
+  co_return std::string(16 * 1024, 'x');
+}
+
+http::response::body_producer produce(uv_loop_t* loop, std::deque<std::string> chunks, bool fail = false) {
+  auto shared = std::make_shared<std::deque<std::string>>(std::move(chunks));
+  return [loop, shared, fail]() {
+    return nextChunk(loop, shared, fail);
+  };
+}
+
+std::string writeTestFile(const char* name, size_t length) {
+  auto path = (std::filesystem::temp_directory_path() / name).string();
+
+  std::string content(length, '\0');
+  for (size_t i = 0; i < length; i++) {
+    content[i] = (char)(i * 7 % 251);
+  }
+  std::ofstream{path, std::ios::binary} << content;
+
+  return path;
+}
+} // namespace
+
+TEST_CASE("http2 sends a file body as DATA frames", "[http][http2]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  // larger than a DATA frame, the initial flow control window and a chunk read from the file
+  auto path = writeTestFile("cpptest-http2-file", 300000);
+  size_t accepted = 0;
+  int32_t whole_id = 0;
+  int32_t range_id = 0;
+  int32_t head_id = 0;
+
+  auto streams = exchange(
+      loop, 18131,
+      [&](http::request& request, http::response& response) -> task<void> {
+        co_await http::serve::file(request, response, path, &loop);
+      },
+      [&](h2_client& client) {
+        whole_id = client.request("GET", "/file");
+        range_id = client.request("GET", "/file", {{"range", "bytes=-10"}});
+        head_id = client.request("HEAD", "/file");
+      },
+      accepted);
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  std::string content;
+  {
+    std::ifstream file{path, std::ios::binary};
+    content.assign(std::istreambuf_iterator<char>{file}, {});
+  }
+  std::filesystem::remove(path);
+
+  REQUIRE(accepted == 1);
+  REQUIRE(streams[whole_id].status == 200);
+  REQUIRE(streams[whole_id].error_code == NGHTTP2_NO_ERROR);
+  REQUIRE(streams[whole_id].body.length() == content.length());
+  REQUIRE(streams[whole_id].body == content);
+
+  REQUIRE(streams[range_id].status == 206);
+  REQUIRE(streams[range_id].body == content.substr(content.length() - 10));
+
+  REQUIRE(streams[head_id].status == 200);
+  REQUIRE(streams[head_id].body.empty());
+}
+
+TEST_CASE("http2 file response outlives neither the connection nor its handler", "[http][http2]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  auto path = writeTestFile("cpptest-http2-file-closed", 4 << 20);
+  size_t accepted = 0;
+  size_t received = 0;
+
+  {
+    http::serve::handler callback = [&](http::request& request, http::response& response) -> task<void> {
+      co_await http::serve::file(request, response, path, &loop);
+    };
+
+    uv::tcp server{&loop};
+    server.bind4("127.0.0.1", 18132);
+    listen(server, callback, [&]() {
+      accepted += 1;
+      server.close([]() {});
+    });
+
+    // goes away in the middle of the body, while the stream waits for a read or for flow control
+    uv::tcp tcp{&loop};
+    h2_client client{tcp};
+    client.on_update = [&](int32_t id) {
+      received = client.streams[id].body.length();
+      if (!tcp.isClosing()) {
+        tcp.close([]() {});
+      }
+    };
+
+    tcp.connect("127.0.0.1", (short)18132, [&](auto error) {
+      if (error) {
+        server.close([]() {});
+        return;
+      }
+
+      client.request("GET", "/file");
+      client.start();
+    });
+
+    uv_run(&loop, UV_RUN_DEFAULT);
+  }
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  std::filesystem::remove(path);
+
+  REQUIRE(accepted == 1);
+  REQUIRE(received > 0);
+  REQUIRE(received < (4 << 20));
+}
+
+TEST_CASE("http2 sends a produced body as deferred DATA frames", "[http][http2]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  // more than the initial flow control window, nghttp2 defers the stream between the chunks and while it waits for
+  // WINDOW_UPDATE
+  std::deque<std::string> chunks;
+  std::string expected;
+  for (char c = 'a'; c < 'a' + 20; c++) {
+    chunks.emplace_back(16 * 1024, c);
+    expected += chunks.back();
+  }
+
+  size_t accepted = 0;
+  int32_t produced_id = 0;
+  int32_t plain_id = 0;
+
+  auto streams = exchange(
+      loop, 18133,
+      [&](http::request& request, http::response& response) -> task<void> {
+        response.status = http::OK;
+        if (request.url.path() == "/produced") {
+          response.producer = produce(&loop, chunks);
+        } else {
+          response.body = "plain";
+          http::serve::normalize(response);
+        }
+        co_return;
+      },
+      [&](h2_client& client) {
+        produced_id = client.request("GET", "/produced");
+        plain_id = client.request("GET", "/plain");
+      },
+      accepted);
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(accepted == 1);
+  REQUIRE(streams[produced_id].status == 200);
+  REQUIRE(streams[produced_id].error_code == NGHTTP2_NO_ERROR);
+  REQUIRE(streams[produced_id].body == expected);
+
+  REQUIRE(streams[plain_id].status == 200);
+  REQUIRE(streams[plain_id].body == "plain");
+}
+
+TEST_CASE("http2 resets only the stream of a failing producer", "[http][http2]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  size_t accepted = 0;
+  int32_t failed_id = 0;
+  int32_t produced_id = 0;
+
+  auto streams = exchange(
+      loop, 18134,
+      [&](http::request& request, http::response& response) -> task<void> {
+        response.status = http::OK;
+        response.producer = produce(&loop, {"ab", "cde"}, request.url.path() == "/fail");
+        co_return;
+      },
+      [&](h2_client& client) {
+        failed_id = client.request("GET", "/fail");
+        produced_id = client.request("GET", "/produced");
+      },
+      accepted);
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(accepted == 1);
+  REQUIRE(streams[failed_id].status == 200);
+  REQUIRE(streams[failed_id].error_code == NGHTTP2_INTERNAL_ERROR);
+  REQUIRE(streams[failed_id].body == "abcde");
+
+  REQUIRE(streams[produced_id].error_code == NGHTTP2_NO_ERROR);
+  REQUIRE(streams[produced_id].body == "abcde");
+}
+
+TEST_CASE("http2 producers waiting for flow control end with the connection", "[http][http2]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  size_t accepted = 0;
+  size_t produced = 0;
+
+  {
+    // never runs out, only the closed connection ends it
+    http::serve::handler callback = [&](http::request& request, http::response& response) -> task<void> {
+      response.status = http::OK;
+      response.producer = [&produced]() {
+        return nextChunk(produced);
+      };
+      co_return;
+    };
+
+    uv::tcp server{&loop};
+    server.bind4("127.0.0.1", 18135);
+    listen(server, callback, [&]() {
+      accepted += 1;
+      server.close([]() {});
+    });
+
+    // acknowledges no DATA, the server runs out of flow control window and waits in writeData until the client is gone
+    uv::tcp tcp{&loop};
+    h2_client client{tcp, false};
+    uv::timer_wheel::entry stop;
+    client.on_update = [&](int32_t) {
+      if (!stop.active() && !tcp.isClosing()) {
+        uv::timer_wheel::of(&loop).schedule(stop, 50, [&]() {
+          tcp.close([]() {});
+        });
+      }
+    };
+
+    tcp.connect("127.0.0.1", (short)18135, [&](auto error) {
+      if (error) {
+        server.close([]() {});
+        return;
+      }
+
+      client.request("GET", "/");
+      client.start();
+    });
+
+    uv_run(&loop, UV_RUN_DEFAULT);
+  }
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  // stopped by the 64 KiB window, not by the closed connection
+  REQUIRE(accepted == 1);
+  REQUIRE(produced > 0);
+  REQUIRE(produced < 8);
+}
+
+TEST_CASE("http2 takes a chunk written before nghttp2 asked for the stream's data", "[http][http2]") {
+  http::_2::handler<http::request> server;
+
+  std::string to_client;
+  server.onSend([&to_client](auto input) {
+    to_client += input;
+  });
+
+  int32_t id = 0;
+  server.onStreamEnd([&id](int32_t stream_id, http::request&&) {
+    id = stream_id;
+  });
+
+  // a client session in memory, it only collects the body and notices the end of the stream
+  struct received_t {
+    std::string body;
+    bool closed = false;
+  } received;
+
+  nghttp2_session_callbacks* callbacks;
+  nghttp2_session_callbacks_new(&callbacks);
+  nghttp2_session_callbacks_set_on_data_chunk_recv_callback(
+      callbacks, [](nghttp2_session*, uint8_t, int32_t, const uint8_t* data, size_t len, void* user_data) {
+        ((received_t*)user_data)->body.append((const char*)data, len);
+        return 0;
+      });
+  nghttp2_session_callbacks_set_on_stream_close_callback(
+      callbacks, [](nghttp2_session*, int32_t, uint32_t, void* user_data) {
+        ((received_t*)user_data)->closed = true;
+        return 0;
+      });
+
+  nghttp2_session* client;
+  nghttp2_session_client_new(&client, callbacks, &received);
+  nghttp2_session_callbacks_del(callbacks);
+
+  auto send = [](nghttp2_session* session) {
+    std::string output;
+    const uint8_t* data;
+    while (auto length = nghttp2_session_mem_send(session, &data)) {
+      output.append((const char*)data, length);
+    }
+
+    return output;
+  };
+
+  nghttp2_submit_settings(client, NGHTTP2_FLAG_NONE, nullptr, 0);
+  std::vector<nghttp2_nv> nvs = {
+      {(uint8_t*)":method", (uint8_t*)"GET", 7, 3, NGHTTP2_NV_FLAG_NONE},
+      {(uint8_t*)":scheme", (uint8_t*)"http", 7, 4, NGHTTP2_NV_FLAG_NONE},
+      {(uint8_t*)":authority", (uint8_t*)"localhost", 10, 9, NGHTTP2_NV_FLAG_NONE},
+      {(uint8_t*)":path", (uint8_t*)"/", 5, 1, NGHTTP2_NV_FLAG_NONE},
+  };
+  nghttp2_submit_request(client, nullptr, nvs.data(), nvs.size(), nullptr, nullptr);
+
+  server.submitSettings();
+  server.execute(send(client));
+  REQUIRE(id != 0);
+
+  // nothing was sent since the response was submitted, so the stream is queued but not deferred yet
+  http::response response;
+  response.status = http::OK;
+  server.submitStreamingResponse(id, response);
+
+  std::optional<bool> written;
+  server.writeData(id, "early", true, [&written](bool result) {
+    written = result;
+  });
+  server.sendSession();
+
+  nghttp2_session_mem_recv(client, (const uint8_t*)to_client.data(), to_client.length());
+  nghttp2_session_del(client);
+
+  REQUIRE(written == true);
+  REQUIRE(received.body == "early");
+  REQUIRE(received.closed);
+}
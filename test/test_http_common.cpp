@@ -0,0 +1,24 @@
+#include "catch.hpp"
+#include "http/common.hpp"
+
+TEST_CASE("http::method converts from and to its names", "[http][method]") {
+#define XX(num, name, string)                                          \
+  REQUIRE((http_method)http::method{std::string_view{#string}} == num); \
+  REQUIRE((http_method)http::method{std::string_view{#name}} == num);   \
+  REQUIRE((std::string_view)http::method{(http_method)num} == #string);
+  HTTP_METHOD_MAP(XX)
+#undef XX
+
+  REQUIRE((std::string_view)http::method{http::GET} == "GET");
+}
+
+TEST_CASE("http::status converts from and to its names", "[http][status]") {
+#define XX(num, name, string)                                           \
+  REQUIRE((http_status)http::status{std::string_view{#name}} == num);   \
+  REQUIRE((std::string_view)http::status{(http_status)num} == #string);
+  HTTP_STATUS_MAP(XX)
+#undef XX
+
+  REQUIRE(http::status{std::string_view{"NOT_A_STATUS"}} == http::UNKNOWN);
+  REQUIRE(((std::string_view)http::status{http::UNKNOWN}).empty());
+}
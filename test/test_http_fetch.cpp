@@ -0,0 +1,100 @@
+#include "catch.hpp"
+#include "http.hpp"
+#include "uv.hpp"
+#include <list>
+
+namespace {
+// accepts connections and reads whatever arrives without ever answering
+struct slow_server {
+  uv::tcp server;
+  std::list<uv::tcp> connections;
+  size_t open = 0;
+  size_t max_open = 0;
+
+  slow_server(uv_loop_t* loop, int port) : server(loop) {
+    server.bind4("127.0.0.1", port);
+    server.listen([this, loop](auto error) {
+      auto& connection = connections.emplace_back(loop);
+      server.accept(connection, [this, &connection](auto error) {
+        open += 1;
+        max_open = std::max(max_open, open);
+
+        connection.readStart([this, &connection](auto, auto error) {
+          if (error) {
+            connection.close([this]() {
+              open -= 1;
+            });
+          }
+        });
+      });
+    });
+  }
+};
+
+task<void> fetchSlowly(uv_loop_t* loop, int port, size_t& cancelled) {
+  uv::tcp tcp{loop};
+  uv::deadline deadline{50, loop};
+
+  http::request request{
+    .url = http::url{"http://127.0.0.1:" + std::to_string(port) + "/"},
+  };
+
+  try {
+    co_await http::fetch(request, tcp, deadline);
+  } catch (const cppcoro::operation_cancelled&) {
+    cancelled += 1;
+  }
+}
+
+task<void> fetchInRounds(uv_loop_t* loop, slow_server& server, int port, size_t rounds, size_t concurrency,
+    size_t& cancelled, std::vector<size_t>& left_open) {
+  for (size_t round = 0; round < rounds; round++) {
+    std::vector<task<void>> fetches;
+    for (size_t i = 0; i < concurrency; i++) {
+      fetches.push_back(fetchSlowly(loop, port, cancelled));
+    }
+    co_await when_all(std::move(fetches));
+
+    // the server notices the aborted connections a few loop iterations later
+    for (int i = 0; i < 1000 && server.open > 0; i++) {
+      co_await uv::timer_wheel::of(loop).sleep(1);
+    }
+    left_open.push_back(server.open);
+  }
+
+  server.server.close([]() {});
+  for (auto& connection : server.connections) {
+    connection.close([]() {});
+  }
+}
+} // namespace
+
+TEST_CASE("fetch against a slow server gives up at the deadline and releases every connection", "[http][fetch]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  constexpr size_t rounds = 4;
+  constexpr size_t concurrency = 32;
+
+  size_t cancelled = 0;
+  std::vector<size_t> left_open;
+  size_t max_open = 0;
+
+  {
+    slow_server server{&loop, 18143};
+
+    fetchInRounds(&loop, server, 18143, rounds, concurrency, cancelled, left_open).start();
+    uv_run(&loop, UV_RUN_DEFAULT);
+
+    max_open = server.max_open;
+  }
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(cancelled == rounds * concurrency);
+  // every round starts from zero, nothing piles up across the rounds
+  REQUIRE(left_open == std::vector<size_t>(rounds, 0));
+  REQUIRE(max_open <= concurrency);
+}
@@ -0,0 +1,89 @@
+#include "catch.hpp"
+#include "http/headers.hpp"
+#include <type_traits>
+
+TEST_CASE("headers look names up case-insensitively", "[http][headers]") {
+  http::headers headers{{"Content-Type", "text/plain"}, {"X-Custom", "1"}};
+
+  REQUIRE(headers.size() == 2);
+  REQUIRE(headers.value("content-type") == "text/plain");
+  REQUIRE(headers.value("CONTENT-TYPE") == "text/plain");
+  REQUIRE(headers.value(http::headers::CONTENT_TYPE) == "text/plain");
+  REQUIRE(headers.value("x-custom") == "1");
+  REQUIRE(headers.count("X-CUSTOM") == 1);
+
+  // names are stored lowercase
+  REQUIRE(headers.begin()->first == "content-type");
+  REQUIRE(headers.find("X-Custom")->first == "x-custom");
+
+  // value() and count() do not insert
+  REQUIRE(headers.value("missing").empty());
+  REQUIRE(headers.count("missing") == 0);
+  REQUIRE(headers.find("missing") == headers.end());
+  REQUIRE(headers.size() == 2);
+}
+
+TEST_CASE("headers keep the insertion order", "[http][headers]") {
+  http::headers headers;
+  headers["Host"] = "localhost";
+  headers["Accept"] = "*/*";
+  headers["Connection"] = "close";
+  headers["host"] = "example.com";
+
+  std::vector<std::string> names;
+  for (const auto& [name, value] : headers) {
+    names.push_back(name);
+  }
+
+  REQUIRE(names == std::vector<std::string>{"host", "accept", "connection"});
+  REQUIRE(headers.value(http::headers::HOST) == "example.com");
+}
+
+TEST_CASE("headers::emplace does not replace", "[http][headers]") {
+  http::headers headers;
+
+  auto [inserted, was_inserted] = headers.emplace("Content-Length", "10");
+  REQUIRE(was_inserted);
+  REQUIRE(inserted->first == "content-length");
+
+  auto [existing, was_replaced] = headers.emplace("content-length", "20");
+  REQUIRE_FALSE(was_replaced);
+  REQUIRE(existing->second == "10");
+  REQUIRE(headers.value(http::headers::CONTENT_LENGTH) == "10");
+}
+
+TEST_CASE("headers::erase keeps the known fields indexed", "[http][headers]") {
+  http::headers headers{{"host", "localhost"}, {"x-a", "a"}, {"connection", "keep-alive"}, {"content-type", "text/html"}};
+
+  REQUIRE(headers.erase("Host") == 1);
+  REQUIRE(headers.erase("host") == 0);
+  REQUIRE(headers.value(http::headers::HOST).empty());
+
+  // the fields behind the erased one moved
+  REQUIRE(headers.value(http::headers::CONNECTION) == "keep-alive");
+  REQUIRE(headers.value(http::headers::CONTENT_TYPE) == "text/html");
+  REQUIRE(headers.value("x-a") == "a");
+
+  headers.clear();
+  REQUIRE(headers.empty());
+  REQUIRE(headers.value(http::headers::CONNECTION).empty());
+}
+
+TEST_CASE("headers::knownOf matches any case", "[http][headers]") {
+  REQUIRE(http::headers::knownOf("Transfer-Encoding") == http::headers::TRANSFER_ENCODING);
+  REQUIRE(http::headers::knownOf("accept-encoding") == http::headers::ACCEPT_ENCODING);
+  REQUIRE(http::headers::knownOf("content-encoding") == http::headers::CONTENT_ENCODING);
+  REQUIRE(http::headers::knownOf("hosT") == http::headers::HOST);
+  REQUIRE(http::headers::knownOf("hose") == http::headers::KNOWN_COUNT);
+  REQUIRE(http::headers::knownOf("") == http::headers::KNOWN_COUNT);
+}
+
+TEST_CASE("headers iterators are read-only", "[http][headers]") {
+  http::headers headers{{"host", "localhost"}};
+
+  static_assert(std::is_const_v<std::remove_reference_t<decltype(*headers.begin())>>);
+  static_assert(std::is_same_v<http::headers::iterator, http::headers::const_iterator>);
+
+  headers["host"] = "example.com";
+  REQUIRE(headers.value("host") == "example.com");
+}
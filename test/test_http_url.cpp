@@ -0,0 +1,126 @@
+#include "catch.hpp"
+#include "db/orm.hpp" // FOR_EACH
+#include "http.hpp"
+#include "http/serve.hpp"
+
+namespace {
+struct search_options {
+  std::optional<std::string> search;
+  std::optional<uint32_t> limit;
+  std::optional<bool> verified = true;
+  uint32_t page;
+};
+} // namespace
+
+HTTP_QUERY_PARAMS_SPECIALIZE(search_options, search, limit, verified, page);
+
+TEST_CASE("url splits a target into its parts", "[http][url]") {
+  http::url url{"https://example.com:8443/a/b?c=d%26e&f#frag"};
+
+  REQUIRE(url.schema() == "https");
+  REQUIRE(url.host() == "example.com");
+  REQUIRE(url.port() == 8443);
+  REQUIRE(url.path() == "/a/b");
+  REQUIRE(url.querystring() == "c=d%26e&f");
+  REQUIRE(url.fragment() == "frag");
+  REQUIRE(url.fullpath() == "/a/b?c=d%26e&f#frag");
+  REQUIRE((std::string)url == "https://example.com:8443/a/b?c=d%26e&f#frag");
+
+  REQUIRE(http::url{"http://example.com/"}.port() == 80);
+  REQUIRE(http::url{"https://example.com/"}.port() == 443);
+}
+
+TEST_CASE("url without a path has the path /", "[http][url]") {
+  http::url url{"http://example.com"};
+
+  REQUIRE(url.host() == "example.com");
+  REQUIRE(url.path() == "/");
+  REQUIRE(url.fullpath() == "/");
+  REQUIRE((std::string)url == "http://example.com/");
+
+  REQUIRE(http::url{"http://example.com?a=1"}.fullpath() == "/?a=1");
+
+  http::request request;
+  request.url = url;
+  REQUIRE(((std::string)request).starts_with("GET / HTTP/1.1\r\n"));
+
+  // CONNECT has the authority as its target
+  request.method = http::CONNECT;
+  request.url = "https://example.com/a?b=c";
+  REQUIRE(((std::string)request).starts_with("CONNECT example.com:443 HTTP/1.1\r\n"));
+}
+
+TEST_CASE("url setters rewrite one part", "[http][url]") {
+  http::url url{"http://example.com/a?b=c"};
+
+  url.path("/d").queryvalue("e", "f g");
+  REQUIRE(url.path() == "/d");
+  REQUIRE(url.queryvalue("b") == "c");
+  REQUIRE(url.queryvalue("e") == "f g");
+  REQUIRE(url.host() == "example.com");
+
+  url.host("localhost");
+  REQUIRE((std::string)url == "http://localhost" + url.fullpath());
+}
+
+TEST_CASE("url decodes query parameters on lookup", "[http][url]") {
+  http::url url{"/search?q=hello%20world&tag=a+b&q2=%E2%9C%93&empty=&flag&q=last", http::url::IN};
+
+  REQUIRE(url.queryvalue("q") == "last");
+  REQUIRE(url.queryvalue("tag") == "a b");
+  REQUIRE(url.queryvalue("q2") == "\xE2\x9C\x93");
+  REQUIRE(url.queryvalue("empty") == "");
+  REQUIRE(url.queryvalue("flag") == "");
+  REQUIRE_FALSE(url.queryvalue("missing"));
+
+  auto query = url.query();
+  REQUIRE(query.size() == 5);
+  REQUIRE(query["q"] == "last");
+}
+
+TEST_CASE("url::queryparse converts whole values only", "[http][url]") {
+  REQUIRE(http::url::queryparse<int>("42") == 42);
+  REQUIRE(http::url::queryparse<int>("-42") == -42);
+  REQUIRE(http::url::queryparse<double>("1.5") == 1.5);
+  REQUIRE(http::url::queryparse<bool>("true") == true);
+  REQUIRE(http::url::queryparse<bool>("0") == false);
+  REQUIRE(http::url::queryparse<std::string>("a%20b") == "a b");
+
+  // "" and "null" are no value
+  REQUIRE_FALSE(http::url::queryparse<int>(""));
+  REQUIRE_FALSE(http::url::queryparse<int>("null"));
+
+  // leading whitespace and one '+' are skipped like by std::stoi, an unencoded '+' is a space
+  REQUIRE(http::url::queryparse<int>("%2B7") == 7);
+  REQUIRE(http::url::queryparse<int>("+7") == 7);
+  REQUIRE(http::url::queryparse<uint32_t>("%20%2B7") == 7u);
+
+  // anything after the number is refused
+  REQUIRE_THROWS_AS(http::url::queryparse<int>("12abc"), std::invalid_argument);
+  REQUIRE_THROWS_AS(http::url::queryparse<int>("1.5"), std::invalid_argument);
+  REQUIRE_THROWS_AS(http::url::queryparse<int>("abc"), std::invalid_argument);
+  REQUIRE_THROWS_AS(http::url::queryparse<int>("%2B%2B7"), std::invalid_argument);
+
+  REQUIRE_THROWS_AS(http::url::queryparse<int>("99999999999"), std::out_of_range);
+  REQUIRE_THROWS_AS(http::url::queryparse<uint32_t>("-1"), std::out_of_range);
+  REQUIRE_THROWS_AS(http::url::queryparse<uint8_t>("256"), std::out_of_range);
+}
+
+TEST_CASE("deserializeQuery assigns the fields of a struct", "[http][url]") {
+  search_options options;
+  http::serve::deserializeQuery(http::url{"/?search=a%20b&limit=20&page=2&unknown=1", http::url::IN}, options);
+
+  REQUIRE(options.search == "a b");
+  REQUIRE(options.limit == 20u);
+  REQUIRE(options.verified == true);
+  REQUIRE(options.page == 2u);
+
+  // parameters without a value leave optional fields as they are
+  http::serve::deserializeQuery(http::url{"/?verified=false&limit=&page=3", http::url::IN}, options);
+  REQUIRE(options.verified == false);
+  REQUIRE(options.limit == 20u);
+  REQUIRE(options.page == 3u);
+
+  search_options missing;
+  REQUIRE_THROWS_AS(http::serve::deserializeQuery(http::url{"/?limit=1", http::url::IN}, missing), std::bad_optional_access);
+}
@@ -0,0 +1,245 @@
+#include "catch.hpp"
+#include "task.hpp"
+#include "cppcoro/cancellation_registration.hpp"
+#include "cppcoro/operation_cancelled.hpp"
+#include <list>
+#include <memory>
+#include <thread>
+
+namespace {
+task<int> one() {
+  co_return 1;
+}
+
+// destroyed with the thread after the frame pool, if the pool was first used after it was constructed
+struct held_until_exit {
+  std::optional<task<int>> held;
+  bool* pool_gone;
+
+  ~held_until_exit() {
+    *pool_gone = taskpp::current_frame_stats().allocations == 0;
+    held.reset();
+  }
+};
+} // namespace
+
+TEST_CASE("task::resolve keeps its value after the argument is gone", "[task]") {
+  auto resolved = []() {
+    std::string value = "kept by value, not by reference";
+    return task<std::string>::resolve(value);
+  }();
+
+  auto unique = []() {
+    auto value = std::make_unique<int>(42);
+    return task<std::unique_ptr<int>>::resolve(value);
+  }();
+
+  REQUIRE(resolved.start_blocking([]() {}) == "kept by value, not by reference");
+  REQUIRE(*unique.start_blocking([]() {}) == 42);
+  REQUIRE_THROWS_AS(task<int>::reject(std::make_exception_ptr(std::out_of_range{"x"})).start_blocking([]() {}),
+      std::out_of_range);
+}
+
+TEST_CASE("task::create settles synchronously, later or from another thread", "[task]") {
+  auto sync = task<int>::create([](auto& resolve, auto&) {
+    resolve(1);
+  });
+  REQUIRE(sync.start_blocking([]() {}) == 1);
+
+  std::function<void()> later;
+  auto deferred = task<int>::create([&later](auto& resolve, auto&) {
+    // the resolver outlives the handler
+    later = [&resolve]() {
+      resolve(2);
+    };
+  });
+  REQUIRE(deferred.start_blocking([&later]() {
+    later();
+  }) == 2);
+
+  std::thread worker;
+  auto threaded = task<int>::create([&worker](auto& resolve, auto&) {
+    worker = std::thread{[&resolve]() {
+      resolve(3);
+    }};
+  });
+  REQUIRE(threaded.start_blocking([&worker]() {
+    worker.join();
+  }) == 3);
+
+  auto thrown = task<int>::create([](auto&, auto&) {
+    throw std::runtime_error{"handler failed"};
+  });
+  REQUIRE_THROWS_AS(thrown.start_blocking([]() {}), std::runtime_error);
+}
+
+#ifndef TASKPP_NO_FRAME_POOL
+TEST_CASE("finished frames are reused by the next task of the same size", "[task]") {
+  auto before = taskpp::current_frame_stats();
+
+  for (int i = 0; i < 100; i++) {
+    REQUIRE(one().start_blocking([]() {}) == 1);
+  }
+
+  auto after = taskpp::current_frame_stats();
+  REQUIRE(after.allocations - before.allocations == 100);
+  REQUIRE(after.deallocations - before.deallocations == 100);
+  REQUIRE(after.pool_hits - before.pool_hits >= 99);
+}
+
+TEST_CASE("a frame freed on another thread goes to that thread's pool", "[task]") {
+  std::optional<task<int>> created;
+  taskpp::frame_stats worker_stats;
+
+  std::thread{[&]() {
+    created.emplace(one());
+    worker_stats = taskpp::current_frame_stats();
+  }}.join();
+
+  REQUIRE(worker_stats.allocations == 1);
+
+  auto before = taskpp::current_frame_stats();
+  REQUIRE(created->start_blocking([]() {}) == 1);
+  created.reset();
+
+  auto freed = taskpp::current_frame_stats();
+  REQUIRE(freed.deallocations - before.deallocations == 1);
+
+  // the next frame of that size comes out of this thread's pool
+  REQUIRE(one().start_blocking([]() {}) == 1);
+  REQUIRE(taskpp::current_frame_stats().pool_hits - freed.pool_hits == 1);
+}
+
+TEST_CASE("a frame freed after the thread's pool is gone goes back to operator delete", "[task]") {
+  bool pool_gone = false;
+
+  std::thread{[&pool_gone]() {
+    static thread_local held_until_exit holder{std::nullopt, &pool_gone};
+    holder.held.emplace(one());
+  }}.join();
+
+  REQUIRE(pool_gone);
+}
+#endif
+
+namespace {
+// a task that finishes with `value` (or fails if it is negative) once `settle` is called, in any order
+task<int> settledLater(std::vector<std::function<void()>>& settle, int value) {
+  return task<int>::create([&settle, value](auto& resolve, auto& reject) {
+    settle.push_back([&resolve, &reject, value]() {
+      if (value < 0) {
+        reject(std::make_exception_ptr(std::runtime_error{std::to_string(value)}));
+      } else {
+        resolve(value);
+      }
+    });
+  });
+}
+
+// a task that never finishes on its own and fails with operation_cancelled once `token` fires
+task<int> cancelledLater(
+    std::list<cppcoro::cancellation_registration>& registrations, cppcoro::cancellation_token token, int& cancelled) {
+  return task<int>::create([&registrations, token, &cancelled](auto&, auto& reject) {
+    registrations.emplace_back(token, [&reject, &cancelled]() {
+      cancelled += 1;
+      reject(std::make_exception_ptr(cppcoro::operation_cancelled{}));
+    });
+  });
+}
+} // namespace
+
+TEST_CASE("when_all returns the results in argument order", "[task]") {
+  std::vector<std::function<void()>> settle;
+
+  std::vector<task<int>> tasks;
+  for (int i = 0; i < 4; i++) {
+    tasks.push_back(settledLater(settle, i));
+  }
+
+  auto all = taskpp::when_all(std::move(tasks));
+  auto results = all.start_blocking([&settle]() {
+    REQUIRE(settle.size() == 4);
+
+    // finishing in reverse does not change the order of the results
+    for (auto it = settle.rbegin(); it != settle.rend(); it++) {
+      (*it)();
+    }
+  });
+
+  REQUIRE(results == std::vector<int>{0, 1, 2, 3});
+
+  settle.clear();
+  auto tuple = taskpp::when_all(settledLater(settle, 7), one(), settledLater(settle, 9));
+  auto [first, second, third] = tuple.start_blocking([&settle]() {
+    settle[1]();
+    settle[0]();
+  });
+
+  REQUIRE(first == 7);
+  REQUIRE(second == 1);
+  REQUIRE(third == 9);
+}
+
+TEST_CASE("when_all rethrows the first failure once every task finished", "[task]") {
+  std::vector<std::function<void()>> settle;
+
+  std::vector<task<int>> tasks;
+  for (int value : {1, -2, 3, -4}) {
+    tasks.push_back(settledLater(settle, value));
+  }
+
+  auto all = taskpp::when_all(std::move(tasks));
+
+  try {
+    all.start_blocking([&]() {
+      // failures in reverse argument order, the last one to finish is still pending
+      settle[3]();
+      settle[1]();
+      settle[0]();
+      REQUIRE_FALSE(all.done());
+
+      settle[2]();
+      REQUIRE(all.done());
+    });
+    FAIL("when_all did not throw");
+  } catch (const std::runtime_error& error) {
+    // the first failure in argument order, not the first one to happen
+    REQUIRE(std::string{error.what()} == "-2");
+  }
+}
+
+TEST_CASE("when_any returns the first task to finish and cancels the losers", "[task]") {
+  std::vector<std::function<void()>> settle;
+  std::list<cppcoro::cancellation_registration> registrations;
+  int cancelled = 0;
+
+  cppcoro::cancellation_source source;
+  auto any = taskpp::when_any(source, cancelledLater(registrations, source.token(), cancelled),
+      settledLater(settle, 42), cancelledLater(registrations, source.token(), cancelled));
+
+  auto [index, value] = any.start_blocking([&]() {
+    settle[0]();
+  });
+
+  REQUIRE(index == 1);
+  REQUIRE(value == 42);
+  REQUIRE(cancelled == 2);
+  REQUIRE(source.is_cancellation_requested());
+}
+
+TEST_CASE("when_any ignores the errors of the losers", "[task]") {
+  std::vector<std::function<void()>> settle;
+
+  auto any = taskpp::when_any(cppcoro::cancellation_source{}, settledLater(settle, -1), settledLater(settle, 5));
+
+  auto [index, value] = any.start_blocking([&]() {
+    settle[1]();
+    REQUIRE_FALSE(any.done());
+
+    // when_any waits for the loser before it resumes
+    settle[0]();
+  });
+
+  REQUIRE(index == 1);
+  REQUIRE(value == 5);
+}
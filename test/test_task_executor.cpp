@@ -0,0 +1,78 @@
+#include "catch.hpp"
+#include "task-executor.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+TEST_CASE("executor resumes spawned tasks on its workers", "[task][executor]") {
+  taskpp::executor executor{4};
+  std::atomic<size_t> ran = 0;
+  std::atomic<size_t> on_worker = 0;
+
+  for (size_t i = 0; i < 10000; i++) {
+    executor.spawn([&]() -> task<void> {
+      if (executor.isWorkerThread()) {
+        on_worker += 1;
+      }
+      ran += 1;
+      co_return;
+    });
+  }
+
+  executor.stop();
+
+  REQUIRE(ran == 10000);
+  REQUIRE(on_worker == 10000);
+  REQUIRE_FALSE(executor.isWorkerThread());
+}
+
+TEST_CASE("executor counts handles posted from many threads", "[task][executor]") {
+  taskpp::executor executor{4};
+  std::atomic<size_t> ran = 0;
+
+  // posting from outside and from the workers at once is where the pending count used to wrap around
+  std::vector<std::thread> posters;
+  for (size_t t = 0; t < 4; t++) {
+    posters.emplace_back([&]() {
+      for (size_t i = 0; i < 5000; i++) {
+        executor.spawn([&]() -> task<void> {
+          executor.spawn([&]() -> task<void> {
+            ran += 1;
+            co_return;
+          });
+          co_return;
+        });
+      }
+    });
+  }
+
+  for (auto& poster : posters) {
+    poster.join();
+  }
+
+  executor.stop();
+
+  REQUIRE(ran == 20000);
+}
+
+TEST_CASE("executor::run continues on a worker", "[task][executor]") {
+  taskpp::executor executor{2};
+
+  auto inner = [](taskpp::executor& executor) -> task<bool> {
+    co_return executor.isWorkerThread();
+  };
+
+  std::atomic<bool> done = false;
+  bool result = false;
+  [](taskpp::executor& executor, task<bool> t, bool& result, std::atomic<bool>& done) -> task<void> {
+    result = co_await executor.run(std::move(t));
+    done = true;
+  }(executor, inner(executor), result, done).start();
+
+  while (!done) {
+    std::this_thread::yield();
+  }
+  executor.stop();
+
+  REQUIRE(result);
+}
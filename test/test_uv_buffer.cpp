@@ -0,0 +1,55 @@
+#include "catch.hpp"
+#include "uvpp/buffer.hpp"
+#include "uvpp/loop.hpp"
+
+TEST_CASE("buffer_pool recycles released buffers", "[uv][buffer]") {
+  uv::buffer_pool pool{1024, 2};
+
+  auto a = pool.acquire(512);
+  auto b = pool.acquire(1024);
+  REQUIRE(pool.stats().misses == 2);
+  REQUIRE(pool.stats().in_use == 2);
+  REQUIRE_THROWS_AS(pool.configure(2048), uv::error);
+
+  auto a_base = a.base;
+  auto b_base = b.base;
+  pool.release(a);
+  pool.release(b);
+  REQUIRE(pool.stats().idle == 2);
+
+  auto c = pool.acquire(1024);
+  REQUIRE(pool.stats().hits == 1);
+  REQUIRE(c.len == 1024);
+  REQUIRE((c.base == a_base || c.base == b_base));
+
+  // larger than the buffer size bypasses the pool in both directions
+  auto big = pool.acquire(4096);
+  REQUIRE(pool.stats().misses == 3);
+  pool.release(big);
+  REQUIRE(pool.stats().idle == 1);
+
+  pool.release(c);
+  REQUIRE(pool.stats().in_use == 0);
+  REQUIRE_NOTHROW(pool.configure(2048));
+  REQUIRE(pool.stats().idle == 0);
+  REQUIRE(pool.bufferSize() == 2048);
+}
+
+TEST_CASE("buffer_pool::of is per loop and dropped by uv::release", "[uv][buffer]") {
+  uv_loop_t loop_a;
+  uv_loop_t loop_b;
+
+  auto& pool_a = uv::buffer_pool::of(&loop_a);
+  REQUIRE(&uv::buffer_pool::of(&loop_a) == &pool_a);
+  REQUIRE(&uv::buffer_pool::of(&loop_b) != &pool_a);
+
+  pool_a.release(pool_a.acquire(16));
+  REQUIRE(uv::buffer_pool::of(&loop_a).stats().misses == 1);
+
+  uv::release(&loop_a);
+  REQUIRE(uv::buffer_pool::of(&loop_a).stats().misses == 0);
+  REQUIRE(uv::buffer_pool::of(&loop_a).stats().idle == 0);
+
+  uv::release(&loop_a);
+  uv::release(&loop_b);
+}
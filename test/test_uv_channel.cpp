@@ -0,0 +1,117 @@
+#include "catch.hpp"
+#include "uv.hpp"
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// the loop of a channel is always spelled out, nothing falls back to the default loop
+static_assert(!std::is_constructible_v<uv::channel<int>, size_t>);
+
+TEST_CASE("channel is a bounded fifo", "[uv][channel]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  {
+    uv::channel<int> channel{5, &loop};
+    REQUIRE(channel.capacity() == 8);
+
+    for (int i = 0; i < 8; i++) {
+      REQUIRE(channel.trySend(i));
+    }
+    REQUIRE_FALSE(channel.trySend(8));
+
+    REQUIRE(channel.tryRecv() == 0);
+    REQUIRE(channel.trySend(8));
+
+    channel.close();
+    REQUIRE(channel.isClosed());
+    REQUIRE_FALSE(channel.trySend(9));
+
+    // values sent before close() are still delivered
+    for (int i = 1; i <= 8; i++) {
+      REQUIRE(channel.tryRecv() == i);
+    }
+    REQUIRE_FALSE(channel.tryRecv());
+  }
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+}
+
+TEST_CASE("channel delivers values from other loops and threads", "[uv][channel]") {
+  static constexpr int loop_producers = 3;
+  static constexpr int values = 20000;
+
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  std::atomic<bool> refused = false;
+  long long sum = 0;
+  long long count = 0;
+  bool closed = false;
+
+  {
+    uv::channel<int> channel{16, &loop};
+    std::atomic<int> finished = 0;
+
+    auto finish = [&]() {
+      if (++finished == loop_producers + 1) {
+        channel.close();
+      }
+    };
+
+    [](uv::channel<int>& channel, long long& sum, long long& count, bool& closed) -> task<void> {
+      while (auto value = co_await channel.recv()) {
+        sum += *value;
+        count += 1;
+      }
+      closed = true;
+    }(channel, sum, count, closed).start();
+
+    std::vector<std::thread> producers;
+    for (int i = 0; i < loop_producers; i++) {
+      // co_await send() parks on the producer's own loop while the channel is full
+      producers.emplace_back([&]() {
+        uv_loop_t producer_loop;
+        uv_loop_init(&producer_loop);
+
+        [](uv::channel<int>& channel, uv_loop_t* producer_loop, std::atomic<bool>& refused,
+            std::function<void()> finish) -> task<void> {
+          for (int i = 1; i <= values; i++) {
+            if (!co_await channel.send(i, producer_loop)) {
+              refused = true;
+            }
+          }
+          finish();
+        }(channel, &producer_loop, refused, finish).start();
+
+        uv_run(&producer_loop, UV_RUN_DEFAULT);
+        uv_loop_close(&producer_loop);
+      });
+    }
+    producers.emplace_back([&]() {
+      for (int i = 1; i <= values; i++) {
+        while (!channel.trySend(i)) {
+          std::this_thread::yield();
+        }
+      }
+      finish();
+    });
+
+    uv_run(&loop, UV_RUN_DEFAULT);
+
+    for (auto& producer : producers) {
+      producer.join();
+    }
+  }
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE_FALSE(refused);
+  REQUIRE(closed);
+  REQUIRE(count == (loop_producers + 1) * values);
+  REQUIRE(sum == (long long)(loop_producers + 1) * values * (values + 1) / 2);
+}
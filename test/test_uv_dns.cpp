@@ -0,0 +1,73 @@
+#include "catch.hpp"
+#include "uv.hpp"
+#include "cppcoro/cancellation_source.hpp"
+
+TEST_CASE("dns cache answers every waiter even if one evicts the name", "[uv][dns]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  std::vector<std::string> answered;
+
+  {
+    // room for one name only, resolving another one evicts the answered entry
+    uv::dns::cache cache{&loop, 30000, 5000, 1};
+
+    cache.resolve("127.0.0.1", "80", [&](auto addr, auto error) {
+      answered.push_back(addr && !error ? "first" : "failed");
+
+      cache.resolve("127.0.0.2", "80", [&](auto addr, auto error) {
+        answered.push_back(addr && !error ? "other" : "failed");
+      });
+    });
+    cache.resolve("127.0.0.1", "80", [&](auto addr, auto error) {
+      answered.push_back(addr && !error ? "second" : "failed");
+    });
+
+    uv_run(&loop, UV_RUN_DEFAULT);
+
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.stats().misses == 2);
+    REQUIRE(cache.stats().coalesced == 1);
+  }
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(answered == std::vector<std::string>{"first", "second", "other"});
+}
+
+TEST_CASE("a cancelled dns waiter leaves the shared lookup to the others", "[uv][dns]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  bool cancelled = false;
+  bool answered = false;
+
+  {
+    uv::dns::cache cache{&loop};
+    cppcoro::cancellation_source source;
+
+    [](uv::dns::cache& cache, cppcoro::cancellation_token token, bool& cancelled) -> task<void> {
+      try {
+        co_await cache.resolve("127.0.0.1", "80", std::move(token));
+      } catch (const cppcoro::operation_cancelled&) {
+        cancelled = true;
+      }
+    }(cache, source.token(), cancelled).start();
+
+    cache.resolve("127.0.0.1", "80", [&](auto addr, auto error) {
+      answered = addr && !error;
+    });
+
+    source.request_cancellation();
+    uv_run(&loop, UV_RUN_DEFAULT);
+  }
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(cancelled);
+  REQUIRE(answered);
+}
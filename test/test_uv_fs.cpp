@@ -0,0 +1,134 @@
+#include "catch.hpp"
+#include "uv.hpp"
+#include <filesystem>
+#include <fstream>
+#include <optional>
+
+namespace {
+std::string writeFile(const std::string& name, size_t length) {
+  auto path = (std::filesystem::temp_directory_path() / name).string();
+
+  std::string content(length, ' ');
+  for (size_t i = 0; i < length; i++) {
+    content[i] = 'a' + (i * 7) % 26;
+  }
+
+  std::ofstream{path, std::ios::binary} << content;
+  return path;
+}
+
+std::string readFile(const std::string& path) {
+  std::ifstream in{path, std::ios::binary};
+  return {std::istreambuf_iterator<char>{in}, {}};
+}
+
+template <typename F>
+void runOn(uv_loop_t* loop, F&& taskfn) {
+  std::exception_ptr error;
+  [](F taskfn, std::exception_ptr& error) -> task<void> {
+    try {
+      co_await taskfn();
+    } catch (...) {
+      error = std::current_exception();
+    }
+  }(std::forward<F>(taskfn), error).start();
+
+  uv_run(loop, UV_RUN_DEFAULT);
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+} // namespace
+
+TEST_CASE("fs::readAll reads whole files", "[uv][fs]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  auto large = writeFile("cpptest-readall-large", 300000);
+  auto small = writeFile("cpptest-readall-small", 100);
+  auto empty = writeFile("cpptest-readall-empty", 0);
+
+  std::string whole;
+  std::string tail;
+  std::string none;
+  // gcc 12 fails on a braced list of strings inside a co_await expression, so the paths are built up front
+  std::vector<std::string> paths{small, large, empty};
+  std::vector<std::string> all;
+  runOn(&loop, [&]() -> task<void> {
+    whole = co_await uv::fs::readAll(large, 0, &loop);
+    tail = co_await uv::fs::readAll(large, 100000, &loop);
+    none = co_await uv::fs::readAll(empty, 0, &loop);
+    all = co_await uv::fs::readAll(paths, &loop);
+  });
+
+  REQUIRE(whole == readFile(large));
+  REQUIRE(tail == readFile(large).substr(100000));
+  REQUIRE(none.empty());
+  REQUIRE(all == std::vector<std::string>{readFile(small), readFile(large), ""});
+
+  std::filesystem::remove(large);
+  std::filesystem::remove(small);
+  std::filesystem::remove(empty);
+
+  REQUIRE(uv_loop_close(&loop) == 0);
+}
+
+TEST_CASE("fs::readAll reads files that report a size of 0", "[uv][fs]") {
+  if (!std::filesystem::exists("/proc/self/status")) {
+    return;
+  }
+
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  // procfs files are generated on read and stat() reports 0 bytes
+  std::string status;
+  runOn(&loop, [&]() -> task<void> {
+    status = co_await uv::fs::readAll("/proc/self/status", 0, &loop);
+  });
+
+  REQUIRE(status.starts_with("Name:"));
+  REQUIRE(status.ends_with('\n'));
+
+  REQUIRE(uv_loop_close(&loop) == 0);
+}
+
+TEST_CASE("fs::readAll throws for missing files", "[uv][fs]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  REQUIRE_THROWS_AS(runOn(&loop,
+                        [&]() -> task<void> {
+                          co_await uv::fs::readAll("/nonexistent/cpptest", 0, &loop);
+                        }),
+      uv::error);
+
+  REQUIRE(uv_loop_close(&loop) == 0);
+}
+
+TEST_CASE("fs::mapFile maps whole files", "[uv][fs]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  auto path = writeFile("cpptest-mapfile", 70000);
+  auto empty = writeFile("cpptest-mapfile-empty", 0);
+
+  std::optional<uv::mapped_file> mapping;
+  std::optional<uv::mapped_file> empty_mapping;
+  runOn(&loop, [&]() -> task<void> {
+    mapping.emplace(co_await uv::fs::mapFile(path, &loop));
+    empty_mapping.emplace(co_await uv::fs::mapFile(empty, &loop));
+  });
+
+  REQUIRE(mapping->view() == readFile(path));
+  REQUIRE(empty_mapping->view().empty());
+
+  auto moved = std::move(*mapping);
+  REQUIRE(moved.size() == 70000);
+  REQUIRE(mapping->size() == 0);
+
+  std::filesystem::remove(path);
+  std::filesystem::remove(empty);
+
+  REQUIRE(uv_loop_close(&loop) == 0);
+}
@@ -0,0 +1,71 @@
+#include "catch.hpp"
+#include "uvpp/lines.hpp"
+#include <random>
+#include <vector>
+
+namespace {
+std::vector<std::string> split(uv::line_splitter& lines, std::vector<std::string> chunks) {
+  std::vector<std::string> result;
+  for (auto& chunk : chunks) {
+    lines.feed(chunk, [&](std::string_view line) {
+      result.emplace_back(line);
+    });
+  }
+  return result;
+}
+} // namespace
+
+TEST_CASE("line_splitter splits on \\n and \\r\\n", "[uv][lines]") {
+  uv::line_splitter lines;
+
+  auto result = split(lines, {"PING :tmi\r\nPONG\n\r\n", "last"});
+  REQUIRE(result == std::vector<std::string>{"PING :tmi", "PONG", ""});
+  REQUIRE(lines.rest() == "last");
+
+  lines.reset();
+  REQUIRE(lines.rest().empty());
+}
+
+TEST_CASE("line_splitter joins lines across chunks", "[uv][lines]") {
+  uv::line_splitter lines;
+
+  // "\r" and "\n" arriving in different chunks still end one line
+  auto result = split(lines, {"ab", "c\r", "\nde", "", "f\n", "\n"});
+  REQUIRE(result == std::vector<std::string>{"abc", "def", ""});
+  REQUIRE(lines.rest().empty());
+}
+
+TEST_CASE("line_splitter matches a whole buffer split for any chunking", "[uv][lines]") {
+  std::mt19937 rng{7};
+
+  for (int i = 0; i < 500; i++) {
+    std::string all;
+    size_t length = rng() % 300;
+    for (size_t j = 0; j < length; j++) {
+      all += "ab\r\n"[rng() % 4];
+    }
+
+    std::vector<std::string> expected;
+    size_t offset = 0;
+    for (size_t newline; (newline = all.find('\n', offset)) != std::string::npos; offset = newline + 1) {
+      auto line = all.substr(offset, newline - offset);
+      if (line.ends_with('\r')) {
+        line.pop_back();
+      }
+      expected.push_back(line);
+    }
+
+    for (size_t max : {1, 2, 3, 7, 64}) {
+      std::vector<std::string> chunks;
+      for (size_t offset = 0; offset < all.size();) {
+        size_t chunk = std::min<size_t>(all.size() - offset, rng() % max + 1);
+        chunks.push_back(all.substr(offset, chunk));
+        offset += chunk;
+      }
+
+      uv::line_splitter lines;
+      REQUIRE(split(lines, chunks) == expected);
+      REQUIRE(lines.rest() == std::string_view{all}.substr(offset));
+    }
+  }
+}
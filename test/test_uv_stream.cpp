@@ -0,0 +1,288 @@
+#include "catch.hpp"
+#include "uv.hpp"
+#include "cppcoro/cancellation_source.hpp"
+#include <array>
+#include <list>
+
+namespace {
+// the queue state is not exposed by the wrapper, but the handle data is
+const uv::stream::data& queueState(uv::tcp& tcp) {
+  return *static_cast<uv::stream::data*>((uv::handle::data*)uv_handle_get_data((uv_handle_t*)(uv_tcp_t*)tcp));
+}
+
+// connects a client to a server on `port`, runs `send` on the client and returns everything the server received
+std::string sendAndReceive(uv_loop_t& loop, int port, std::function<void(uv::tcp&)> send) {
+  std::string received;
+
+  uv::tcp server{&loop};
+  server.bind4("127.0.0.1", port);
+
+  std::optional<uv::tcp> accepted;
+  server.listen([&](auto error) {
+    accepted.emplace(&loop);
+    server.accept(*accepted, [&](auto error) {
+      accepted->readStart([&](auto chunk, auto error) {
+        received += chunk;
+
+        if (error) {
+          accepted->close([]() {});
+          server.close([]() {});
+        }
+      });
+    });
+  });
+
+  uv::tcp client{&loop};
+  client.connect("127.0.0.1", (short)port, [&](auto error) {
+    if (error) {
+      client.close([]() {});
+      server.close([]() {});
+      return;
+    }
+
+    send(client);
+  });
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  return received;
+}
+} // namespace
+
+TEST_CASE("queueWrite sends everything queued in one loop iteration as one write", "[uv][stream]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  std::string expected;
+  size_t queued = 0;
+  size_t writes_after_flush = 0;
+  std::string received;
+
+  {
+    uv::check probe{&loop};
+
+    received = sendAndReceive(loop, 18144, [&](uv::tcp& client) {
+      // libuv runs check handles started later first, so this one runs right after the flush of the queue
+      probe.start([&]() {
+        writes_after_flush = queueState(client).writes_in_flight;
+        REQUIRE(queueState(client).write_queue.empty());
+
+        probe.stop();
+        client.shutdown([&client](auto) {
+          client.close([]() {});
+        });
+      });
+
+      for (int i = 0; i < 100; i++) {
+        std::string chunk = std::to_string(i) + ",";
+        expected += chunk;
+        client.queueWrite(std::move(chunk));
+      }
+      queued = client.writeQueueSize();
+    });
+  }
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(queued == expected.length());
+  REQUIRE(writes_after_flush == 1);
+  REQUIRE(received == expected);
+}
+
+TEST_CASE("plain writes never overtake queued ones", "[uv][stream]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  std::string received = sendAndReceive(loop, 18145, [&](uv::tcp& client) {
+    [](uv::tcp& client) -> task<void> {
+      client.queueWrite(std::string_view{"a"});
+      client.write(std::string_view{"b"}, [](auto) {});
+      client.queueWrite(std::string_view{"c"});
+      co_await client.write(std::string_view{"d"});
+      client.queueWrite(std::string_view{"e"});
+
+      // shutdown waits for the queue as well
+      co_await client.shutdown();
+      client.close([]() {});
+    }(client).start();
+  });
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(received == "abcde");
+}
+
+TEST_CASE("a cancelled drain stops waiting but the queued data is still written", "[uv][stream]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  // more than the socket buffers take at once, the write spans several loop iterations
+  std::string expected(16 * 1024 * 1024, 'x');
+  size_t left_when_cancelled = 0;
+  bool drained = false;
+
+  std::string received = sendAndReceive(loop, 18146, [&](uv::tcp& client) {
+    [](uv::tcp& client, const std::string& expected, size_t& left_when_cancelled, bool& drained) -> task<void> {
+      client.writeWatermarks(0, 1024);
+      REQUIRE_FALSE(client.queueWrite(std::string_view{expected}));
+
+      cppcoro::cancellation_source source;
+      uv::timer_wheel::entry cancel{[&source]() {
+        source.request_cancellation();
+      }};
+      uv::timer_wheel::of(client.loop()).schedule(cancel, 0);
+
+      try {
+        co_await client.drain(source.token());
+      } catch (const cppcoro::operation_cancelled&) {
+        left_when_cancelled = client.writeQueueSize();
+      }
+
+      co_await client.drain();
+      drained = client.writeQueueSize() == 0;
+
+      co_await client.shutdown();
+      client.close([]() {});
+    }(client, expected, left_when_cancelled, drained).start();
+  });
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(left_when_cancelled > 0);
+  REQUIRE(drained);
+  REQUIRE(received.length() == expected.length());
+  REQUIRE(received == expected);
+}
+
+TEST_CASE("line and readAll readers release their state when they stop early", "[uv][stream]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  std::vector<std::string> lines;
+  std::vector<std::string_view::size_type> views;
+  std::string read_all;
+
+  {
+    uv::tcp server{&loop};
+    server.bind4("127.0.0.1", 18147);
+
+    std::list<uv::tcp> accepted;
+    uv::timer_wheel::entry stop;
+    server.listen([&](auto error) {
+      auto& connection = accepted.emplace_back(&loop);
+      server.accept(connection, [&connection](auto error) {
+        // never ends the stream, the readers stop on their own
+        connection.write(std::string_view{"first\nsecond\nthird"}, [](auto) {});
+      });
+    });
+
+    uv::tcp by_line{&loop};
+    by_line.connect("127.0.0.1", (short)18147, [&](auto error) {
+      // close() ends the reader from inside its own callback while the chunk is being split
+      by_line.readLines([&](auto&& line, auto error) {
+        if (error || by_line.isClosing()) {
+          return;
+        }
+
+        lines.push_back(std::move(line));
+        by_line.close([]() {});
+      });
+    });
+
+    uv::tcp by_view{&loop};
+    by_view.connect("127.0.0.1", (short)18147, [&](auto error) {
+      by_view.readLinesAsViews([&](auto line, auto error) {
+        if (error || by_view.isClosing()) {
+          return;
+        }
+
+        views.push_back(line.length());
+
+        // replacing the callback from inside it drops the splitter while its feed() still runs
+        by_view.readStart([](auto, auto) {});
+        by_view.close([]() {});
+      });
+    });
+
+    uv::tcp whole{&loop};
+    whole.connect("127.0.0.1", (short)18147, [&](auto error) {
+      // close() stops reading with UV_EOF, readAll answers with what arrived so far
+      whole.readAll([&](auto&& result, auto error) {
+        read_all = error ? "failed" : result;
+      });
+
+      uv::timer_wheel::of(&loop).schedule(stop, 50, [&]() {
+        whole.close([]() {});
+        server.close([]() {});
+        for (auto& connection : accepted) {
+          connection.close([]() {});
+        }
+      });
+    });
+
+    uv_run(&loop, UV_RUN_DEFAULT);
+  }
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(lines == std::vector<std::string>{"first"});
+  REQUIRE(views == std::vector<std::string_view::size_type>{5});
+  REQUIRE(read_all == "first\nsecond\nthird");
+}
+
+TEST_CASE("scatter-gather writes send every buffer in order", "[uv][stream]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  // larger than the socket buffers, so the write does not finish in one try
+  std::string large(4 * 1024 * 1024, 0);
+  for (size_t i = 0; i < large.length(); i++) {
+    large[i] = (char)('a' + i % 26);
+  }
+
+  std::string received = sendAndReceive(loop, 18148, [&](uv::tcp& client) {
+    [](uv::tcp& client, const std::string& large) -> task<void> {
+      // borrowed buffers, an empty one in between changes nothing
+      std::string head = "head|";
+      std::string tail = "|tail";
+      std::array<uv_buf_t, 4> bufs = {
+          uv_buf_init(head.data(), head.length()),
+          uv_buf_init(nullptr, 0),
+          uv_buf_init((char*)large.data(), large.length()),
+          uv_buf_init(tail.data(), tail.length()),
+      };
+      co_await client.write(std::span<const uv_buf_t>{bufs});
+
+      // chunks owned by the stream, the caller's copies are gone before the write completed
+      {
+        std::vector<std::shared_ptr<const std::string>> chunks;
+        for (std::string_view chunk : {"|one", "|two", "|three"}) {
+          chunks.push_back(std::make_shared<const std::string>(chunk));
+        }
+        client.writev(std::move(chunks), [](auto) {});
+      }
+
+      std::vector<std::shared_ptr<const std::string>> chunks = {
+          std::make_shared<const std::string>("|four"), std::make_shared<const std::string>("|five")};
+      co_await client.writev(std::move(chunks));
+
+      co_await client.shutdown();
+      client.close([]() {});
+    }(client, large).start();
+  });
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  std::string expected = "head|" + large + "|tail|one|two|three|four|five";
+  REQUIRE(received.length() == expected.length());
+  REQUIRE(received == expected);
+}
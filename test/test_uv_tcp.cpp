@@ -0,0 +1,122 @@
+#include "catch.hpp"
+#include "uv.hpp"
+
+namespace {
+// two IPv4 candidates for one connect(), the nodes live on the stack of the test
+struct candidates {
+  sockaddr_in first_addr;
+  sockaddr_in second_addr;
+  ::addrinfo first{};
+  ::addrinfo second{};
+
+  candidates(const char* first_ip, int first_port, const char* second_ip, int second_port) {
+    uv_ip4_addr(first_ip, first_port, &first_addr);
+    uv_ip4_addr(second_ip, second_port, &second_addr);
+
+    for (auto [info, addr] : {std::pair{&first, &first_addr}, std::pair{&second, &second_addr}}) {
+      info->ai_family = AF_INET;
+      info->ai_socktype = SOCK_STREAM;
+      info->ai_addr = (sockaddr*)addr;
+      info->ai_addrlen = sizeof(sockaddr_in);
+    }
+    first.ai_next = &second;
+  }
+
+  uv::dns::addrinfo get() {
+    return uv::dns::addrinfo{&first, [](::addrinfo*) {}};
+  }
+};
+
+// connects to `addr`, sends a line through the echo server on 18141 and returns what came back
+std::string connectAndEcho(uv_loop_t& loop, uv::dns::addrinfo addr) {
+  std::string echoed;
+
+  uv::tcp server{&loop};
+  server.bind4("127.0.0.1", 18141);
+
+  std::optional<uv::tcp> accepted;
+  server.listen([&](auto error) {
+    accepted.emplace(&loop);
+    server.accept(*accepted, [&](auto error) {
+      accepted->readStart([&](auto chunk, auto error) {
+        if (error) {
+          accepted->close([]() {});
+          return;
+        }
+
+        accepted->write(chunk, [](auto) {});
+      });
+    });
+  });
+
+  uv::tcp client{&loop};
+  client.connect(addr, [&](auto error) {
+    if (error) {
+      server.close([]() {});
+      client.close([]() {});
+      return;
+    }
+
+    client.write(std::string_view{"ping\n"}, [](auto) {});
+    client.readStart([&](auto chunk, auto error) {
+      echoed += chunk;
+
+      if (error || echoed.find('\n') != std::string::npos) {
+        client.close([]() {});
+        server.close([]() {});
+      }
+    });
+  });
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  return echoed;
+}
+} // namespace
+
+TEST_CASE("connect moves on right away once a candidate is refused", "[uv][tcp]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  // nothing listens on 18142
+  candidates addr{"127.0.0.1", 18142, "127.0.0.1", 18141};
+  std::string echoed = connectAndEcho(loop, addr.get());
+
+  auto stats = uv::tcp::connectStats(&loop);
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  // the winner's socket is the one the client talks through
+  REQUIRE(echoed == "ping\n");
+  REQUIRE(stats.connects == 1);
+  REQUIRE(stats.failures == 0);
+  REQUIRE(stats.attempts == 2);
+  REQUIRE(stats.connect_time > std::chrono::nanoseconds{0});
+  REQUIRE(stats.max_connect_time == stats.connect_time);
+
+  // well below connection_attempt_delay, the refused attempt started the next one immediately
+  REQUIRE(stats.connect_time < std::chrono::milliseconds{uv::tcp::connection_attempt_delay});
+}
+
+TEST_CASE("connect starts the next candidate while one hangs", "[uv][tcp]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  // TEST-NET-1 is never routed, the attempt either hangs or fails right away depending on the host
+  candidates addr{"192.0.2.1", 18141, "127.0.0.1", 18141};
+  std::string echoed = connectAndEcho(loop, addr.get());
+
+  auto stats = uv::tcp::connectStats(&loop);
+
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(echoed == "ping\n");
+  REQUIRE(stats.connects == 1);
+  REQUIRE(stats.attempts == 2);
+
+  // bound by the attempt delay instead of the system's connect timeout
+  REQUIRE(stats.connect_time < std::chrono::milliseconds{uv::tcp::connection_attempt_delay + 500});
+}
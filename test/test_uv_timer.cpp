@@ -0,0 +1,149 @@
+#include "catch.hpp"
+#include "uv.hpp"
+#include "cppcoro/cancellation_source.hpp"
+
+TEST_CASE("a deadline fails a pending timer with operation_cancelled", "[uv][timer]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  bool cancelled = false;
+  uint64_t waited = 0;
+
+  [](uv_loop_t* loop, bool& cancelled, uint64_t& waited) -> task<void> {
+    // the deadline counts from the cached loop time, measure from the same point
+    uv_update_time(loop);
+    uint64_t start = uv_now(loop);
+
+    uv::timer timer{loop};
+    uv::deadline deadline{20, loop};
+    try {
+      co_await timer.startOnce(60000, deadline);
+    } catch (const cppcoro::operation_cancelled&) {
+      cancelled = true;
+    }
+    waited = uv_now(loop) - start;
+
+    REQUIRE(deadline.expired());
+  }(&loop, cancelled, waited).start();
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(cancelled);
+  REQUIRE(waited >= 20);
+  REQUIRE(waited < 1000);
+}
+
+TEST_CASE("an expired deadline never starts the operation", "[uv][timer]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  bool cancelled = false;
+
+  [](uv_loop_t* loop, bool& cancelled) -> task<void> {
+    uv::timer timer{loop};
+    uv::deadline deadline{60000, loop};
+    deadline.cancel();
+
+    try {
+      co_await timer.startOnce(0, deadline);
+    } catch (const cppcoro::operation_cancelled&) {
+      cancelled = true;
+    }
+
+    REQUIRE_FALSE(timer.isActive());
+  }(&loop, cancelled).start();
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(cancelled);
+}
+
+TEST_CASE("an operation that succeeds despite the cancellation returns its result", "[uv][timer]") {
+  cppcoro::cancellation_source source;
+  std::function<void()> complete;
+  int result = 0;
+
+  [](cppcoro::cancellation_source& source, std::function<void()>& complete, int& result) -> task<void> {
+    result = co_await uv::detail::awaitCallback<int>(
+        [&](auto& awaiter) {
+          complete = [&awaiter]() {
+            awaiter.resolve(42);
+          };
+
+          // the operation can not be aborted anymore
+          awaiter.cancelWith([]() {
+          });
+        },
+        source.token());
+  }(source, complete, result).start();
+
+  source.request_cancellation();
+  complete();
+
+  REQUIRE(result == 42);
+}
+
+TEST_CASE("an operation that fails after the cancellation throws operation_cancelled", "[uv][timer]") {
+  cppcoro::cancellation_source source;
+  std::function<void()> complete;
+  bool cancelled = false;
+
+  [](cppcoro::cancellation_source& source, std::function<void()>& complete, bool& cancelled) -> task<void> {
+    try {
+      co_await uv::detail::awaitCallback(
+          [&](auto& awaiter) {
+            complete = [&awaiter]() {
+              awaiter.reject(uv::error{UV_ECANCELED});
+            };
+
+            awaiter.cancelWith([]() {
+            });
+          },
+          source.token());
+    } catch (const cppcoro::operation_cancelled&) {
+      cancelled = true;
+    }
+  }(source, complete, cancelled).start();
+
+  source.request_cancellation();
+  complete();
+
+  REQUIRE(cancelled);
+}
+
+TEST_CASE("task::race cancels the losers through the shared source", "[uv][timer]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  bool loser_cancelled = false;
+  uint64_t waited = 0;
+
+  [](uv_loop_t* loop, bool& loser_cancelled, uint64_t& waited) -> task<void> {
+    auto loser = [](uv_loop_t* loop, cppcoro::cancellation_token token, bool& loser_cancelled) -> task<void> {
+      try {
+        co_await uv::timer_wheel::of(loop).sleep(60000, std::move(token));
+      } catch (const cppcoro::operation_cancelled&) {
+        loser_cancelled = true;
+      }
+    };
+
+    cppcoro::cancellation_source source;
+    auto token = source.token();
+
+    uv_update_time(loop);
+    uint64_t start = uv_now(loop);
+    co_await task<void>::race(
+        std::move(source), uv::timer_wheel::of(loop).sleep(10), loser(loop, std::move(token), loser_cancelled));
+    waited = uv_now(loop) - start;
+  }(&loop, loser_cancelled, waited).start();
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  uv::release(&loop);
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+
+  REQUIRE(loser_cancelled);
+  REQUIRE(waited < 1000);
+}
@@ -0,0 +1,157 @@
+#include "catch.hpp"
+#include "uv.hpp"
+#include <memory>
+#include <random>
+#include <vector>
+
+TEST_CASE("timer_wheel runs entries once they are due", "[uv][wheel]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  {
+    uv::timer_wheel wheel{&loop};
+
+    std::vector<std::unique_ptr<uv::timer_wheel::entry>> entries;
+    int fired = 0;
+    int early = 0;
+    int cancelled_fired = 0;
+
+    uv_update_time(&loop);
+    uint64_t start = uv_now(&loop);
+
+    // up to 600 ticks, so some entries start on the second level and are cascaded down
+    std::mt19937 rng{1};
+    for (int i = 0; i < 2000; i++) {
+      uint64_t timeout = rng() % 600;
+      bool cancelled = i % 2 == 1;
+
+      entries.push_back(std::make_unique<uv::timer_wheel::entry>());
+      wheel.schedule(*entries.back(), timeout, [&, timeout, cancelled]() {
+        fired += 1;
+        if (cancelled) {
+          cancelled_fired += 1;
+        }
+        if (uv_now(&loop) - start < timeout) {
+          early += 1;
+        }
+      });
+    }
+    REQUIRE(wheel.size() == 2000);
+
+    for (size_t i = 1; i < entries.size(); i += 2) {
+      wheel.cancel(*entries[i]);
+      REQUIRE_FALSE(entries[i]->active());
+    }
+
+    // destroying an entry cancels it
+    {
+      uv::timer_wheel::entry far{[&]() {
+        cancelled_fired += 1;
+      }};
+      wheel.schedule(far, 100000000);
+      REQUIRE(wheel.size() == 1001);
+    }
+    REQUIRE(wheel.size() == 1000);
+
+    // the uv timer is closed once nothing is pending, so the loop exits
+    uv_run(&loop, UV_RUN_DEFAULT);
+
+    REQUIRE(fired == 1000);
+    REQUIRE(early == 0);
+    REQUIRE(cancelled_fired == 0);
+    REQUIRE(wheel.size() == 0);
+  }
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+}
+
+TEST_CASE("timer_wheel reschedules an active entry", "[uv][wheel]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  {
+    uv::timer_wheel wheel{&loop};
+
+    int fired = 0;
+    uv::timer_wheel::entry e{[&]() {
+      fired += 1;
+    }};
+
+    wheel.schedule(e, 1000);
+    wheel.schedule(e, 10);
+    REQUIRE(wheel.size() == 1);
+
+    uv_update_time(&loop);
+    uint64_t start = uv_now(&loop);
+    uv_run(&loop, UV_RUN_DEFAULT);
+
+    REQUIRE(fired == 1);
+    REQUIRE(uv_now(&loop) - start < 1000);
+  }
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+}
+
+TEST_CASE("timer_wheel::sleep resumes after the timeout or on cancellation", "[uv][wheel]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  {
+    uv::timer_wheel wheel{&loop};
+
+    uint64_t slept = 0;
+    bool cancelled = false;
+
+    [](uv::timer_wheel& wheel, uv_loop_t* loop, uint64_t& slept, bool& cancelled) -> task<void> {
+      uv_update_time(loop);
+      uint64_t start = uv_now(loop);
+      co_await wheel.sleep(20);
+      slept = uv_now(loop) - start;
+
+      cppcoro::cancellation_source source;
+      uv::timer_wheel::entry cancel{[&source]() {
+        source.request_cancellation();
+      }};
+      wheel.schedule(cancel, 10);
+
+      try {
+        co_await wheel.sleep(60000, source.token());
+      } catch (const cppcoro::operation_cancelled&) {
+        cancelled = true;
+      }
+    }(wheel, &loop, slept, cancelled).start();
+
+    uv_run(&loop, UV_RUN_DEFAULT);
+
+    REQUIRE(slept >= 20);
+    REQUIRE(cancelled);
+    REQUIRE(wheel.size() == 0);
+  }
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(uv_loop_close(&loop) == 0);
+}
+
+TEST_CASE("timer_wheel::of is dropped by uv::release", "[uv][wheel]") {
+  uv_loop_t loop;
+  uv_loop_init(&loop);
+
+  auto& wheel = uv::timer_wheel::of(&loop);
+  REQUIRE(&uv::timer_wheel::of(&loop) == &wheel);
+
+  int fired = 0;
+  uv::timer_wheel::entry e{[&]() {
+    fired += 1;
+  }};
+  wheel.schedule(e, 10);
+
+  // the pending entry is cancelled without being called
+  uv::release(&loop);
+  REQUIRE_FALSE(e.active());
+
+  uv_run(&loop, UV_RUN_DEFAULT);
+  REQUIRE(fired == 0);
+  REQUIRE(uv_loop_close(&loop) == 0);
+}